@@ -0,0 +1,614 @@
+#include "PCH.h"
+
+#include "Utils.h"
+#include "Shader.h"
+#include "ScreenQuad.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "BuiltinUniforms.h"
+#include "HeadlessContext.h"
+
+namespace {
+
+constexpr std::string_view BENCH_USAGE =
+    "Usage: GLSL_Live_bench [--frames N] [--warmup N] [--sizes WxH,WxH] [--filter NAME] "
+    "[--output results.json] [--baseline baseline.json] [--threshold 0.10] [--file-io]";
+
+constexpr std::string_view CORPUS_DIRECTORY = "shaders/bench";
+constexpr std::string_view VERTEX_PATH      = "shaders/default/default_vertex.glsl";
+
+constexpr int32_t COMPILE_REPETITIONS = 5;     // The fastest compile is reported
+constexpr double  MIN_REGRESSION_MS   = 0.05;  // Smaller slowdowns are treated as noise
+constexpr int32_t NOISE_TEXTURE_SIZE  = 1024;  // Size of iChannel0 of the texture-bound shaders
+
+constexpr std::string_view FILE_IO_DIRECTORY = "cache/file_bench";
+constexpr std::array<size_t, 4> FILE_IO_SIZES = { 1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024 };
+
+using Clock = std::chrono::steady_clock;
+
+double GetElapsedMs(Clock::time_point start_) noexcept
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+}
+
+/**
+ * @brief Settings of the benchmark run, filled from the command line
+ */
+struct BenchOptions {
+    int32_t                                  frame_count  = 200;  /**< Measured frames */
+    int32_t                                  warmup_count = 20;   /**< Frames before measuring */
+    std::vector<std::pair<int32_t, int32_t>> sizes        = { { 1280, 720 }, { 1920, 1080 } };
+    std::string                              filter;              /**< Runs only matching names */
+    std::string                              output_path  = "bench_results.json";
+    std::string                              baseline_path;       /**< Empty if not compared */
+    double                                   threshold    = 0.10; /**< Allowed relative slowdown */
+    bool                                     is_file_io   = false; /**< Only measures file reads */
+};
+
+/**
+ * @brief Distribution of a series of durations in milliseconds
+ */
+struct TimingStats {
+    double avg = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+
+    static TimingStats FromSamples(std::vector<double> samples_)
+    {
+        TimingStats stats;
+        if (samples_.empty()) { return stats; }
+
+        std::sort(samples_.begin(), samples_.end());
+
+        const auto at = [&](double quantile)
+        { return samples_[static_cast<size_t>(quantile * (samples_.size() - 1))]; };
+
+        stats.avg = std::accumulate(samples_.begin(), samples_.end(), 0.0) / samples_.size();
+        stats.p50 = at(0.50);
+        stats.p95 = at(0.95);
+        stats.min = samples_.front();
+        stats.max = samples_.back();
+        return stats;
+    }
+
+    nlohmann::json ToJson() const
+    {
+        return { { "avg", avg }, { "p50", p50 }, { "p95", p95 }, { "min", min }, { "max", max } };
+    }
+};
+
+/**
+ * @brief Measurements of one shader at one resolution
+ */
+struct BenchResult {
+    std::string name;
+    int32_t     width      = 0;
+    int32_t     height     = 0;
+    double      compile_ms = 0.0; /**< Fastest compile of the vertex and fragment shaders */
+    double      link_ms    = 0.0; /**< Fastest link of the program */
+    TimingStats cpu_ms;           /**< CPU time to set the uniforms and submit the draw */
+    TimingStats gpu_ms;           /**< GPU time of the draw (GL_TIME_ELAPSED) */
+    double      frame_ms   = 0.0; /**< Wall time per frame including the GPU work */
+
+    std::string GetKey() const { return fmt::format("{}@{}x{}", name, width, height); }
+};
+
+bool ParseBenchOptions(int argc, char* argv[], BenchOptions& options_) noexcept
+{
+    bool is_valid = true;
+
+    for (int i = 1; i < argc && is_valid; ++i)
+    {
+        const std::string_view argument  = argv[i];
+        const bool             has_value = i + 1 < argc;
+
+        if (argument == "--frames" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%d", &options_.frame_count) == 1;
+        }
+        else if (argument == "--warmup" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%d", &options_.warmup_count) == 1;
+        }
+        else if (argument == "--sizes" && has_value)
+        {
+            options_.sizes.clear();
+
+            std::stringstream sizes(argv[++i]);
+            std::string       size;
+            while (is_valid && std::getline(sizes, size, ','))
+            {
+                int32_t width  = 0;
+                int32_t height = 0;
+                is_valid = std::sscanf(size.c_str(), "%dx%d", &width, &height) == 2 && width > 0
+                        && height > 0;
+                options_.sizes.emplace_back(width, height);
+            }
+        }
+        else if (argument == "--filter" && has_value) { options_.filter = argv[++i]; }
+        else if (argument == "--output" && has_value) { options_.output_path = argv[++i]; }
+        else if (argument == "--baseline" && has_value) { options_.baseline_path = argv[++i]; }
+        else if (argument == "--file-io") { options_.is_file_io = true; }
+        else if (argument == "--threshold" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%lf", &options_.threshold) == 1;
+        }
+        else
+        {
+            LOG_ERROR("Unknown or incomplete argument: {}", argument);
+            is_valid = false;
+        }
+    }
+
+    if (!is_valid || options_.frame_count <= 0 || options_.warmup_count < 0
+        || options_.sizes.empty())
+    {
+        LOG_ERROR("{}", BENCH_USAGE);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads the file the way ReadTextFromFile() did before FileView, the baseline of --file-io
+ */
+std::string ReadWithStreamIterator(std::string_view file_path_)
+{
+    // The application path was resolved again on every read
+    const auto full_path =
+        std::filesystem::canonical(FileUtils::application_path).parent_path().string() + "/"
+        + std::string(file_path_);
+
+    std::ifstream in_file(full_path, std::ios::in | std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in_file)), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Measures the reading of shader-like files of several sizes with the old stream reader
+ * and the read and mapped modes of FileView, no GL context is needed
+ */
+int RunFileReadBench(const BenchOptions& options_)
+{
+    const auto directory = std::filesystem::path(GetApplicationPath()) / FILE_IO_DIRECTORY;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    const std::string_view line = "    color += texture(iChannel0, uv + vec2(0.01 * i)).rgb;\n";
+
+    const std::vector<std::pair<std::string_view, std::function<size_t(std::string_view)>>>
+        readers = {
+            { "stream",
+              [](std::string_view path)
+              {
+                  const auto text = ReadWithStreamIterator(path);
+                  return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+              } },
+            { "view-read",
+              [](std::string_view path)
+              {
+                  const FileView file(path, FileViewMode::READ);
+                  const auto     text = file.GetText();
+                  return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+              } },
+            { "view-map",
+              [](std::string_view path)
+              {
+                  const FileView file(path, FileViewMode::MAP);
+                  const auto     text = file.GetText();
+                  return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+              } },
+        };
+
+    for (const size_t size : FILE_IO_SIZES)
+    {
+        const auto file_path = fmt::format("{}/shader_{}.glsl", FILE_IO_DIRECTORY, size);
+
+        std::string text;
+        while (text.size() + line.size() <= size) { text.append(line); }
+        if (!WriteTextToFile(file_path, text)) { return -1; }
+
+        const size_t line_count = std::count(text.begin(), text.end(), '\n');
+
+        for (const auto& [name, reader] : readers)
+        {
+            for (int32_t i = 0; i < options_.warmup_count; ++i) { reader(file_path); }
+
+            std::vector<double> samples;
+            samples.reserve(options_.frame_count);
+
+            for (int32_t i = 0; i < options_.frame_count; ++i)
+            {
+                const auto start = Clock::now();
+                if (reader(file_path) != line_count)
+                {
+                    LOG_ERROR("{} read a different text from {}", name, file_path);
+                    return -1;
+                }
+                samples.push_back(GetElapsedMs(start));
+            }
+
+            const auto stats = TimingStats::FromSamples(std::move(samples));
+            LOG_INFO("{:>8} KiB {:<10} p50 {:9.2f} us | p95 {:9.2f} us | {:8.1f} MiB/s",
+                     size / 1024,
+                     name,
+                     stats.p50 * 1000.0,
+                     stats.p95 * 1000.0,
+                     size / (1024.0 * 1024.0) / (stats.p50 / 1000.0));
+        }
+    }
+
+    std::filesystem::remove_all(directory, error);
+    return 0;
+}
+
+/**
+ * @brief Creates a mipmapped RGBA8 white noise texture, so fetches miss the texture cache
+ */
+GLuint CreateNoiseTexture() noexcept
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(NOISE_TEXTURE_SIZE) * NOISE_TEXTURE_SIZE * 4);
+
+    std::mt19937 generator(1234);  // Fixed seed, every run fetches the same texels
+    for (auto& pixel : pixels) { pixel = static_cast<uint8_t>(generator() & 0xFF); }
+
+    GLsizei levels = 0;
+    while ((NOISE_TEXTURE_SIZE >> levels) > 0) { ++levels; }
+
+    GLuint texture = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, levels, GL_RGBA8, NOISE_TEXTURE_SIZE, NOISE_TEXTURE_SIZE);
+    glTextureSubImage2D(texture,
+                        0,
+                        0,
+                        0,
+                        NOISE_TEXTURE_SIZE,
+                        NOISE_TEXTURE_SIZE,
+                        GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        pixels.data());
+    glGenerateTextureMipmap(texture);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return texture;
+}
+
+/**
+ * @brief Compiles and links the shaders several times and keeps the fastest times
+ *
+ * @remark Every repetition gets a unique comment, so driver shader caches cannot skip the work
+ */
+bool BuildProgram(std::string_view   vertex_code_,
+                  std::string_view   fragment_code_,
+                  const std::string& name_,
+                  BenchResult&       result_,
+                  ShaderProgram&     shader_program_) noexcept
+{
+    const int32_t glsl_version = GetSupportedGLSLVersion();
+    const auto    run_salt     = Clock::now().time_since_epoch().count();
+
+    result_.compile_ms = std::numeric_limits<double>::max();
+    result_.link_ms    = std::numeric_limits<double>::max();
+
+    for (int32_t repetition = 0; repetition < COMPILE_REPETITIONS; ++repetition)
+    {
+        const auto salt = fmt::format("\n// glsl_live_bench {} {}\n", run_salt, repetition);
+
+        const auto vertex_source   = LimitGLSLVersion(vertex_code_, glsl_version) + salt;
+        const auto fragment_source = LimitGLSLVersion(fragment_code_, glsl_version) + salt;
+
+        Shader vertex_shader;
+        Shader fragment_shader;
+
+        const auto compile_start = Clock::now();
+        vertex_shader.CompileFromSource(vertex_source, ShaderType::VERTEX);
+        fragment_shader.CompileFromSource(fragment_source, ShaderType::FRAGMENT);
+        const double compile_ms = GetElapsedMs(compile_start);
+
+        if (!vertex_shader.IsGood() || !fragment_shader.IsGood())
+        {
+            LOG_ERROR("Failed to compile {}: {}{}",
+                      name_,
+                      vertex_shader.GetCompilationError(),
+                      fragment_shader.GetCompilationError());
+            return false;
+        }
+
+        const auto    link_start = Clock::now();
+        ShaderProgram shader_program(vertex_shader, fragment_shader);
+        const double  link_ms = GetElapsedMs(link_start);
+
+        if (shader_program.GetID() == 0)
+        {
+            LOG_ERROR("Failed to link {}", name_);
+            return false;
+        }
+
+        result_.compile_ms = std::min(result_.compile_ms, compile_ms);
+        result_.link_ms    = std::min(result_.link_ms, link_ms);
+        shader_program_    = std::move(shader_program);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Renders the program for the warmup and measured frames into an offscreen target
+ */
+void MeasureFrames(const BenchOptions& options_,
+                   ShaderProgram&      shader_program_,
+                   GLuint              noise_texture_,
+                   BenchResult&        result_) noexcept
+{
+    RenderTarget target(result_.width, result_.height);
+    ScreenQuad   screen_quad;
+
+    BuiltinUniformData    builtin_uniforms;
+    BuiltinUniformHandles builtin_uniform_handles;
+    builtin_uniform_handles.Resolve(shader_program_);
+
+    builtin_uniforms.resolution = glm::vec3(result_.width, result_.height, 1.0f);
+    builtin_uniforms.time_delta = 1.0f / 60.0f;
+    builtin_uniforms.frame_rate = 60.0f;
+
+    target.Bind();
+    shader_program_.Use();
+    shader_program_.SetUniform(shader_program_.GetUniformHandle("iChannel0"), 0);
+    glBindTextureUnit(0, noise_texture_);
+
+    const auto draw_frame = [&](int32_t frame)
+    {
+        builtin_uniforms.time  = frame * builtin_uniforms.time_delta;  // Fixed time step
+        builtin_uniforms.frame = frame;
+        builtin_uniform_handles.Apply(shader_program_, builtin_uniforms);
+        screen_quad.Draw();
+    };
+
+    for (int32_t frame = 0; frame < options_.warmup_count; ++frame) { draw_frame(frame); }
+    glFinish();
+
+    // One query per frame, they are read after the run so reading never stalls the pipeline
+    std::vector<GLuint> queries(static_cast<size_t>(options_.frame_count));
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+    std::vector<double> cpu_samples;
+    cpu_samples.reserve(queries.size());
+
+    const auto run_start = Clock::now();
+    for (int32_t frame = 0; frame < options_.frame_count; ++frame)
+    {
+        const auto cpu_start = Clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, queries[frame]);
+        draw_frame(options_.warmup_count + frame);
+        glEndQuery(GL_TIME_ELAPSED);
+        cpu_samples.push_back(GetElapsedMs(cpu_start));
+    }
+    glFinish();
+    result_.frame_ms = GetElapsedMs(run_start) / options_.frame_count;
+
+    std::vector<double> gpu_samples;
+    gpu_samples.reserve(queries.size());
+    for (GLuint query : queries)
+    {
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+        gpu_samples.push_back(static_cast<double>(elapsed_ns) / 1e6);
+    }
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    result_.cpu_ms = TimingStats::FromSamples(std::move(cpu_samples));
+    result_.gpu_ms = TimingStats::FromSamples(std::move(gpu_samples));
+}
+
+nlohmann::json ResultsToJson(const BenchOptions& options_, const std::vector<BenchResult>& results_)
+{
+    nlohmann::json json;
+    json["version"]  = 1;
+    json["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    json["gl"]       = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    json["frames"]   = options_.frame_count;
+    json["warmup"]   = options_.warmup_count;
+
+    auto& entries = json["results"] = nlohmann::json::array();
+    for (const auto& result : results_)
+    {
+        entries.push_back({ { "name", result.name },
+                            { "width", result.width },
+                            { "height", result.height },
+                            { "compile_ms", result.compile_ms },
+                            { "link_ms", result.link_ms },
+                            { "cpu_ms", result.cpu_ms.ToJson() },
+                            { "gpu_ms", result.gpu_ms.ToJson() },
+                            { "frame_ms", result.frame_ms } });
+    }
+
+    return json;
+}
+
+/**
+ * @brief Compares the medians and the build times with the baseline
+ *
+ * @return Number of the regressions above the threshold
+ */
+int32_t CompareWithBaseline(const BenchOptions&             options_,
+                            const std::vector<BenchResult>& results_,
+                            const nlohmann::json&           baseline_)
+{
+    if (baseline_.value("renderer", "") != reinterpret_cast<const char*>(glGetString(GL_RENDERER)))
+    {
+        LOG_WARN("Baseline was recorded on a different renderer: {}",
+                 baseline_.value("renderer", "unknown"));
+    }
+
+    if (!baseline_.contains("results") || !baseline_["results"].is_array())
+    {
+        LOG_WARN("Baseline has no results");
+        return 0;
+    }
+
+    std::unordered_map<std::string, const nlohmann::json*> baseline_entries;
+    for (const auto& entry : baseline_["results"])
+    {
+        baseline_entries[fmt::format("{}@{}x{}",
+                                     entry.value("name", ""),
+                                     entry.value("width", 0),
+                                     entry.value("height", 0))] = &entry;
+    }
+
+    int32_t regressions = 0;
+
+    for (const auto& result : results_)
+    {
+        const auto found = baseline_entries.find(result.GetKey());
+        if (found == baseline_entries.end())
+        {
+            LOG_INFO("{}: not in the baseline", result.GetKey());
+            continue;
+        }
+
+        const auto& entry   = *found->second;
+        const auto  compare = [&](std::string_view metric, double current, double baseline)
+        {
+            const double delta = current - baseline;
+            if (baseline <= 0.0 || delta < MIN_REGRESSION_MS
+                || delta / baseline <= options_.threshold)
+            {
+                return;
+            }
+
+            LOG_ERROR("{}: {} regressed {:.3f} ms -> {:.3f} ms (+{:.1f}%)",
+                      result.GetKey(),
+                      metric,
+                      baseline,
+                      current,
+                      delta / baseline * 100.0);
+            ++regressions;
+        };
+
+        compare("build",
+                result.compile_ms + result.link_ms,
+                entry.value("compile_ms", 0.0) + entry.value("link_ms", 0.0));
+        compare("cpu p50",
+                result.cpu_ms.p50,
+                entry.value("cpu_ms", nlohmann::json::object()).value("p50", 0.0));
+        compare("gpu p50",
+                result.gpu_ms.p50,
+                entry.value("gpu_ms", nlohmann::json::object()).value("p50", 0.0));
+    }
+
+    return regressions;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    FileUtils::application_path = argv[0];
+
+    BenchOptions options;
+    if (!ParseBenchOptions(argc, argv, options)) { return -1; }
+
+    if (options.is_file_io) { return RunFileReadBench(options); }
+
+    HeadlessContext context;
+    if (!context.IsValid()) { return -1; }
+
+    const std::string vertex_code = ReadTextFromFile(VERTEX_PATH);
+    if (vertex_code.empty()) { return -1; }
+
+    // Sorted, so the results are always in the same order
+    auto corpus = GetFilesInDirectory(CORPUS_DIRECTORY, ".glsl");  // Names without the extension
+    std::sort(corpus.begin(), corpus.end());
+
+    const GLuint noise_texture = CreateNoiseTexture();
+
+    std::vector<BenchResult> results;
+    bool                     has_failed = false;
+
+    for (const auto& name : corpus)
+    {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) { continue; }
+
+        const std::string fragment_code =
+            ReadTextFromFile(fmt::format("{}/{}.glsl", CORPUS_DIRECTORY, name));
+
+        for (const auto& [width, height] : options.sizes)
+        {
+            BenchResult result;
+            result.name   = name;
+            result.width  = width;
+            result.height = height;
+
+            ShaderProgram shader_program;
+            if (!BuildProgram(vertex_code, fragment_code, name, result, shader_program))
+            {
+                has_failed = true;
+                break;
+            }
+
+            MeasureFrames(options, shader_program, noise_texture, result);
+
+            LOG_INFO("{:<24} build {:7.3f} ms | cpu p50 {:7.3f} ms | gpu p50 {:8.3f} ms, "
+                     "p95 {:8.3f} ms | frame {:8.3f} ms",
+                     result.GetKey(),
+                     result.compile_ms + result.link_ms,
+                     result.cpu_ms.p50,
+                     result.gpu_ms.p50,
+                     result.gpu_ms.p95,
+                     result.frame_ms);
+
+            results.push_back(std::move(result));
+        }
+    }
+
+    glDeleteTextures(1, &noise_texture);
+
+    const auto json = ResultsToJson(options, results);
+
+    std::ofstream out_file(options.output_path, std::ios::out | std::ios::trunc);
+    out_file << json.dump(2) << '\n';
+    if (!out_file)
+    {
+        LOG_ERROR("Failed to write the results to {}", options.output_path);
+        return -1;
+    }
+    LOG_INFO("Results written to {}", options.output_path);
+
+    if (!options.baseline_path.empty())
+    {
+        std::ifstream baseline_file(options.baseline_path);
+        const auto    baseline = nlohmann::json::parse(baseline_file, nullptr, false);
+        if (baseline.is_discarded())
+        {
+            LOG_ERROR("Failed to read the baseline {}", options.baseline_path);
+            return -1;
+        }
+
+        int32_t regressions = 0;
+        try
+        {
+            regressions = CompareWithBaseline(options, results, baseline);
+        }
+        catch (const nlohmann::json::exception& e)
+        {
+            LOG_ERROR("Invalid baseline {}: {}", options.baseline_path, e.what());
+            return -1;
+        }
+
+        if (regressions > 0)
+        {
+            LOG_ERROR("{} regressions above {:.0f}%", regressions, options.threshold * 100.0);
+            return 1;
+        }
+
+        LOG_INFO("No regressions above {:.0f}%", options.threshold * 100.0);
+    }
+
+    return has_failed ? -1 : 0;
+}
@@ -3,6 +3,20 @@
 #include "Utils.h"
 #include "UIManager.h"
 #include "ShaderManager.h"
+#include "BuiltinUniforms.h"
+#include "ScreenQuad.h"
+#include "RenderGraph.h"
+#include "ResolutionScaler.h"
+#include "ProgressiveRenderer.h"
+#include "FrameExporter.h"
+#include "RenderTarget.h"
+#include "PresentPass.h"
+#include "HeadlessRenderer.h"
+#include "FrameStats.h"
+#include "FramePacer.h"
+#include "LatencyTracker.h"
+#include "MouseInput.h"
+#include "FrameProfiler.h"
 
 void SetupAsyncLogger()
 {
@@ -53,8 +67,8 @@ void SetupAsyncLogger()
 int32_t SCREEN_WIDTH  = 1600;
 int32_t SCREEN_HEIGHT = 1200;
 
-float cursor_x = 0.0f;
-float cursor_y = 0.0f;
+// Filled by the mouse callbacks, applied by the loop once per frame
+MouseInput mouse_input;
 
 bool is_scene_playing = true;
 
@@ -63,10 +77,44 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
+// Cursor position normalized to the window, with the origin at the bottom left like iMouse
+glm::vec2 GetNormalizedCursor(GLFWwindow* window, double xpos, double ypos)
+{
+    int32_t window_width  = 0;
+    int32_t window_height = 0;
+    glfwGetWindowSize(window, &window_width, &window_height);
+
+    if (window_width <= 0 || window_height <= 0) { return glm::vec2(0.0f); }
+
+    return glm::vec2(static_cast<float>(xpos / window_width),
+                     1.0f - static_cast<float>(ypos / window_height));
+}
+
 void MouseCursorCallback(GLFWwindow* window, double xpos, double ypos)
 {
-    cursor_x = static_cast<float>(xpos);
-    cursor_y = static_cast<float>(ypos);
+    mouse_input.PushMove(GetNormalizedCursor(window, xpos, ypos));
+}
+
+void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT) { return; }
+
+    // Clicks on a UI widget are not passed to the shader, a release always is so no drag gets
+    // stuck. WantCaptureMouse is not used, the Editor window covers the whole window even with
+    // the UI hidden
+    const bool is_pressed = action == GLFW_PRESS;
+    if (is_pressed && ImGui::GetCurrentContext()
+        && (ImGui::IsAnyItemHovered() || ImGui::IsAnyItemActive()))
+    {
+        return;
+    }
+    if (!is_pressed && action != GLFW_RELEASE) { return; }
+
+    double xpos = 0.0;
+    double ypos = 0.0;
+    glfwGetCursorPos(window, &xpos, &ypos);
+
+    mouse_input.PushButton(GetNormalizedCursor(window, xpos, ypos), is_pressed);
 }
 
 void HandleInput(GLFWwindow* window, ShaderManager& shader_manager, UIManager& ui_manager)
@@ -78,6 +126,7 @@ void HandleInput(GLFWwindow* window, ShaderManager& shader_manager, UIManager& u
         && glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
     {
         shader_manager.SaveFragmentShaderToPath("shaders/latest_fragment.glsl");
+        shader_manager.SaveBufferShaders();
         glfwSetWindowShouldClose(window, true);
     }
 
@@ -120,6 +169,14 @@ int main(int argc, char* argv[])
 
     LOG_INFO("application_path: {}", FileUtils::application_path);
 
+    if (IsHeadlessRequested(argc, argv))  // Offscreen render without a window and UI
+    {
+        HeadlessOptions headless_options;
+        if (!ParseHeadlessOptions(argc, argv, headless_options)) { return -1; }
+
+        return RunHeadless(headless_options);
+    }
+
 
     glfwSetErrorCallback(
         [](int error, const char* description)
@@ -181,64 +238,65 @@ int main(int argc, char* argv[])
 
         glfwSetCursorPosCallback(window,
                                  MouseCursorCallback);  // Register the mouse cursor callback
+        glfwSetMouseButtonCallback(window,
+                                   MouseButtonCallback);  // Register the mouse button callback
 
 
-        // Define rectangle vertices
-        float vertices[] = {
-            1.f,  1.f,  0.0f,  // Top right
-            1.f,  -1.f, 0.0f,  // Bottom right
-            -1.f, -1.f, 0.0f,  // Bottom left
-            -1.f, 1.f,  0.0f   // Top left
-        };
-        unsigned int indices[] = {
-            0, 1, 3,  // First triangle
-            1, 2, 3   // Second triangle
-        };
+        float           last_frame       = 0.0f;
+        constexpr float FPS_LOG_INTERVAL = 1.0f;  // Log every 1 second
+        float           current_time     = 0.0f;
+        float           delta_time       = 0.0f;
+        float           scene_time       = 0.0f;  // iTime, stands still while paused
 
-        // Generate buffers and arrays
-        unsigned int VBO, VAO, EBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        constexpr double IDLE_WAIT_TIMEOUT  = 0.1;    // Seconds, the longest sleep while paused
+        bool             is_last_frame_idle = false;  // The next delta time includes a sleep
 
-        // Bind the Vertex Array Object
-        glBindVertexArray(VAO);
+        FrameStats frame_stats(FPS_LOG_INTERVAL);  // Fixed memory, nothing is allocated per frame
 
-        // Bind and set vertex buffer(s)
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        FramePacer     frame_pacer;      // Vsync by default, switchable in the Performance tab
+        LatencyTracker latency_tracker;  // Input-to-photon instrumentation, off by default
 
-        // Configure vertex attributes
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+        int32_t frame = 0;
 
-        // Unbind the VAO
-        glBindVertexArray(0);
+        ShaderManager shader_manager;
+        shader_manager.EnableAsyncCompilation(window);  // Editing never waits for the driver
+        shader_manager.EnableHotReload();  // Files saved by external editors are reloaded
 
-        std::vector<float> frame_times;
-        float              last_frame       = 0.0f;
-        constexpr float    FPS_LOG_INTERVAL = 1.0f;  // Log every 1 second
-        float              elapsed_time     = 0.0f;
-        float              current_time     = 0.0f;
-        float              delta_time       = 0.0f;
+        FrameProfiler frame_profiler;  // Enabled only while the frame timing overlay is shown
 
+        ScreenQuad screen_quad;
 
-        glfwSwapInterval(0);  // turn off vsync for now
+        BuiltinUniformData   builtin_uniforms;
+        BuiltinUniformBuffer builtin_uniform_buffer;  // Used when the builtin block is enabled
+        MouseSampleBuffer    mouse_sample_buffer;     // iMouseSamples, also needs the block
 
-        int32_t frame = 0;
+        TextureManager texture_manager("shaders");  // Files bound to the iChannels
+        RenderGraph    render_graph(texture_manager);  // Buffer A to D passes and the image
 
-        ShaderManager shader_manager;
+        ResolutionScaler resolution_scaler;  // Heavy shaders are drawn below the window size
 
-        UIManager ui_manager(window, shader_manager);
+        ProgressiveRenderer progressive_renderer;  // Tiles and sample accumulation
 
-        auto& fragment_shader = shader_manager.GetFragmentShader();
-        auto& vertex_shader   = shader_manager.GetVertexShader();
+        FrameExporter                 frame_exporter;  // Export tab, written on worker threads
+        std::unique_ptr<RenderTarget> export_target;   // Exported frames, only while exporting
+        PresentPass                   export_preview;  // Shows the exported frame in the window
+
+        UIManager ui_manager(window,
+                             shader_manager,
+                             render_graph,
+                             resolution_scaler,
+                             progressive_renderer,
+                             frame_exporter,
+                             frame_pacer,
+                             latency_tracker,
+                             frame_stats,
+                             frame_profiler);
 
         while (!glfwWindowShouldClose(window))  // Render loop
         {
+            frame_pacer.WaitForFrame();  // Only limited frames wait, before the input is read
+
             current_time = static_cast<float>(glfwGetTime());  // Get current time
 
             delta_time =
@@ -246,95 +304,261 @@ int main(int argc, char* argv[])
 
             last_frame = current_time;  // Update previous_time for next frame
 
+            if (is_scene_playing) { scene_time += delta_time; }
+
+            frame_profiler.BeginFrame();  // Does nothing while the overlay is hidden
+
             HandleInput(window, shader_manager, ui_manager);
 
             // Rendering commands
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
 
-            // Main logic
-            if (is_scene_playing)
+            texture_manager.Update();  // Uploads the decoded files, never waits for a decode
+
+            // While paused the frame is drawn again only to average more samples of it
+            const bool is_accumulating =
+                !is_scene_playing && progressive_renderer.IsAccumulationEnabled();
+
+            // Exported frames are drawn offscreen at the export size, also while paused
+            const auto& export_settings = frame_exporter.GetSettings();
+            if (!frame_exporter.IsExporting()) { export_target.reset(); }
+            else if (!export_target || export_target->GetWidth() != export_settings.width
+                     || export_target->GetHeight() != export_settings.height)
             {
-                fragment_shader.CompileFromCurrentCode(ShaderType::FRAGMENT);
+                export_target =
+                    std::make_unique<RenderTarget>(export_settings.width, export_settings.height);
+                if (!export_target->IsValid()) { frame_exporter.Finish(); }
+            }
+
+            const bool is_exporting    = frame_exporter.IsExporting();
+            bool       is_shader_drawn = false;
 
-                if (fragment_shader.IsGood())
+            // Rebuilds the program only if the code changed, otherwise the last good one is used.
+            // Also while paused, so reloaded files and finished compiles are picked up
+            frame_profiler.BeginStage(ProfileStage::SHADER_UPDATE);
+            const bool is_program_replaced = shader_manager.UpdateShaderProgram();
+            frame_profiler.EndStage(ProfileStage::SHADER_UPDATE);
+
+            // Main logic, a paused scene is drawn once more when its program was replaced
+            if (is_scene_playing || is_accumulating || is_exporting || is_program_replaced)
+            {
+                auto& shader_program = shader_manager.GetShaderProgram();
+
+                if (shader_program.GetID() != 0)
                 {
-                    auto& shader_program = shader_manager.GetShaderProgram();
-                    shader_program       = ShaderProgram(vertex_shader, fragment_shader);
-
-                    shader_program.Use();
-                    shader_program.SetUniform("in_resolution",
-                                              glm::vec2(SCREEN_WIDTH, SCREEN_HEIGHT));
-                    shader_program.SetUniform("iTime", (float)current_time);
-                    shader_program.SetUniform("iTimeDelta", (float)delta_time);
-                    shader_program.SetUniform("iFrame", frame);
-
-                    float normalized_x = static_cast<float>(cursor_x) / SCREEN_WIDTH;
-                    float normalized_y = static_cast<float>(cursor_y) / SCREEN_HEIGHT;
-                    shader_program.SetUniform("iMouse",
-                                              glm::vec4(normalized_x, normalized_y, 0.0f, 0.0f));
-
-                    glBindVertexArray(VAO);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-                    // here we wanna save the current frame and if on pause we just show latest
-                    // frame
-                    // 24.03.2025 i think we dont want
+                    FrameProfiler::ScopedStage draw_stage(frame_profiler,
+                                                          ProfileStage::SHADER_DRAW);
+                    is_shader_drawn = true;
+
+                    // The buffers follow the scaled framebuffer, also when the window is resized
+                    int32_t framebuffer_width  = 0;
+                    int32_t framebuffer_height = 0;
+                    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+
+                    // Exported frames are not scaled, the adaptive scale would differ per run
+                    const GLuint scaled_framebuffer =
+                        is_exporting
+                            ? export_target->GetFramebuffer()
+                            : resolution_scaler.Begin(framebuffer_width, framebuffer_height, 0);
+                    const int32_t render_width =
+                        is_exporting ? export_settings.width : resolution_scaler.GetRenderWidth();
+                    const int32_t render_height =
+                        is_exporting ? export_settings.height : resolution_scaler.GetRenderHeight();
+                    render_graph.SetSize(render_width, render_height);
+
+                    const glm::vec2 render_size(render_width, render_height);
+
+                    builtin_uniforms.resolution = glm::vec3(render_width, render_height, 1.0f);
+                    builtin_uniforms.time       = scene_time;
+                    builtin_uniforms.time_delta = is_scene_playing ? delta_time : 0.0f;
+                    builtin_uniforms.frame_rate = delta_time > 0.0f ? 1.0f / delta_time : 0.0f;
+                    builtin_uniforms.frame      = frame;
+                    builtin_uniforms.mouse      = mouse_input.GetMouse(render_size);
+
+                    // Exported frames follow the fixed time step instead of the clock, iDate
+                    // stays at the start of the export and iMouse is zero like in the headless
+                    // mode, the input during an export is dropped
+                    if (is_exporting)
+                    {
+                        const int32_t export_frame = frame_exporter.GetNextFrame();
+                        const float   time_step    = export_settings.time_step;
+                        const float   start_time   = export_settings.start_time;
+
+                        builtin_uniforms.time       = start_time + time_step * export_frame;
+                        builtin_uniforms.time_delta = time_step;
+                        builtin_uniforms.frame_rate = time_step > 0.0f ? 1.0f / time_step : 0.0f;
+                        builtin_uniforms.frame      = export_frame;
+                        builtin_uniforms.mouse      = glm::vec4(0.0f);
+
+                        latency_tracker.DropPendingInput();
+                    }
+                    else
+                    {
+                        builtin_uniforms.date = GetBuiltinDate();
+                        latency_tracker.OnInputConsumed();  // This frame shows the polled cursor
+                    }
+
+                    // Cheap when no program changed, the passes are planned again otherwise
+                    render_graph.SetPass(RenderPassId::IMAGE,
+                                         &shader_program,
+                                         shader_manager.GetShaderProgramGeneration(),
+                                         shader_manager.GetFragmentShader().GetCodeConst());
+
+                    for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+                    {
+                        render_graph.SetPass(static_cast<RenderPassId>(i),
+                                             shader_manager.GetBufferProgram(i),
+                                             shader_manager.GetBufferProgramGeneration(i),
+                                             shader_manager.GetBufferShader(i).GetCodeConst());
+                    }
+
+                    // The block holds the channels of the image, the loose uniform is per pass
+                    render_graph.GetChannelResolutions(RenderPassId::IMAGE,
+                                                       builtin_uniforms.channel_resolution);
+
+                    // All tiles of a progressive image are drawn with the builtins of the first
+                    const bool is_progressive =
+                        !is_exporting && progressive_renderer.IsActive(!is_scene_playing);
+                    const auto& frame_builtins =
+                        is_progressive ? progressive_renderer.BeginFrame(render_graph,
+                                                                         builtin_uniforms,
+                                                                         render_width,
+                                                                         render_height,
+                                                                         is_accumulating)
+                                       : builtin_uniforms;
+
+                    if (shader_manager.IsBuiltinBlockEnabled() && builtin_uniform_buffer.IsValid())
+                    {
+                        builtin_uniform_buffer.Update(frame_builtins);  // One memcpy and one bind
+                        if (is_exporting) { mouse_sample_buffer.Clear(); }
+                        else { mouse_sample_buffer.Update(mouse_input, render_size); }
+                    }
+
+                    mouse_input.OnFrameConsumed();  // The click and the samples were shown
+
+                    // The loose builtins are set per pass by the graph
+                    if (is_progressive)
+                    {
+                        progressive_renderer.Render(render_graph, screen_quad, scaled_framebuffer);
+                    }
+                    else { render_graph.Execute(frame_builtins, screen_quad, scaled_framebuffer); }
+
+                    if (is_exporting)
+                    {
+                        frame_exporter.Capture(export_target->GetTexture());
+                        if (!frame_exporter.IsExporting()) { frame_exporter.Finish(); }
+
+                        export_preview.Draw(export_target->GetTexture(),
+                                            0,
+                                            framebuffer_width,
+                                            framebuffer_height);
+                    }
+                    else { resolution_scaler.End(); }  // Presents the kept frame in the window
                 }
             }
+            else
+            {
+                // Paused, the kept frame is shown again without running any shader
+                int32_t framebuffer_width  = 0;
+                int32_t framebuffer_height = 0;
+                glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
 
-            ui_manager.RenderFrame();
+                resolution_scaler.PresentLastFrame(framebuffer_width, framebuffer_height, 0);
+            }
 
-            // Swap buffers and poll for events
-            glfwSwapBuffers(window);
-            glfwPollEvents();
+            // No frame showed the polled input, a later one would charge the wait as latency
+            if (!is_shader_drawn) { latency_tracker.DropPendingInput(); }
 
-            ++frame;
+            {
+                FrameProfiler::ScopedStage ui_stage(frame_profiler, ProfileStage::UI);
+                ui_manager.RenderFrame();
+            }
+
+            // Nothing animates, the loop sleeps until an event or the timeout, which keeps the
+            // UI and the polled work (hot reload, compiles, loads) responsive
+            const bool is_idle =
+                !is_scene_playing && !is_accumulating && !frame_exporter.IsExporting();
 
-            // Log the frame time
-            frame_times.push_back(delta_time);
-            elapsed_time += delta_time;
-            if (elapsed_time >= FPS_LOG_INTERVAL)
             {
+                FrameProfiler::ScopedStage swap_stage(frame_profiler, ProfileStage::SWAP);
 
+                // Swap buffers and poll for events
+                glfwSwapBuffers(window);
+                frame_pacer.OnFramePresented(is_idle);
+                latency_tracker.OnFrameSwapped();  // Fenced only if the frame read new input
+                latency_tracker.Update();
 
-                // Calculate average FPS
-                float avg_fps = 1.0f
-                              / (std::accumulate(frame_times.begin(), frame_times.end(), 0.0f)
-                                 / frame_times.size());
+                if (!is_idle) { glfwPollEvents(); }
+            }
 
-                // Calculate 1% low FPS
-                std::vector<float> sorted_frame_times = frame_times;
-                std::sort(sorted_frame_times.begin(), sorted_frame_times.end());
-                float one_percent_low_fps =
-                    1.0f
-                    / sorted_frame_times[static_cast<size_t>(sorted_frame_times.size() * 0.99f)];
+            // Outside the swap stage, the sleep is not part of the frame
+            if (is_idle) { glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT); }
 
-                // Calculate 0.1% low FPS
-                float point_one_percent_low_fps =
-                    1.0f
-                    / sorted_frame_times[static_cast<size_t>(sorted_frame_times.size() * 0.999f)];
+            LatencyTracker::Clock::time_point event_time;
+            uint64_t                          event_count = 0;
+            if (mouse_input.Update(event_time, event_count))
+            {
+                frame_pacer.OnInput(event_time);
+                latency_tracker.OnInput(event_time, event_count);
+            }
 
-                // Log the FPS metrics
-                LOG_INFO("Delta time: {}", delta_time);
-                LOG_INFO("Average FPS: {}", avg_fps);
-                LOG_INFO("1% Low FPS: {}", one_percent_low_fps);
-                LOG_INFO("0.1% Low FPS: {}", point_one_percent_low_fps);
+            shader_manager.OnFramePresented();  // Logs the latency of a hot reload
+            shader_manager.UpdateAutosave();    // Written in the background, only if changed
+            frame_exporter.Update();            // Hands the finished readbacks to the workers
+
+            frame_profiler.EndFrame();
+
+            ++frame;
 
-                // Reset the elapsed time and frame times
-                elapsed_time = 0.0f;
-                frame_times.clear();
+            // Log the frame time, a frame after a sleep is not measured, like in the frame pacer
+            const bool is_frame_measured = !is_last_frame_idle;
+            is_last_frame_idle           = is_idle;
 
+            if (is_frame_measured && frame_stats.AddFrame(delta_time))
+            {
+                const auto& interval = frame_stats.GetInterval();
 
-                glfwSetWindowTitle(window, fmt::format("GLSL Live | FPS: {:.2f}", avg_fps).c_str());
+                // Log the FPS metrics
+                LOG_INFO("Delta time: {}", delta_time);
+                LOG_INFO("Average FPS: {}", interval.GetAverageFPS());
+                LOG_INFO("1% Low FPS: {}", interval.GetOnePercentLowFPS());
+                LOG_INFO("0.1% Low FPS: {}", interval.GetPointOnePercentLowFPS());
+                LOG_INFO("Frame time p50: {:.3f} ms, p99: {:.3f} ms, p99.9: {:.3f} ms, max: {:.3f}",
+                         interval.p50_ms,
+                         interval.p99_ms,
+                         interval.p999_ms,
+                         interval.max_ms);
+
+                // Log the shader program rebuild counters
+                const auto& shader_stats = shader_manager.GetStats();
+                LOG_INFO("Program rebuilds: {} (last {:.3f} ms), skipped: {}, saved: {:.3f} ms, "
+                         "deferred: {}",
+                         shader_stats.rebuilds,
+                         shader_stats.last_rebuild_ms,
+                         shader_stats.skipped_rebuilds,
+                         shader_stats.GetEstimatedSavedMs(),
+                         shader_stats.deferred_rebuilds);
+                LOG_INFO("Program cache hits: {}", shader_stats.cache_hits);
+
+                // Events lost because the queue filled up between two polls
+                LOG_INFO("Mouse events dropped: {}", mouse_input.GetDroppedEventCount());
+
+                glfwSetWindowTitle(
+                    window,
+                    fmt::format("GLSL Live | FPS: {:.2f}", interval.GetAverageFPS()).c_str());
             }
         }
 
         shader_manager.SaveFragmentShaderToPath("shaders/latest_fragment.glsl");
-        // Clean up
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        shader_manager.SaveBufferShaders();
+        frame_stats.Export("logs/frame_stats.json");
+
+        if (latency_tracker.IsEnabled())
+        {
+            latency_tracker.Finish();
+            latency_tracker.LogStats();
+        }
     }
 
 
@@ -0,0 +1,66 @@
+#version 460 core
+
+// Loop-heavy noise: domain warped fractal value noise with many octaves
+
+in vec2 fragCoord;          // Fragment Coordinate from 0 to iResolutin x or y
+in vec2 iResolution;        // Window resolution
+uniform float iTime;        // Elapsed time in seconds
+
+out vec4 fragColor;
+
+const int OCTAVES = 10;
+
+float Hash(vec2 p)
+{
+    p  = fract(p * vec2(123.34, 456.21));
+    p += dot(p, p + 45.32);
+    return fract(p.x * p.y);
+}
+
+float ValueNoise(vec2 p)
+{
+    vec2 i = floor(p);
+    vec2 f = fract(p);
+    vec2 u = f * f * (3.0 - 2.0 * f);
+
+    return mix(mix(Hash(i), Hash(i + vec2(1.0, 0.0)), u.x),
+               mix(Hash(i + vec2(0.0, 1.0)), Hash(i + vec2(1.0, 1.0)), u.x),
+               u.y);
+}
+
+float Fbm(vec2 p)
+{
+    const mat2 rotation = mat2(0.8, -0.6, 0.6, 0.8);
+
+    float value     = 0.0;
+    float amplitude = 0.5;
+    for (int i = 0; i < OCTAVES; ++i)
+    {
+        value     += amplitude * ValueNoise(p);
+        p          = rotation * p * 2.02;
+        amplitude *= 0.5;
+    }
+    return value;
+}
+
+void mainImage(out vec4 fragColor, in vec2 fragCoord)
+{
+    vec2 uv = fragCoord.xy / iResolution.y * 3.0;
+
+    // Two levels of domain warping, every sample is a full fbm
+    vec2 q = vec2(Fbm(uv + vec2(0.0, 0.0)), Fbm(uv + vec2(5.2, 1.3)));
+    vec2 r = vec2(Fbm(uv + 4.0 * q + vec2(1.7, 9.2) + 0.15 * iTime),
+                  Fbm(uv + 4.0 * q + vec2(8.3, 2.8) + 0.126 * iTime));
+    float f = Fbm(uv + 4.0 * r);
+
+    vec3 col = mix(vec3(0.1, 0.3, 0.4), vec3(0.9, 0.7, 0.4), clamp(f * f * 4.0, 0.0, 1.0));
+    col      = mix(col, vec3(0.0, 0.1, 0.2), clamp(length(q), 0.0, 1.0));
+    col      = mix(col, vec3(0.9, 0.9, 0.8), clamp(r.x, 0.0, 1.0) * 0.5);
+
+    fragColor = vec4(col, 1.0);
+}
+
+void main()
+{
+    mainImage(fragColor, fragCoord);
+}
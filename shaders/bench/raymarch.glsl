@@ -0,0 +1,114 @@
+#version 460 core
+
+// Heavy raymarcher, ALU bound: long sphere tracing loop, soft shadows and ambient occlusion
+
+in vec2 fragCoord;          // Fragment Coordinate from 0 to iResolutin x or y
+in vec2 iResolution;        // Window resolution
+uniform float iTime;        // Elapsed time in seconds
+
+out vec4 fragColor;
+
+const int   MAX_STEPS  = 160;
+const float MAX_DIST   = 60.0;
+const float SURF_DIST  = 0.0005;
+
+float SmoothMin(float a, float b, float k)
+{
+    float h = clamp(0.5 + 0.5 * (b - a) / k, 0.0, 1.0);
+    return mix(b, a, h) - k * h * (1.0 - h);
+}
+
+float Scene(vec3 p)
+{
+    float ground = p.y + 1.0 + 0.05 * sin(p.x * 4.0) * sin(p.z * 4.0);
+
+    vec3  q      = p;
+    q.xz         = mod(q.xz + 2.0, 4.0) - 2.0;  // Repeated columns
+    float column = length(q.xz) - 0.35 - 0.05 * sin(q.y * 10.0 + iTime);
+
+    float blob = 1e9;
+    for (int i = 0; i < 6; ++i)
+    {
+        float fi = float(i);
+        vec3  c  = vec3(sin(iTime * 0.7 + fi * 1.7), 0.3 * sin(iTime + fi), cos(iTime * 0.5 + fi));
+        blob     = SmoothMin(blob, length(p - c * 1.5) - 0.45, 0.4);
+    }
+
+    return min(min(ground, column), blob);
+}
+
+vec3 Normal(vec3 p)
+{
+    const vec2 e = vec2(0.0005, -0.0005);
+    return normalize(e.xyy * Scene(p + e.xyy) + e.yyx * Scene(p + e.yyx)
+                     + e.yxy * Scene(p + e.yxy) + e.xxx * Scene(p + e.xxx));
+}
+
+float March(vec3 ro, vec3 rd)
+{
+    float t = 0.0;
+    for (int i = 0; i < MAX_STEPS; ++i)
+    {
+        float d = Scene(ro + rd * t);
+        if (d < SURF_DIST * t || t > MAX_DIST) { break; }
+        t += d;
+    }
+    return t;
+}
+
+float SoftShadow(vec3 ro, vec3 rd)
+{
+    float result = 1.0;
+    float t      = 0.02;
+    for (int i = 0; i < 48 && t < 20.0; ++i)
+    {
+        float h = Scene(ro + rd * t);
+        result  = min(result, 8.0 * h / t);
+        t      += clamp(h, 0.01, 0.5);
+    }
+    return clamp(result, 0.0, 1.0);
+}
+
+float AmbientOcclusion(vec3 p, vec3 n)
+{
+    float occlusion = 0.0;
+    for (int i = 1; i <= 5; ++i)
+    {
+        float h    = 0.04 * float(i);
+        occlusion += h - Scene(p + n * h);
+    }
+    return clamp(1.0 - 4.0 * occlusion, 0.0, 1.0);
+}
+
+void mainImage(out vec4 fragColor, in vec2 fragCoord)
+{
+    vec2 uv = (2.0 * fragCoord - iResolution.xy) / iResolution.y;
+
+    vec3 ro = vec3(4.0 * sin(iTime * 0.2), 1.0, 4.0 * cos(iTime * 0.2));
+    vec3 ww = normalize(-ro);
+    vec3 uu = normalize(cross(ww, vec3(0.0, 1.0, 0.0)));
+    vec3 vv = cross(uu, ww);
+    vec3 rd = normalize(uv.x * uu + uv.y * vv + 1.6 * ww);
+
+    vec3  col = vec3(0.6, 0.7, 0.9) - 0.3 * rd.y;
+    float t   = March(ro, rd);
+
+    if (t < MAX_DIST)
+    {
+        vec3  p     = ro + rd * t;
+        vec3  n     = Normal(p);
+        vec3  light = normalize(vec3(0.6, 0.8, -0.4));
+        float diff  = max(dot(n, light), 0.0) * SoftShadow(p + n * 0.01, light);
+        float ao    = AmbientOcclusion(p, n);
+
+        col = vec3(0.9, 0.8, 0.7) * diff + vec3(0.15, 0.2, 0.3) * ao;
+        col = mix(col, vec3(0.6, 0.7, 0.9), 1.0 - exp(-0.002 * t * t));
+    }
+
+    fragColor = vec4(pow(col, vec3(0.4545)), 1.0);
+}
+
+void main()
+{
+    mainImage(fragColor, fragCoord);
+}
@@ -0,0 +1,34 @@
+#version 460 core
+
+// Texture fetch bound: many dependent, scattered fetches with varying level of detail
+
+in vec2 fragCoord;          // Fragment Coordinate from 0 to iResolutin x or y
+in vec2 iResolution;        // Window resolution
+uniform float iTime;        // Elapsed time in seconds
+uniform sampler2D iChannel0; // Noise texture provided by the benchmark
+
+out vec4 fragColor;
+
+const int FETCHES = 48;
+
+void mainImage(out vec4 fragColor, in vec2 fragCoord)
+{
+    vec2 uv = fragCoord.xy / iResolution.xy;
+
+    vec4 sum = vec4(0.0);
+    vec2 p   = uv;
+    for (int i = 0; i < FETCHES; ++i)
+    {
+        // Each fetch depends on the previous one, so the fetches cannot be overlapped
+        vec4 texel = textureLod(iChannel0, p, float(i % 4));
+        p          = fract(p + (texel.xy - 0.5) * 0.37 + vec2(0.013, 0.007) * iTime);
+        sum       += texel;
+    }
+
+    fragColor = vec4(sum.rgb / float(FETCHES), 1.0);
+}
+
+void main()
+{
+    mainImage(fragColor, fragCoord);
+}
@@ -0,0 +1,135 @@
+#include "AsyncFileWriter.h"
+#include "Utils.h"
+
+AsyncFileWriter::AsyncFileWriter() noexcept :
+    worker(&AsyncFileWriter::WorkerLoop, this)
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    {
+        std::lock_guard lock(mutex);
+        is_stopping = true;
+    }
+    wake_condition.notify_one();
+
+    // The worker drains the queue before it stops, saves on shutdown are not lost
+    if (worker.joinable()) { worker.join(); }
+}
+
+bool AsyncFileWriter::Write(std::string_view file_path_, std::string_view text_) noexcept
+{
+    if (text_.empty()) { return false; }
+
+    const uint64_t hash = HashText(text_);
+    auto           key  = GetKey(file_path_);
+
+    {
+        std::lock_guard lock(mutex);
+
+        // Always queued, the file may have changed on the disk since the last write, the worker
+        // skips it only if the disk already has this text
+        last_hashes[key] = hash;
+
+        auto& write = pending[std::move(key)];
+        write.text.assign(text_);
+        write.hash = hash;
+    }
+
+    wake_condition.notify_one();
+    return true;
+}
+
+void AsyncFileWriter::Flush() noexcept
+{
+    std::unique_lock lock(mutex);
+    idle_condition.wait(lock, [this] { return pending.empty() && !is_writing; });
+}
+
+bool AsyncFileWriter::IsLastWrite(std::string_view file_path_,
+                                  std::string_view text_) const noexcept
+{
+    const auto key  = GetKey(file_path_);
+    const auto hash = HashText(text_);
+
+    std::lock_guard lock(mutex);
+
+    auto it = last_hashes.find(key);
+    return it != last_hashes.end() && it->second == hash;
+}
+
+AsyncFileWriterStats AsyncFileWriter::GetStats() const noexcept
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+void AsyncFileWriter::WorkerLoop() noexcept
+{
+    std::unique_lock lock(mutex);
+
+    while (true)
+    {
+        wake_condition.wait(lock, [this] { return is_stopping || !pending.empty(); });
+
+        if (pending.empty())  // Stopping with nothing left to write
+        {
+            break;
+        }
+
+        auto node  = pending.extract(pending.begin());
+        is_writing = true;
+        lock.unlock();
+
+        const auto& file_path = node.key();
+        const auto& write     = node.mapped();
+        const auto  start     = std::chrono::steady_clock::now();
+
+        // The disk may have the same content already, written by us or by another program
+        std::error_code error;
+        bool            is_skipped = false;
+        if (std::filesystem::is_regular_file(GetApplicationPath() + "/" + file_path, error))
+        {
+            const FileView current(file_path);
+            is_skipped = current.IsOpen() && HashText(current.GetText()) == write.hash;
+        }
+
+        const bool is_written = !is_skipped && WriteTextToFile(file_path, write.text);
+
+        const double write_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count();
+
+        lock.lock();
+        is_writing = false;
+
+        if (is_skipped) { ++stats.skipped_writes; }
+        else if (is_written)
+        {
+            ++stats.writes;
+            stats.last_write_ms = write_ms;
+        }
+        else
+        {
+            ++stats.failed_writes;
+
+            // The next save of the same text must try again
+            auto it = last_hashes.find(file_path);
+            if (it != last_hashes.end() && it->second == write.hash) { last_hashes.erase(it); }
+        }
+
+        if (pending.empty()) { idle_condition.notify_all(); }
+    }
+
+    idle_condition.notify_all();
+}
+
+std::string AsyncFileWriter::GetKey(std::string_view file_path_)
+{
+    auto key = std::filesystem::path(file_path_).lexically_normal().generic_string();
+
+    // Paths are relative to the application, "/shaders/a.glsl" is the same file as "shaders/a.glsl"
+    const size_t start = key.find_first_not_of('/');
+    return start == std::string::npos ? std::string() : key.substr(start);
+}
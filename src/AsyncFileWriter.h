@@ -0,0 +1,85 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Counters of the asynchronous writes
+ */
+struct AsyncFileWriterStats {
+    uint64_t writes         = 0;   /**< Files written to the disk */
+    uint64_t skipped_writes = 0;   /**< Writes dropped because the disk had the content */
+    uint64_t failed_writes  = 0;   /**< Writes which failed, see the log */
+    double   last_write_ms  = 0.0; /**< Duration of the last write including the flush */
+};
+
+/**
+ * @brief Writes text files on a worker thread, so saving never stalls the render thread
+ *
+ * @remark Files are written with WriteTextToFile(), which replaces them atomically. Only the
+ * latest text queued for a path is written, and text whose hash equals the one found on the disk
+ * is not written at all, so saving unchanged code costs only a read on the worker. The disk is
+ * checked on every write, a file changed by another program is always overwritten by a save.
+ */
+struct AsyncFileWriter {
+    explicit AsyncFileWriter() noexcept;
+
+    AsyncFileWriter(const AsyncFileWriter&)             = delete;
+    AsyncFileWriter& operator= (const AsyncFileWriter&) = delete;
+
+    /**
+     * @brief Finishes the queued writes and stops the worker
+     */
+    ~AsyncFileWriter();
+
+    /**
+     * @brief Queues a snapshot of the text, replacing the text queued for the path and not
+     * written yet
+     *
+     * @param file_path_ Path relative to the application directory
+     * @param text_ Text of the file, copied
+     *
+     * @return true if the text was queued, false if it is empty
+     */
+    bool Write(std::string_view file_path_, std::string_view text_) noexcept;
+
+    /**
+     * @brief Blocks until all queued writes are finished
+     */
+    void Flush() noexcept;
+
+    /**
+     * @brief Returns true if the text is the last one queued for the path, used to ignore the
+     * file watcher reports of our own writes
+     */
+    bool IsLastWrite(std::string_view file_path_, std::string_view text_) const noexcept;
+
+    AsyncFileWriterStats GetStats() const noexcept;
+
+private:
+
+    struct PendingWrite {
+        std::string text;
+        uint64_t    hash = 0;
+    };
+
+    void WorkerLoop() noexcept;
+
+    /**
+     * @brief Returns the key of the path, so different spellings of a path share the hash
+     */
+    static std::string GetKey(std::string_view file_path_);
+
+private:
+    mutable std::mutex      mutex;
+    std::condition_variable wake_condition; /**< Signaled when a write is queued or on stop */
+    std::condition_variable idle_condition; /**< Signaled when the queue is drained */
+
+    std::map<std::string, PendingWrite>       pending;     /**< Latest text by path */
+    std::unordered_map<std::string, uint64_t> last_hashes; /**< Hash of the last text by path */
+    AsyncFileWriterStats                      stats;
+
+    bool is_writing  = false; /**< Flag indicating if the worker is writing outside the lock */
+    bool is_stopping = false;
+
+    std::thread worker; /**< Declared last, starts after the other members are constructed */
+};
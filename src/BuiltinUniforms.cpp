@@ -0,0 +1,404 @@
+#include "BuiltinUniforms.h"
+
+namespace {
+
+/**
+ * @brief GLSL declaration of the block, must match BuiltinUniformData
+ */
+constexpr std::string_view BUILTIN_BLOCK = R"(layout(std140, binding = 0) uniform GLSLLiveBuiltins {
+    vec3  glsl_live_resolution;
+    float glsl_live_time;
+    vec4  glsl_live_mouse;
+    vec4  glsl_live_date;
+    float glsl_live_time_delta;
+    float glsl_live_frame_rate;
+    int   glsl_live_frame;
+    float glsl_live_sample_rate;
+    vec4  glsl_live_channel_time;
+    vec3  glsl_live_channel_resolution[4];
+};
+)";
+
+/**
+ * @brief GLSL declaration of the motion samples, must match MouseSampleBuffer, injected only
+ * into shaders which use them
+ */
+constexpr std::string_view MOUSE_SAMPLE_BLOCK =
+    R"(layout(std430, binding = 1) readonly buffer GLSLLiveMouseSamples {
+    int  glsl_live_mouse_sample_count;
+    vec4 glsl_live_mouse_samples[];
+};
+#define iMouseSampleCount glsl_live_mouse_sample_count
+#define iMouseSamples glsl_live_mouse_samples
+)";
+
+constexpr std::array MOUSE_SAMPLE_NAMES = { std::string_view("iMouseSamples"),
+                                            std::string_view("iMouseSampleCount") };
+
+/**
+ * @brief Builtin name and the block expression it is mapped onto
+ */
+struct BuiltinName {
+    std::string_view name;
+    std::string_view expression;
+};
+
+constexpr std::array BUILTIN_NAMES = {
+    BuiltinName { "iResolution", "glsl_live_resolution" },
+    BuiltinName { "in_resolution", "glsl_live_resolution.xy" },  // Used by the default vertex
+    BuiltinName { "iTime", "glsl_live_time" },
+    BuiltinName { "iTimeDelta", "glsl_live_time_delta" },
+    BuiltinName { "iFrameRate", "glsl_live_frame_rate" },
+    BuiltinName { "iFrame", "glsl_live_frame" },
+    BuiltinName { "iMouse", "glsl_live_mouse" },
+    BuiltinName { "iDate", "glsl_live_date" },
+    BuiltinName { "iSampleRate", "glsl_live_sample_rate" },
+    BuiltinName { "iChannelTime",
+                  "float[4](glsl_live_channel_time.x, glsl_live_channel_time.y, "
+                  "glsl_live_channel_time.z, glsl_live_channel_time.w)" },
+    BuiltinName { "iChannelResolution", "glsl_live_channel_resolution" },
+};
+
+constexpr int MIN_BINDING_LAYOUT_VERSION = 420;  // layout(binding = N) needs GLSL 4.20
+constexpr int MIN_STORAGE_BUFFER_VERSION = 430;  // Shader storage blocks need GLSL 4.30
+
+bool IsIdentifierChar(char c_)
+{
+    return std::isalnum(static_cast<unsigned char>(c_)) || c_ == '_';
+}
+
+/**
+ * @brief Splits the line into identifiers and numbers, stops at a line comment
+ */
+std::vector<std::string_view> TokenizeLine(std::string_view line_)
+{
+    std::vector<std::string_view> tokens;
+
+    size_t i = 0;
+    while (i < line_.size())
+    {
+        if (line_.substr(i, 2) == "//") { break; }
+
+        if (!IsIdentifierChar(line_[i]))
+        {
+            ++i;
+            continue;
+        }
+
+        const size_t start = i;
+        while (i < line_.size() && IsIdentifierChar(line_[i])) { ++i; }
+
+        tokens.push_back(line_.substr(start, i - start));
+    }
+
+    return tokens;
+}
+
+/**
+ * @brief Splits the line into statements ending with their semicolon, without the leading
+ * whitespace, stops at a line comment
+ */
+std::vector<std::string_view> SplitStatements(std::string_view line_)
+{
+    std::vector<std::string_view> statements;
+
+    const size_t code_end = std::min(line_.find("//"), line_.size());
+
+    size_t start = 0;
+    while (start < code_end)
+    {
+        start = line_.find_first_not_of(" \t", start);
+        if (start == std::string_view::npos || start >= code_end) { break; }
+
+        const size_t end = std::min(line_.find(';', start), code_end - 1) + 1;
+        statements.push_back(line_.substr(start, end - start));
+        start = end;
+    }
+
+    return statements;
+}
+
+/**
+ * @brief Returns the number of the names a declaration statement declares
+ */
+size_t CountDeclarators(std::string_view statement_)
+{
+    size_t count = 1;
+    int    depth = 0;
+
+    for (const char c : statement_)
+    {
+        if (c == '(' || c == '[') { ++depth; }
+        else if (c == ')' || c == ']') { --depth; }
+        else if (c == ',' && depth == 0) { ++count; }
+    }
+
+    return count;
+}
+
+}  // namespace
+
+glm::vec4 GetBuiltinDate() noexcept
+{
+    const std::time_t now = std::time(nullptr);
+    std::tm           local_time {};
+#ifdef _WIN32
+    localtime_s(&local_time, &now);
+#else
+    localtime_r(&now, &local_time);
+#endif
+
+    const float seconds =
+        static_cast<float>(local_time.tm_hour * 3600 + local_time.tm_min * 60 + local_time.tm_sec);
+
+    return glm::vec4(static_cast<float>(local_time.tm_year + 1900),
+                     static_cast<float>(local_time.tm_mon),
+                     static_cast<float>(local_time.tm_mday),
+                     seconds);
+}
+
+std::string InjectBuiltinUniformBlock(std::string_view code_)
+{
+    std::vector<std::string_view> lines;
+    for (size_t start = 0; start <= code_.size();)
+    {
+        const size_t end = std::min(code_.find('\n', start), code_.size());
+        lines.push_back(code_.substr(start, end - start));
+        start = end + 1;
+    }
+
+    // The block must follow the #version line
+    auto version_line = std::find_if(lines.begin(),
+                                     lines.end(),
+                                     [](std::string_view line)
+                                     {
+                                         const auto tokens = TokenizeLine(line);
+                                         return !tokens.empty() && tokens[0] == "version"
+                                             && line.find('#') != std::string_view::npos;
+                                     });
+
+    if (version_line == lines.end()) { return std::string(code_); }
+
+    const auto version_tokens = TokenizeLine(*version_line);
+    const int  version =
+        version_tokens.size() < 2 ? 0 : std::atoi(std::string(version_tokens[1]).c_str());
+
+    if (version < MIN_BINDING_LAYOUT_VERSION) { return std::string(code_); }
+
+    std::array<bool, BUILTIN_NAMES.size()>  is_declared_otherwise {};
+    std::vector<std::optional<std::string>> replaced_lines(lines.size());  // Set if changed
+    bool                                    is_mouse_sampled = false;
+
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        const auto tokens = TokenizeLine(lines[i]);
+
+        if (tokens.empty()) { continue; }
+
+        for (const auto name : MOUSE_SAMPLE_NAMES)
+        {
+            is_mouse_sampled |= std::find(tokens.begin(), tokens.end(), name) != tokens.end();
+        }
+
+        std::string replaced_line;
+        size_t      copied_length = 0;
+
+        for (const auto statement : SplitStatements(lines[i]))
+        {
+            const auto statement_tokens = TokenizeLine(statement);
+
+            if (statement_tokens.empty()) { continue; }
+
+            const bool is_uniform = statement_tokens[0] == "uniform";
+            const bool is_varying = statement_tokens[0] == "in" || statement_tokens[0] == "out"
+                                 || statement_tokens[0] == "varying";
+
+            if (!is_uniform && !is_varying) { continue; }
+
+            std::array<bool, BUILTIN_NAMES.size()> is_named {};
+            size_t                                 named_count = 0;
+
+            for (size_t n = 0; n < BUILTIN_NAMES.size(); ++n)
+            {
+                is_named[n] = std::find(statement_tokens.begin(),
+                                        statement_tokens.end(),
+                                        BUILTIN_NAMES[n].name)
+                           != statement_tokens.end();
+                named_count += is_named[n] ? 1 : 0;
+            }
+
+            if (named_count == 0) { continue; }
+
+            // Only a declaration of builtins alone is replaced by the block, one which declares
+            // other names too keeps its loose builtins, which are still set per pass
+            const bool is_removed = is_uniform && named_count == CountDeclarators(statement)
+                                 && statement.ends_with(';')
+                                 && statement.find_first_of("{}") == std::string_view::npos
+                                 && statement.find("/*") == std::string_view::npos;
+
+            if (!is_removed)
+            {
+                for (size_t n = 0; n < BUILTIN_NAMES.size(); ++n)
+                {
+                    is_declared_otherwise[n] = is_declared_otherwise[n] || is_named[n];
+                }
+                continue;
+            }
+
+            // Commented out in place, the rest of the line is kept
+            const size_t offset = static_cast<size_t>(statement.data() - lines[i].data());
+
+            replaced_line += lines[i].substr(copied_length, offset - copied_length);
+            replaced_line += "/* ";
+            replaced_line += statement;
+            replaced_line += " */";
+            copied_length  = offset + statement.size();
+        }
+
+        if (copied_length > 0)
+        {
+            replaced_line     += lines[i].substr(copied_length);
+            replaced_lines[i]  = std::move(replaced_line);
+        }
+    }
+
+    const size_t version_index = static_cast<size_t>(version_line - lines.begin());
+
+    std::string result;
+    result.reserve(code_.size() + 2048);
+
+    for (size_t i = 0; i <= version_index; ++i)
+    {
+        result += lines[i];
+        result += '\n';
+    }
+
+    result += BUILTIN_BLOCK;
+
+    if (is_mouse_sampled && version >= MIN_STORAGE_BUFFER_VERSION)
+    {
+        result += MOUSE_SAMPLE_BLOCK;
+    }
+
+    for (size_t n = 0; n < BUILTIN_NAMES.size(); ++n)
+    {
+        if (is_declared_otherwise[n]) { continue; }
+
+        result +=
+            fmt::format("#define {} {}\n", BUILTIN_NAMES[n].name, BUILTIN_NAMES[n].expression);
+    }
+
+    // Errors keep pointing at the lines of the original code
+    result += fmt::format("#line {}\n", version_index + 2);
+
+    for (size_t i = version_index + 1; i < lines.size(); ++i)
+    {
+        if (replaced_lines[i]) { result += *replaced_lines[i]; }
+        else { result += lines[i]; }
+
+        if (i + 1 < lines.size()) { result += '\n'; }
+    }
+
+    return result;
+}
+
+void BuiltinUniformHandles::Resolve(const ShaderProgram& shader_program_) noexcept
+{
+    resolution = shader_program_.GetUniformHandle("in_resolution");
+    time       = shader_program_.GetUniformHandle("iTime");
+    time_delta = shader_program_.GetUniformHandle("iTimeDelta");
+    frame_rate = shader_program_.GetUniformHandle("iFrameRate");
+    frame      = shader_program_.GetUniformHandle("iFrame");
+    mouse      = shader_program_.GetUniformHandle("iMouse");
+    date       = shader_program_.GetUniformHandle("iDate");
+
+    channel_resolution = shader_program_.GetUniformHandle("iChannelResolution");
+}
+
+void BuiltinUniformHandles::Apply(const ShaderProgram&      shader_program_,
+                                  const BuiltinUniformData& data_) const noexcept
+{
+    shader_program_.SetUniform(resolution, glm::vec2(data_.resolution.x, data_.resolution.y));
+    shader_program_.SetUniform(time, data_.time);
+    shader_program_.SetUniform(time_delta, data_.time_delta);
+    shader_program_.SetUniform(frame_rate, data_.frame_rate);
+    shader_program_.SetUniform(frame, static_cast<int>(data_.frame));
+    shader_program_.SetUniform(mouse, data_.mouse);
+    shader_program_.SetUniform(date, data_.date);
+
+    if (channel_resolution.IsValid())
+    {
+        // The data keeps the std140 padding, the loose uniform is a plain vec3 array
+        std::array<glm::vec3, 4> resolutions;
+        for (size_t i = 0; i < resolutions.size(); ++i)
+        {
+            resolutions[i] = glm::vec3(data_.channel_resolution[i]);
+        }
+
+        glProgramUniform3fv(shader_program_.GetID(),
+                            channel_resolution.location,
+                            static_cast<GLsizei>(resolutions.size()),
+                            glm::value_ptr(resolutions[0]));
+    }
+}
+
+BuiltinUniformBuffer::BuiltinUniformBuffer() noexcept
+{
+    GLint offset_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+    offset_alignment = std::max(offset_alignment, 1);
+
+    region_stride = static_cast<GLsizeiptr>(
+        (sizeof(BuiltinUniformData) + offset_alignment - 1) / offset_alignment * offset_alignment);
+
+    const GLsizeiptr buffer_size = region_stride * static_cast<GLsizeiptr>(REGION_COUNT);
+    const GLbitfield flags       = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, buffer_size, nullptr, flags);
+    mapped_memory = static_cast<uint8_t*>(glMapNamedBufferRange(buffer, 0, buffer_size, flags));
+
+    if (!mapped_memory) { LOG_ERROR("Failed to map the builtin uniform buffer"); }
+}
+
+BuiltinUniformBuffer::~BuiltinUniformBuffer()
+{
+    for (auto& fence : fences)
+    {
+        if (fence) { glDeleteSync(fence); }
+    }
+
+    if (mapped_memory) { glUnmapNamedBuffer(buffer); }
+
+    if (buffer) { glDeleteBuffers(1, &buffer); }
+}
+
+bool BuiltinUniformBuffer::IsValid() const noexcept { return mapped_memory != nullptr; }
+
+void BuiltinUniformBuffer::Update(const BuiltinUniformData& data_) noexcept
+{
+    if (!mapped_memory) { return; }
+
+    // The draws of the previous frame were issued, fence the region they read
+    if (has_pending_region)
+    {
+        fences[current_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        current_region         = (current_region + 1) % REGION_COUNT;
+    }
+
+    // With three regions this practically never waits, the GPU is at most two frames behind
+    if (GLsync& fence = fences[current_region])
+    {
+        constexpr GLuint64 TIMEOUT_NS = 1'000'000'000;
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT_NS);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const GLintptr offset = region_stride * static_cast<GLintptr>(current_region);
+
+    std::memcpy(mapped_memory + offset, &data_, sizeof(data_));
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, buffer, offset, sizeof(data_));
+
+    has_pending_region = true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "ShaderProgram.h"
+
+/**
+ * @brief Per-frame ShaderToy builtins, laid out exactly as the std140 GLSLLiveBuiltins block
+ */
+struct BuiltinUniformData {
+    glm::vec3 resolution         = glm::vec3(0.0f); /**< iResolution, viewport size in pixels */
+    float     time               = 0.0f;            /**< iTime, playback time in seconds */
+    glm::vec4 mouse              = glm::vec4(0.0f); /**< iMouse */
+    glm::vec4 date               = glm::vec4(0.0f); /**< iDate, year, month, day, seconds */
+    float     time_delta         = 0.0f;            /**< iTimeDelta, frame time in seconds */
+    float     frame_rate         = 0.0f;            /**< iFrameRate */
+    int32_t   frame              = 0;               /**< iFrame */
+    float     sample_rate        = 44100.0f;        /**< iSampleRate */
+    glm::vec4 channel_time       = glm::vec4(0.0f); /**< iChannelTime[4] */
+    glm::vec4 channel_resolution[4] = {};           /**< iChannelResolution[4], w is padding */
+};
+
+static_assert(sizeof(BuiltinUniformData) == 144, "Must match the std140 layout of the block");
+
+/**
+ * @brief Returns the current local date in the iDate format (year, month from 0, day, seconds
+ * since midnight)
+ */
+glm::vec4 GetBuiltinDate() noexcept;
+
+/**
+ * @brief Injects the builtin uniform block after the #version line, so the shader reads the
+ * builtins from the block
+ *
+ * @remark Compatibility preamble: loose declarations of the builtins (e.g. "uniform float iTime;")
+ * are commented out in place and the names are mapped onto the block members, so shaders written
+ * for loose uniforms keep working. Names declared as shader inputs or outputs, or together with
+ * other names (e.g. "uniform float iTime, speed;"), are left untouched and stay loose uniforms.
+ * Line numbers of the original code are preserved with a #line directive.
+ *
+ * @param code_ Shader code
+ *
+ * @return Code with the block, or the unchanged code if its GLSL version has no binding layouts
+ */
+std::string InjectBuiltinUniformBlock(std::string_view code_);
+
+/**
+ * @brief Locations of the loose builtin uniforms, used when the block is not enabled
+ */
+struct BuiltinUniformHandles {
+    /**
+     * @brief Resolves the handles of the program, must be called again if the program changes
+     */
+    void Resolve(const ShaderProgram& shader_program_) noexcept;
+
+    void Apply(const ShaderProgram&      shader_program_,
+               const BuiltinUniformData& data_) const noexcept;
+
+    UniformHandle resolution;
+    UniformHandle time;
+    UniformHandle time_delta;
+    UniformHandle frame_rate;
+    UniformHandle frame;
+    UniformHandle mouse;
+    UniformHandle date;
+    UniformHandle channel_resolution;
+};
+
+/**
+ * @brief Triple-buffered, persistently mapped uniform buffer for the builtin block, so uploading
+ * the per-frame state costs one memcpy and one bind
+ *
+ * @remark Every region is guarded by a fence, the CPU never writes a region the GPU still reads
+ */
+struct BuiltinUniformBuffer {
+    static constexpr GLuint BINDING      = 0; /**< Binding point of the GLSLLiveBuiltins block */
+    static constexpr size_t REGION_COUNT = 3;
+
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit BuiltinUniformBuffer() noexcept;
+
+    BuiltinUniformBuffer(const BuiltinUniformBuffer&)             = delete;
+    BuiltinUniformBuffer& operator= (const BuiltinUniformBuffer&) = delete;
+
+    ~BuiltinUniformBuffer();
+
+    bool IsValid() const noexcept;
+
+    /**
+     * @brief Writes the data into the next region and binds it to the block binding point
+     *
+     * @remark Call once per frame before drawing, the previous region is fenced here
+     */
+    void Update(const BuiltinUniformData& data_) noexcept;
+
+private:
+    GLuint     buffer             = 0;       /**< Buffer object */
+    uint8_t*   mapped_memory      = nullptr; /**< Persistent mapping of the whole buffer */
+    GLsizeiptr region_stride      = 0;       /**< Region size rounded up to the offset alignment */
+    size_t     current_region     = 0;       /**< Region written by the last Update() */
+    bool       has_pending_region = false;   /**< Flag indicating if the region needs a fence */
+
+    std::array<GLsync, REGION_COUNT> fences {}; /**< Fences of the draws reading the regions */
+};
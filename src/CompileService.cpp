@@ -0,0 +1,179 @@
+#include "CompileService.h"
+
+#include "Utils.h"
+
+CompileResult::~CompileResult()
+{
+    if (fence) { glDeleteSync(fence); }
+}
+
+CompileService::CompileService(GLFWwindow*         main_window_,
+                               ProgramBinaryCache& program_cache_) noexcept :
+    program_cache(program_cache_)
+{
+    // Objects can be shared only between contexts of the same version and profile
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
+                   glfwGetWindowAttrib(main_window_, GLFW_CONTEXT_VERSION_MAJOR));
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
+                   glfwGetWindowAttrib(main_window_, GLFW_CONTEXT_VERSION_MINOR));
+    glfwWindowHint(GLFW_OPENGL_PROFILE, glfwGetWindowAttrib(main_window_, GLFW_OPENGL_PROFILE));
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    worker_window = glfwCreateWindow(1, 1, "GLSL Live Compiler", nullptr, main_window_);
+
+    glfwDefaultWindowHints();  // Do not leak the hints into windows created later
+
+    if (!worker_window)
+    {
+        LOG_ERROR("Failed to create the shared context for the compile worker");
+        return;
+    }
+
+    worker = std::thread(&CompileService::WorkerLoop, this);
+}
+
+CompileService::~CompileService()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard lock(wake_mutex);
+            is_stopping = true;
+        }
+        wake_condition.notify_one();
+        worker.join();
+    }
+
+    if (worker_window) { glfwDestroyWindow(worker_window); }
+}
+
+bool CompileService::IsRunning() const noexcept { return worker.joinable(); }
+
+uint64_t CompileService::GetSupersededCount() const noexcept { return superseded_count; }
+
+uint64_t CompileService::GetCancelledCount() const noexcept { return cancelled_count; }
+
+void CompileService::Submit(std::unique_ptr<CompileRequest> request_) noexcept
+{
+    // The not started request is outdated now, drop it
+    if (requests.Post(std::move(request_))) { ++superseded_count; }
+
+    {
+        std::lock_guard lock(wake_mutex);
+        has_work = true;
+    }
+    wake_condition.notify_one();
+}
+
+std::unique_ptr<CompileResult> CompileService::TakeResult() noexcept
+{
+    auto result = results.Take();
+
+    if (result && result->fence)
+    {
+        // GPU side wait, the render thread itself is not blocked
+        glWaitSync(result->fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(result->fence);
+        result->fence = nullptr;
+    }
+
+    return result;
+}
+
+void CompileService::WorkerLoop() noexcept
+{
+    glfwMakeContextCurrent(worker_window);
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(wake_mutex);
+            wake_condition.wait(lock, [this] { return has_work || is_stopping; });
+
+            if (is_stopping) { break; }
+
+            has_work = false;
+        }
+
+        auto request = requests.Take();
+
+        if (!request) { continue; }
+
+        // An unread older result is replaced and destroyed here, while our context is current
+        if (auto result = Compile(*request)) { results.Post(std::move(result)); }
+    }
+
+    vertex_shader.DeleteShader();
+    fragment_shader.DeleteShader();
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+std::unique_ptr<CompileResult> CompileService::Compile(CompileRequest& request_) noexcept
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    auto result      = std::make_unique<CompileResult>();
+    result->revision = request_.revision;
+
+    const uint64_t cache_key =
+        program_cache.MakeKey(request_.vertex_source, request_.fragment_source);
+
+    if (program_cache.Load(cache_key, result->shader_program))
+    {
+        // The cached program was linked from exactly this code, nothing to compile
+        result->is_from_cache    = true;
+        result->is_vertex_good   = true;
+        result->is_fragment_good = true;
+        result->vertex_hash      = HashText(request_.vertex_source);
+        result->fragment_hash    = HashText(request_.fragment_source);
+    }
+    else
+    {
+        vertex_shader.GetCode()   = std::move(request_.vertex_source);
+        fragment_shader.GetCode() = std::move(request_.fragment_source);
+
+        vertex_shader.SetLineMap(std::move(request_.vertex_line_map));
+        fragment_shader.SetLineMap(std::move(request_.fragment_line_map));
+
+        // Only the shaders with changed code are really compiled
+        result->is_vertex_good   = vertex_shader.CompileFromCurrentCode(ShaderType::VERTEX);
+        result->is_fragment_good = fragment_shader.CompileFromCurrentCode(ShaderType::FRAGMENT);
+        result->vertex_hash      = vertex_shader.GetCompiledHash();
+        result->fragment_hash    = fragment_shader.GetCompiledHash();
+
+        if (!result->is_vertex_good) { result->vertex_error = vertex_shader.GetCompilationError(); }
+
+        if (!result->is_fragment_good)
+        {
+            result->fragment_error = fragment_shader.GetCompilationError();
+        }
+
+        // The user kept typing while we compiled, linking this revision is wasted work
+        if (!requests.IsEmpty())
+        {
+            ++cancelled_count;
+            return nullptr;
+        }
+
+        if (result->is_vertex_good && result->is_fragment_good)
+        {
+            result->shader_program = ShaderProgram(vertex_shader, fragment_shader);
+
+            if (result->shader_program.GetID() != 0)
+            {
+                program_cache.Store(cache_key, result->shader_program);
+            }
+        }
+    }
+
+    // The fence must reach the GPU before the render context starts waiting for it
+    result->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    const std::chrono::duration<double, std::milli> compile_time =
+        std::chrono::steady_clock::now() - start_time;
+    result->compile_ms = compile_time.count();
+
+    return result;
+}
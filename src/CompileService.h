@@ -0,0 +1,118 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "Mailbox.h"
+#include "Shader.h"
+#include "ShaderProgram.h"
+#include "ProgramBinaryCache.h"
+
+/**
+ * @brief Snapshot of the shader code which should be compiled and linked
+ */
+struct CompileRequest {
+    uint64_t    revision = 0;    /**< Increasing number, newer requests supersede older ones */
+    std::string vertex_source;   /**< Vertex shader code */
+    std::string fragment_source; /**< Fragment shader code */
+
+    std::shared_ptr<const SourceLineMap> vertex_line_map;   /**< Origins of the vertex lines */
+    std::shared_ptr<const SourceLineMap> fragment_line_map; /**< Origins of the fragment lines */
+};
+
+/**
+ * @brief Result of the compilation of a CompileRequest
+ */
+struct CompileResult {
+    explicit CompileResult() noexcept = default;
+    ~CompileResult();
+
+    uint64_t      revision         = 0;       /**< Revision of the request */
+    uint64_t      vertex_hash      = 0;       /**< Hash of the compiled vertex code */
+    uint64_t      fragment_hash    = 0;       /**< Hash of the compiled fragment code */
+    bool          is_vertex_good   = false;   /**< Flag indicating if the vertex shader is good */
+    bool          is_fragment_good = false;   /**< Flag indicating if the fragment shader is good */
+    std::string   vertex_error;               /**< Compilation error of the vertex shader */
+    std::string   fragment_error;             /**< Compilation error of the fragment shader */
+    ShaderProgram shader_program;             /**< Linked program, ID is 0 if anything failed */
+    bool          is_from_cache    = false;   /**< Flag indicating if the program was cached */
+    GLsync        fence            = nullptr; /**< Signaled when the worker commands are finished */
+    double        compile_ms       = 0.0;     /**< Duration of the compilation and link in ms */
+};
+
+/**
+ * @brief Compiles and links shader programs on a worker thread, so the render thread never
+ * waits for the driver
+ *
+ * @remark The worker owns a hidden GLFW window whose context shares objects with the main one,
+ * so programs linked by the worker can be used directly by the render thread
+ */
+struct CompileService {
+    /**
+     * @brief Creates the shared context and starts the worker thread
+     *
+     * @param main_window_ Window whose context the worker context shares objects with
+     * @param program_cache_ Cache of the linked programs, must outlive the service
+     *
+     * @remark Must be called from the main thread, check IsRunning() for success
+     */
+    explicit CompileService(GLFWwindow* main_window_, ProgramBinaryCache& program_cache_) noexcept;
+
+    CompileService(const CompileService&)             = delete;
+    CompileService& operator= (const CompileService&) = delete;
+
+    ~CompileService();
+
+    bool IsRunning() const noexcept;
+
+    /**
+     * @brief Hands the snapshot to the worker, replacing any request it has not started yet
+     */
+    void Submit(std::unique_ptr<CompileRequest> request_) noexcept;
+
+    /**
+     * @brief Takes the latest finished result, never blocks
+     *
+     * @return Result or nullptr if nothing finished since the last call
+     *
+     * @remark Makes the render context wait for the worker commands, so the program can be used
+     * right away
+     */
+    std::unique_ptr<CompileResult> TakeResult() noexcept;
+
+    /**
+     * @brief Returns the number of the requests replaced by newer ones before compiling
+     */
+    uint64_t GetSupersededCount() const noexcept;
+
+    /**
+     * @brief Returns the number of the compiles stopped before linking because a newer request
+     * arrived
+     */
+    uint64_t GetCancelledCount() const noexcept;
+
+private:
+
+    void WorkerLoop() noexcept;
+
+    std::unique_ptr<CompileResult> Compile(CompileRequest& request_) noexcept;
+
+private:
+    GLFWwindow*         worker_window = nullptr; /**< Hidden window which owns the shared context */
+    ProgramBinaryCache& program_cache;           /**< Cache of the linked programs */
+    std::thread         worker;
+
+    Mailbox<CompileRequest> requests; /**< Latest request which was not started yet */
+    Mailbox<CompileResult>  results;  /**< Latest result which was not taken yet */
+
+    std::mutex              wake_mutex;
+    std::condition_variable wake_condition;
+    bool                    has_work    = false;
+    bool                    is_stopping = false;
+
+    std::atomic<uint64_t> superseded_count = 0;
+    std::atomic<uint64_t> cancelled_count  = 0;
+
+    // Worker thread only
+    Shader vertex_shader;   /**< Worker copy, recompiled only when its code changes */
+    Shader fragment_shader; /**< Worker copy, recompiled only when its code changes */
+};
@@ -0,0 +1,333 @@
+#include "DirectoryWatcher.h"
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                              | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+#endif
+
+}  // namespace
+
+DirectoryWatcher::DirectoryWatcher(Callback                  callback_,
+                                   std::chrono::milliseconds coalesce_delay_,
+                                   std::chrono::milliseconds poll_interval_) noexcept :
+    callback(std::move(callback_)),
+    coalesce_delay(coalesce_delay_),
+    poll_interval(poll_interval_)
+{
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) { LOG_WARN("inotify is not available, directories will be polled"); }
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+
+    worker = std::thread(&DirectoryWatcher::WorkerLoop, this);
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    {
+        std::lock_guard lock(mutex);
+        is_stopping = true;
+    }
+    wake_condition.notify_one();
+
+#ifdef __linux__
+    if (wake_fd >= 0)
+    {
+        const uint64_t value = 1;
+        [[maybe_unused]] auto written = write(wake_fd, &value, sizeof(value));
+    }
+#endif
+
+    if (worker.joinable()) { worker.join(); }
+
+#ifdef __linux__
+    if (inotify_fd >= 0) { close(inotify_fd); }
+    if (wake_fd >= 0) { close(wake_fd); }
+#endif
+}
+
+bool DirectoryWatcher::Watch(std::string_view directory_path_) noexcept
+{
+    std::string directory(directory_path_);
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error))
+    {
+        LOG_ERROR("Can not watch, directory does not exist: {}", directory);
+        return false;
+    }
+
+    std::lock_guard lock(mutex);
+
+#ifdef __linux__
+    if (inotify_fd >= 0)
+    {
+        const int watch = inotify_add_watch(inotify_fd, directory.c_str(), WATCH_MASK);
+        if (watch >= 0)
+        {
+            native_directories[watch] = std::move(directory);
+            return true;
+        }
+
+        LOG_WARN("inotify can not watch {} ({}), polling it instead", directory, strerror(errno));
+    }
+#endif
+
+    polled_directories.emplace(std::move(directory), std::nullopt);
+    wake_condition.notify_one();
+
+#ifdef __linux__
+    if (wake_fd >= 0)  // The worker may sleep without a timeout, it must start polling now
+    {
+        const uint64_t value = 1;
+        [[maybe_unused]] auto written = write(wake_fd, &value, sizeof(value));
+    }
+#endif
+
+    return true;
+}
+
+void DirectoryWatcher::Unwatch(std::string_view directory_path_) noexcept
+{
+    std::lock_guard lock(mutex);
+
+    for (auto it = native_directories.begin(); it != native_directories.end(); ++it)
+    {
+        if (it->second != directory_path_) { continue; }
+
+#ifdef __linux__
+        inotify_rm_watch(inotify_fd, it->first);
+#endif
+        native_directories.erase(it);
+        break;
+    }
+
+    polled_directories.erase(std::string(directory_path_));
+}
+
+bool DirectoryWatcher::IsNative() const noexcept
+{
+    std::lock_guard lock(mutex);
+    return inotify_fd >= 0 && polled_directories.empty();
+}
+
+void DirectoryWatcher::WorkerLoop() noexcept
+{
+    std::set<std::string> changed_paths;
+    bool                  is_lost = false;
+
+    auto next_poll = Clock::now();
+
+    while (!is_stopping)
+    {
+        bool has_polled_directories = false;
+        {
+            std::lock_guard lock(mutex);
+            has_polled_directories = !polled_directories.empty();
+        }
+
+        std::optional<std::chrono::milliseconds> timeout;
+        if (has_polled_directories)
+        {
+            timeout = std::max(std::chrono::milliseconds(0),
+                               std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   next_poll - Clock::now()));
+        }
+
+        WaitForEvents(timeout);
+        if (is_stopping) { break; }
+
+        is_lost |= !ReadNativeEvents(changed_paths);
+
+        // Keep collecting, an editor usually saves with several writes or a write and a rename
+        if (!changed_paths.empty() && coalesce_delay.count() > 0)
+        {
+            const auto deadline = Clock::now() + coalesce_delay;
+            for (auto now = Clock::now(); now < deadline && !is_stopping; now = Clock::now())
+            {
+                WaitForEvents(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now)
+                              + std::chrono::milliseconds(1));
+                is_lost |= !ReadNativeEvents(changed_paths);
+            }
+        }
+
+        if (has_polled_directories && Clock::now() >= next_poll)
+        {
+            ScanPolledDirectories(changed_paths);
+            next_poll = Clock::now() + poll_interval;
+        }
+
+        if (is_stopping) { break; }
+
+        if (is_lost)
+        {
+            callback({});
+        }
+        else if (!changed_paths.empty())
+        {
+            callback(std::vector<std::string>(changed_paths.begin(), changed_paths.end()));
+        }
+
+        changed_paths.clear();
+        is_lost = false;
+    }
+}
+
+void DirectoryWatcher::WaitForEvents(std::optional<std::chrono::milliseconds> timeout_) noexcept
+{
+#ifdef __linux__
+    if (wake_fd >= 0)
+    {
+        std::array<pollfd, 2> fds {};
+        fds[0].fd     = inotify_fd;  // poll() skips negative descriptors
+        fds[0].events = POLLIN;
+        fds[1].fd     = wake_fd;
+        fds[1].events = POLLIN;
+
+        const int timeout_ms = timeout_ ? static_cast<int>(timeout_->count()) : -1;
+        if (poll(fds.data(), fds.size(), timeout_ms) > 0 && (fds[1].revents & POLLIN))
+        {
+            uint64_t value = 0;
+            [[maybe_unused]] auto read_size = read(wake_fd, &value, sizeof(value));
+        }
+        return;
+    }
+#endif
+
+    std::unique_lock lock(mutex);
+    if (timeout_)
+    {
+        wake_condition.wait_for(lock, *timeout_, [this] { return is_stopping.load(); });
+    }
+    else
+    {
+        wake_condition.wait(lock,
+                            [this] { return is_stopping.load() || !polled_directories.empty(); });
+    }
+}
+
+bool DirectoryWatcher::ReadNativeEvents(std::set<std::string>& changed_paths_) noexcept
+{
+#ifdef __linux__
+    if (inotify_fd < 0) { return true; }
+
+    alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+
+    bool is_complete = true;
+
+    for (;;)
+    {
+        const ssize_t length = read(inotify_fd, buffer.data(), buffer.size());
+        if (length <= 0) { break; }  // EAGAIN, everything is read
+
+        std::lock_guard lock(mutex);
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                is_complete = false;
+                continue;
+            }
+
+            auto it = native_directories.find(event->wd);
+            if (it == native_directories.end()) { continue; }
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                changed_paths_.insert(it->second);
+                if (event->mask & IN_IGNORED) { native_directories.erase(it); }
+                continue;
+            }
+
+            if (event->len > 0) { changed_paths_.insert(it->second + "/" + event->name); }
+        }
+    }
+
+    return is_complete;
+#else
+    (void)changed_paths_;
+    return true;
+#endif
+}
+
+void DirectoryWatcher::ScanPolledDirectories(std::set<std::string>& changed_paths_) noexcept
+{
+    std::vector<std::string> directories;
+    {
+        std::lock_guard lock(mutex);
+        for (const auto& [directory, state] : polled_directories)
+        {
+            directories.push_back(directory);
+        }
+    }
+
+    // Scanning without the lock, Watch() must not wait for the file system
+    for (const auto& directory : directories)
+    {
+        auto current = ScanDirectory(directory);
+
+        std::lock_guard lock(mutex);
+
+        auto it = polled_directories.find(directory);
+        if (it == polled_directories.end()) { continue; }  // Unwatched during the scan
+
+        if (it->second)  // The first scan only records the state
+        {
+            const auto& previous = *it->second;
+
+            for (const auto& [path, entry] : current)
+            {
+                auto previous_it = previous.find(path);
+                if (previous_it == previous.end() || previous_it->second != entry)
+                {
+                    changed_paths_.insert(path);
+                }
+            }
+
+            for (const auto& [path, entry] : previous)
+            {
+                if (!current.contains(path)) { changed_paths_.insert(path); }
+            }
+        }
+
+        it->second = std::move(current);
+    }
+}
+
+DirectoryWatcher::DirectoryState DirectoryWatcher::ScanDirectory(
+    const std::string& directory_path_) noexcept
+{
+    DirectoryState state;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory_path_, error), end; !error && it != end;
+         it.increment(error))
+    {
+        std::error_code entry_error;  // Entry removed during the scan, recorded as it is
+
+        EntryState entry;
+        entry.write_time = it->last_write_time(entry_error);
+        entry.size       = it->is_regular_file(entry_error) ? it->file_size(entry_error) : 0;
+
+        auto path = it->path().string();
+        std::replace(path.begin(), path.end(), '\\', '/');
+        state.emplace(std::move(path), entry);
+    }
+
+    return state;
+}
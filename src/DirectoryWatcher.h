@@ -0,0 +1,106 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Watches directories for created, modified, moved and removed files on a worker thread
+ *
+ * @remark Uses inotify on Linux. Other platforms, and directories inotify refuses to watch (e.g.
+ * when the watch limit is reached), are polled by comparing the modification times and sizes of
+ * their entries.
+ */
+struct DirectoryWatcher {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Called on the worker thread with the full paths of the changed entries
+     *
+     * @remark An empty vector means the events were lost and every directory must be rescanned
+     */
+    using Callback = std::function<void(const std::vector<std::string>& changed_paths_)>;
+
+    static constexpr std::chrono::milliseconds DEFAULT_POLL_INTERVAL { 1000 };
+
+    /**
+     * @param callback_ Receiver of the changes
+     * @param coalesce_delay_ Time to keep collecting after the first event before reporting, so a
+     * burst of writes is reported once
+     * @param poll_interval_ Interval between the scans of the polled directories
+     */
+    explicit DirectoryWatcher(
+        Callback                  callback_,
+        std::chrono::milliseconds coalesce_delay_ = std::chrono::milliseconds(0),
+        std::chrono::milliseconds poll_interval_  = DEFAULT_POLL_INTERVAL) noexcept;
+
+    DirectoryWatcher(const DirectoryWatcher&)             = delete;
+    DirectoryWatcher& operator= (const DirectoryWatcher&) = delete;
+
+    ~DirectoryWatcher();
+
+    /**
+     * @brief Starts watching the directory, thread safe
+     *
+     * @param directory_path_ Full path of an existing directory
+     *
+     * @return true if the directory is watched, false if it can not be watched at all
+     */
+    bool Watch(std::string_view directory_path_) noexcept;
+
+    /**
+     * @brief Stops watching the directory, thread safe
+     */
+    void Unwatch(std::string_view directory_path_) noexcept;
+
+    /**
+     * @brief Returns true if the changes come from the OS, false if the directories are polled
+     */
+    bool IsNative() const noexcept;
+
+private:
+
+    struct EntryState {
+        std::filesystem::file_time_type write_time;
+        uintmax_t                       size = 0;
+
+        bool operator== (const EntryState&) const = default;
+    };
+
+    using DirectoryState = std::unordered_map<std::string, EntryState>;
+
+    void WorkerLoop() noexcept;
+
+    /**
+     * @brief Blocks until an OS event arrives, the watcher stops or the timeout expires
+     */
+    void WaitForEvents(std::optional<std::chrono::milliseconds> timeout_) noexcept;
+
+    /**
+     * @brief Reads the pending OS events into the set, never blocks
+     *
+     * @return false if events were lost and everything must be rescanned
+     */
+    bool ReadNativeEvents(std::set<std::string>& changed_paths_) noexcept;
+
+    /**
+     * @brief Scans the polled directories and adds the entries which differ from the last scan
+     */
+    void ScanPolledDirectories(std::set<std::string>& changed_paths_) noexcept;
+
+    static DirectoryState ScanDirectory(const std::string& directory_path_) noexcept;
+
+private:
+    Callback                  callback;
+    std::chrono::milliseconds coalesce_delay;
+    std::chrono::milliseconds poll_interval;
+
+    int inotify_fd = -1; /**< inotify instance, -1 if the directories are polled */
+    int wake_fd    = -1; /**< eventfd which wakes the worker to stop or to start polling */
+
+    mutable std::mutex                                             mutex;
+    std::unordered_map<int, std::string>                           native_directories;
+    std::unordered_map<std::string, std::optional<DirectoryState>> polled_directories;
+
+    std::condition_variable wake_condition; /**< Wakes the worker when there is no eventfd */
+    std::atomic<bool>       is_stopping = false;
+    std::thread             worker;
+};
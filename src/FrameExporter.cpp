@@ -0,0 +1,440 @@
+#include "FrameExporter.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr GLuint64 WAIT_TIMEOUT_NS = 1'000'000'000; /**< Blocking waits retry every second */
+
+/**
+ * @brief The buffers stay mapped, a signaled fence makes the copy visible to the workers
+ */
+constexpr GLbitfield SLOT_FLAGS = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+double GetElapsedMs(Clock::time_point start_) noexcept
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+}
+
+/**
+ * @brief Returns the frame rate of the time step as a fraction, whole rates are exact
+ */
+std::pair<int64_t, int64_t> GetFrameRate(float time_step_) noexcept
+{
+    if (time_step_ <= 0.0f) { return { 60, 1 }; }  // Still frames, any rate plays them
+
+    const double  rate  = 1.0 / time_step_;
+    const int64_t whole = std::llround(rate);
+    if (std::abs(rate - static_cast<double>(whole)) < 0.001) { return { whole, 1 }; }
+
+    const int64_t numerator = std::llround(rate * 1000.0);
+    const int64_t divisor   = std::gcd(numerator, int64_t { 1000 });
+    return { numerator / divisor, 1000 / divisor };
+}
+
+/**
+ * @brief BT.601 limited range, the matrix players assume for Y4M without color tags
+ */
+uint8_t GetLuma(int32_t r_, int32_t g_, int32_t b_) noexcept
+{
+    return static_cast<uint8_t>(((66 * r_ + 129 * g_ + 25 * b_ + 128) >> 8) + 16);
+}
+
+uint8_t GetBlueChroma(int32_t r_, int32_t g_, int32_t b_) noexcept
+{
+    return static_cast<uint8_t>(((-38 * r_ - 74 * g_ + 112 * b_ + 128) >> 8) + 128);
+}
+
+uint8_t GetRedChroma(int32_t r_, int32_t g_, int32_t b_) noexcept
+{
+    return static_cast<uint8_t>(((112 * r_ - 94 * g_ - 18 * b_ + 128) >> 8) + 128);
+}
+
+}  // namespace
+
+FrameExporter::FrameExporter() noexcept : workers(ThreadPool::GetDefaultThreadCount()) {}
+
+FrameExporter::~FrameExporter()
+{
+    if (!slots.empty()) { Finish(); }
+}
+
+bool FrameExporter::Begin(const FrameExportSettings& settings_) noexcept
+{
+    if (!slots.empty()) { Finish(); }
+
+    if (settings_.width <= 0 || settings_.height <= 0 || settings_.frame_count <= 0
+        || settings_.time_step < 0.0f)
+    {
+        LOG_ERROR("Invalid export of {} frames of {}x{}",
+                  settings_.frame_count,
+                  settings_.width,
+                  settings_.height);
+        return false;
+    }
+
+    settings         = settings_;
+    frame_size       = static_cast<size_t>(settings.width) * settings.height * 4;
+    next_frame       = 0;
+    next_slot        = 0;
+    next_video_frame = 0;
+
+    {
+        std::lock_guard lock(mutex);
+        stats = {};
+    }
+
+    if (settings.output_format != FrameOutputFormat::NONE)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(settings.output_directory, error);
+        if (error)
+        {
+            LOG_ERROR("Failed to create the output directory {}: {}",
+                      settings.output_directory,
+                      error.message());
+            return false;
+        }
+    }
+
+    if (settings.output_format == FrameOutputFormat::Y4M)
+    {
+        const auto path = fmt::format("{}/video.y4m", settings.output_directory);
+
+        video_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!video_file)
+        {
+            LOG_ERROR("Failed to open {}", path);
+            return false;
+        }
+
+        // The chroma is averaged over 2x2 pixels, so it sits in their center like in JPEG
+        const auto [rate_numerator, rate_denominator] = GetFrameRate(settings.time_step);
+        video_file << fmt::format("YUV4MPEG2 W{} H{} F{}:{} Ip A1:1 C420jpeg "
+                                  "XCOLORRANGE=LIMITED\n",
+                                  settings.width,
+                                  settings.height,
+                                  rate_numerator,
+                                  rate_denominator);
+    }
+
+    // Set once before any worker runs, the flag of stb is a global
+    stbi_flip_vertically_on_write(1);
+
+    CreateSlots();
+    if (slots.empty())
+    {
+        video_file.close();
+        return false;
+    }
+
+    start        = Clock::now();
+    is_exporting = true;
+
+    LOG_INFO("Exporting {} frames of {}x{} to {} with {} pixel buffers",
+             settings.frame_count,
+             settings.width,
+             settings.height,
+             settings.output_directory,
+             slots.size());
+
+    return true;
+}
+
+bool FrameExporter::IsExporting() const noexcept { return is_exporting; }
+
+int32_t FrameExporter::GetNextFrame() const noexcept { return next_frame; }
+
+const FrameExportSettings& FrameExporter::GetSettings() const noexcept { return settings; }
+
+void FrameExporter::Capture(GLuint texture_) noexcept
+{
+    if (!is_exporting) { return; }
+
+    // The slot of the oldest frame is reused, that frame must be on its way to the disk
+    Slot&      slot       = slots[next_slot];
+    const auto wait_start = Clock::now();
+    bool       is_stalled = false;
+
+    if (slot.fence && !Dispatch(slot, false))
+    {
+        is_stalled = true;
+        Dispatch(slot, true);
+    }
+
+    {
+        std::unique_lock lock(mutex);
+        if (slot.is_writing)
+        {
+            is_stalled = true;
+            slot_condition.wait(lock, [&slot] { return !slot.is_writing; });
+        }
+
+        if (is_stalled)
+        {
+            ++stats.stalls;
+            stats.stall_ms += GetElapsedMs(wait_start);
+        }
+
+        ++stats.captured_frames;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glGetTextureImage(
+        texture_, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(frame_size), nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = next_frame++;
+
+    next_slot    = (next_slot + 1) % slots.size();
+    is_exporting = next_frame < settings.frame_count;
+}
+
+void FrameExporter::Update() noexcept
+{
+    // Handed over in frame order, the Y4M workers append in that order and must not wait for a
+    // frame which is not queued yet
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        Slot& slot = slots[(next_slot + i) % slots.size()];
+        if (slot.fence && !Dispatch(slot, false)) { return; }
+    }
+}
+
+bool FrameExporter::Finish() noexcept
+{
+    if (slots.empty()) { return false; }  // Not started, or already finished
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        Slot& slot = slots[(next_slot + i) % slots.size()];
+        if (slot.fence) { Dispatch(slot, true); }
+    }
+
+    workers.Wait();
+    DeleteSlots();
+
+    is_exporting = false;
+
+    std::lock_guard lock(mutex);
+    if (video_file.is_open()) { video_file.close(); }
+
+    LOG_INFO("Exported {} of {} frames in {:.3f} ms, {:.2f} frames per second, {} stalls "
+             "({:.3f} ms)",
+             stats.written_frames,
+             stats.captured_frames,
+             stats.elapsed_ms,
+             stats.GetFramesPerSecond(),
+             stats.stalls,
+             stats.stall_ms);
+
+    if (stats.failed_writes > 0)
+    {
+        LOG_ERROR(
+            "Failed to write {} frames to {}", stats.failed_writes, settings.output_directory);
+    }
+
+    return stats.failed_writes == 0 && stats.written_frames == stats.captured_frames;
+}
+
+FrameExportStats FrameExporter::GetStats() const noexcept
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+bool FrameExporter::Dispatch(Slot& slot_, bool is_blocking_) noexcept
+{
+    GLenum result = glClientWaitSync(slot_.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (is_blocking_ && result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(slot_.fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+    }
+
+    if (result == GL_TIMEOUT_EXPIRED) { return false; }
+
+    // Still written, a gap would stop the Y4M workers waiting for this frame
+    if (result == GL_WAIT_FAILED) { LOG_ERROR("Failed to wait for the readback of a frame"); }
+
+    glDeleteSync(slot_.fence);
+    slot_.fence = nullptr;
+
+    {
+        std::lock_guard lock(mutex);
+        slot_.is_writing = true;
+    }
+
+    workers.Submit(
+        [this, &slot_]
+        {
+            const auto write_start = Clock::now();
+            const bool is_written  = Write(slot_);
+
+            {
+                std::lock_guard lock(mutex);
+                stats.write_ms   += GetElapsedMs(write_start);
+                stats.elapsed_ms  = GetElapsedMs(start);
+                if (is_written) { ++stats.written_frames; }
+                else { ++stats.failed_writes; }
+
+                slot_.is_writing = false;
+            }
+
+            slot_condition.notify_all();
+        });
+
+    return true;
+}
+
+bool FrameExporter::Write(Slot& slot_) noexcept
+{
+    const auto*  pixels   = static_cast<const uint8_t*>(slot_.mapped);
+    const size_t row_size = static_cast<size_t>(settings.width) * 4;
+
+    if (settings.output_format == FrameOutputFormat::PNG)
+    {
+        const auto path = fmt::format("{}/frame_{:05}.png", settings.output_directory, slot_.frame);
+
+        // Pixels are read bottom row first, PNG starts with the top row
+        return stbi_write_png(path.c_str(),
+                              settings.width,
+                              settings.height,
+                              4,
+                              pixels,
+                              static_cast<int>(row_size))
+            != 0;
+    }
+
+    if (settings.output_format == FrameOutputFormat::RAW)
+    {
+        const auto path =
+            fmt::format("{}/frame_{:05}.rgba", settings.output_directory, slot_.frame);
+
+        std::ofstream out_file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out_file) { return false; }
+
+        for (int32_t row = settings.height - 1; row >= 0; --row)
+        {
+            out_file.write(reinterpret_cast<const char*>(pixels + row * row_size),
+                           static_cast<std::streamsize>(row_size));
+        }
+
+        return out_file.good();
+    }
+
+    if (settings.output_format == FrameOutputFormat::Y4M)
+    {
+        ConvertToYuv(pixels, slot_.converted);
+
+        std::unique_lock lock(mutex);
+        video_condition.wait(lock, [this, &slot_] { return next_video_frame == slot_.frame; });
+
+        video_file << "FRAME\n";
+        video_file.write(reinterpret_cast<const char*>(slot_.converted.data()),
+                         static_cast<std::streamsize>(slot_.converted.size()));
+
+        ++next_video_frame;
+        video_condition.notify_all();
+
+        return video_file.good();
+    }
+
+    return true;
+}
+
+void FrameExporter::ConvertToYuv(const uint8_t* pixels_, std::vector<uint8_t>& yuv_) const noexcept
+{
+    const int32_t width         = settings.width;
+    const int32_t height        = settings.height;
+    const int32_t chroma_width  = (width + 1) / 2;
+    const int32_t chroma_height = (height + 1) / 2;
+    const size_t  luma_size     = static_cast<size_t>(width) * height;
+    const size_t  chroma_size   = static_cast<size_t>(chroma_width) * chroma_height;
+    const size_t  row_size      = static_cast<size_t>(width) * 4;
+
+    yuv_.resize(luma_size + chroma_size * 2);
+
+    uint8_t* luma_plane = yuv_.data();
+    uint8_t* blue_plane = luma_plane + luma_size;
+    uint8_t* red_plane  = blue_plane + chroma_size;
+
+    // Y4M starts with the top row, the pixels with the bottom one
+    const auto get_pixel = [&](int32_t x_, int32_t y_)
+    {
+        return pixels_ + static_cast<size_t>(height - 1 - y_) * row_size + x_ * 4;
+    };
+
+    for (int32_t y = 0; y < height; ++y)
+    {
+        for (int32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* pixel = get_pixel(x, y);
+            *luma_plane++        = GetLuma(pixel[0], pixel[1], pixel[2]);
+        }
+    }
+
+    // Odd sizes repeat the last column and row
+    for (int32_t y = 0; y < chroma_height; ++y)
+    {
+        for (int32_t x = 0; x < chroma_width; ++x)
+        {
+            int32_t r = 0;
+            int32_t g = 0;
+            int32_t b = 0;
+
+            for (int32_t i = 0; i < 4; ++i)
+            {
+                const uint8_t* pixel = get_pixel(std::min(x * 2 + i % 2, width - 1),
+                                                 std::min(y * 2 + i / 2, height - 1));
+                r += pixel[0];
+                g += pixel[1];
+                b += pixel[2];
+            }
+
+            r = (r + 2) / 4;
+            g = (g + 2) / 4;
+            b = (b + 2) / 4;
+
+            *blue_plane++ = GetBlueChroma(r, g, b);
+            *red_plane++  = GetRedChroma(r, g, b);
+        }
+    }
+}
+
+void FrameExporter::CreateSlots() noexcept
+{
+    // One slot per worker, one being read back and one being drawn into
+    const size_t slot_count =
+        std::clamp(workers.GetThreadCount() + 2, MIN_SLOT_COUNT, MAX_SLOT_COUNT);
+
+    slots.resize(slot_count);
+    for (auto& slot : slots)
+    {
+        glCreateBuffers(1, &slot.buffer);
+        glNamedBufferStorage(
+            slot.buffer, static_cast<GLsizeiptr>(frame_size), nullptr, SLOT_FLAGS);
+        slot.mapped = glMapNamedBufferRange(
+            slot.buffer, 0, static_cast<GLsizeiptr>(frame_size), SLOT_FLAGS);
+
+        if (!slot.mapped)
+        {
+            LOG_ERROR("Failed to map an export pixel buffer of {} bytes", frame_size);
+            DeleteSlots();
+            return;
+        }
+    }
+}
+
+void FrameExporter::DeleteSlots() noexcept
+{
+    for (auto& slot : slots)
+    {
+        if (slot.fence) { glDeleteSync(slot.fence); }
+        if (slot.mapped) { glUnmapNamedBuffer(slot.buffer); }
+        if (slot.buffer) { glDeleteBuffers(1, &slot.buffer); }
+    }
+
+    slots.clear();
+}
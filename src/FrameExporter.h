@@ -0,0 +1,169 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "ThreadPool.h"
+
+/**
+ * @brief Format of the exported frames
+ */
+enum class FrameOutputFormat {
+    NONE, /**< Frames are rendered but not written, for timing only */
+    PNG,  /**< One PNG file per frame */
+    RAW,  /**< One file per frame with tightly packed RGBA8 rows, top row first */
+    Y4M   /**< One YUV4MPEG2 video (4:2:0, BT.601 limited range) with all frames */
+};
+
+/**
+ * @brief Frames to export and where to write them
+ */
+struct FrameExportSettings {
+    std::string       output_directory = "frames";     /**< Relative to the working directory */
+    FrameOutputFormat output_format    = FrameOutputFormat::PNG;
+    int32_t           width            = 1920;         /**< Width of the frames in pixels */
+    int32_t           height           = 1080;         /**< Height of the frames in pixels */
+    int32_t           frame_count      = 1;            /**< Number of the exported frames */
+    float             start_time       = 0.0f;         /**< iTime of the first frame */
+    float             time_step        = 1.0f / 60.0f; /**< Fixed iTimeDelta in seconds */
+};
+
+/**
+ * @brief Counters of the export in progress or of the last one
+ */
+struct FrameExportStats {
+    int32_t captured_frames = 0;   /**< Frames whose readback was queued */
+    int32_t written_frames  = 0;   /**< Frames written to the disk */
+    int32_t failed_writes   = 0;   /**< Frames which failed to write, see the log */
+    int32_t stalls          = 0;   /**< Captures which waited for a readback or a write */
+    double  stall_ms        = 0.0; /**< Time the render thread spent in those waits */
+    double  write_ms        = 0.0; /**< Time the workers spent converting and writing */
+    double  elapsed_ms      = 0.0; /**< From Begin() to the last written frame */
+
+    /**
+     * @brief Returns the throughput of the export in written frames per second
+     */
+    double GetFramesPerSecond() const noexcept
+    {
+        return elapsed_ms > 0.0 ? written_frames * 1000.0 / elapsed_ms : 0.0;
+    }
+};
+
+/**
+ * @brief Reads rendered frames back without stalling the GPU and writes them on worker threads
+ *
+ * @remark Every capture copies the texture into the next of a ring of persistently mapped pixel
+ * buffers and puts a fence behind the copy. Once the fence is signaled the mapped memory is
+ * handed to a worker, which encodes the frame straight from it and releases the slot. The
+ * render thread waits only when all slots are busy, so nothing is dropped: a slow disk slows
+ * the export down instead. Y4M frames are converted in parallel and appended in frame order.
+ */
+struct FrameExporter {
+    static constexpr size_t MIN_SLOT_COUNT = 3;
+    static constexpr size_t MAX_SLOT_COUNT = 8; /**< Limits the mapped memory of 4K exports */
+
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit FrameExporter() noexcept;
+
+    FrameExporter(const FrameExporter&)             = delete;
+    FrameExporter& operator= (const FrameExporter&) = delete;
+
+    /**
+     * @brief Finishes the export in progress
+     */
+    ~FrameExporter();
+
+    /**
+     * @brief Starts an export, a running one is finished first
+     *
+     * @return true if the output is created and the pixel buffers are allocated, false otherwise
+     */
+    bool Begin(const FrameExportSettings& settings_) noexcept;
+
+    /**
+     * @brief Returns true from Begin() until all frames are captured
+     */
+    bool IsExporting() const noexcept;
+
+    /**
+     * @brief Returns the index of the next captured frame, its iTime is start_time + index *
+     * time_step
+     */
+    int32_t GetNextFrame() const noexcept;
+
+    const FrameExportSettings& GetSettings() const noexcept;
+
+    /**
+     * @brief Queues the readback of the next frame from an RGBA8 texture of the export size
+     */
+    void Capture(GLuint texture_) noexcept;
+
+    /**
+     * @brief Hands the readbacks which are ready to the workers, never waits
+     */
+    void Update() noexcept;
+
+    /**
+     * @brief Waits for all readbacks and writes and closes the output
+     *
+     * @return true if every frame was written, false otherwise or if no export was started
+     */
+    bool Finish() noexcept;
+
+    FrameExportStats GetStats() const noexcept;
+
+private:
+
+    /**
+     * @brief Pixel buffer of the ring, owned by the render thread while reading back and by a
+     * worker while writing
+     */
+    struct Slot {
+        GLuint               buffer     = 0;
+        void*                mapped     = nullptr;
+        GLsync               fence      = nullptr; /**< Signaled when the copy is done */
+        int32_t              frame      = -1;
+        bool                 is_writing = false;   /**< Guarded by the mutex */
+        std::vector<uint8_t> converted;            /**< Y4M frame, reused by the worker */
+    };
+
+    /**
+     * @brief Hands the slot to a worker, waiting for its fence first if is_blocking_
+     *
+     * @return true if the slot was handed over, false if its copy is not done yet
+     */
+    bool Dispatch(Slot& slot_, bool is_blocking_) noexcept;
+
+    /**
+     * @brief Encodes the frame of the slot and writes it, runs on a worker
+     */
+    bool Write(Slot& slot_) noexcept;
+
+    /**
+     * @brief Converts the bottom-up RGBA8 frame into a Y4M frame, runs on a worker
+     */
+    void ConvertToYuv(const uint8_t* pixels_, std::vector<uint8_t>& yuv_) const noexcept;
+
+    void CreateSlots() noexcept;
+    void DeleteSlots() noexcept;
+
+private:
+    FrameExportSettings settings;
+    bool                is_exporting = false;
+    int32_t             next_frame   = 0;
+    size_t              frame_size   = 0; /**< Bytes of one RGBA8 frame */
+    size_t              next_slot    = 0; /**< Oldest slot, the next one to capture into */
+
+    std::vector<Slot>                     slots;
+    std::chrono::steady_clock::time_point start; /**< Of Begin() */
+
+    mutable std::mutex      mutex;
+    std::condition_variable slot_condition;  /**< Signaled when a worker releases a slot */
+    std::condition_variable video_condition; /**< Signaled when a Y4M frame is appended */
+    std::ofstream           video_file;      /**< Y4M output, guarded by the mutex */
+    int32_t                 next_video_frame = 0;
+    FrameExportStats        stats;
+
+    ThreadPool workers; /**< Declared last, finishes its jobs before the other members go */
+};
@@ -0,0 +1,151 @@
+#include "FramePacer.h"
+
+namespace {
+
+double GetMs(FramePacer::Clock::duration duration_) noexcept
+{
+    return std::chrono::duration<double, std::milli>(duration_).count();
+}
+
+}  // namespace
+
+double FramePacingStats::GetFrameStdDevMs() const noexcept
+{
+    const uint64_t count = frame_times.GetCount();
+    if (count < 2) { return 0.0; }
+
+    const double mean     = frame_sum_ms / static_cast<double>(count);
+    const double variance = frame_sum_sq / static_cast<double>(count) - mean * mean;
+    return std::sqrt(std::max(variance, 0.0));
+}
+
+FramePacer::FramePacer() noexcept
+{
+    is_adaptive_vsync = glfwExtensionSupported("WGL_EXT_swap_control_tear")
+                     || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+
+    SetMode(mode);
+}
+
+void FramePacer::SetMode(FramePacingMode mode_) noexcept
+{
+    if (mode_ == FramePacingMode::ADAPTIVE_VSYNC && !is_adaptive_vsync)
+    {
+        LOG_WARN("Adaptive vsync is not supported by the driver, using vsync");
+        mode_ = FramePacingMode::VSYNC;
+    }
+
+    mode = mode_;
+
+    switch (mode)
+    {
+        case FramePacingMode::VSYNC :
+            glfwSwapInterval(1);
+            break;
+        case FramePacingMode::ADAPTIVE_VSYNC :
+            glfwSwapInterval(-1);
+            break;
+        default :
+            glfwSwapInterval(0);
+            break;
+    }
+
+    // The first interval would mix the old and the new mode
+    deadline             = Clock::now();
+    is_interval_measured = false;
+}
+
+FramePacingMode FramePacer::GetMode() const noexcept { return mode; }
+
+bool FramePacer::IsAdaptiveVsyncSupported() const noexcept { return is_adaptive_vsync; }
+
+void FramePacer::SetTargetFps(float target_fps_) noexcept
+{
+    target_fps = std::clamp(target_fps_, MIN_TARGET_FPS, MAX_TARGET_FPS);
+}
+
+float FramePacer::GetTargetFps() const noexcept { return target_fps; }
+
+void FramePacer::WaitForFrame() noexcept
+{
+    if (mode != FramePacingMode::LIMITED) { return; }
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / target_fps));
+    const auto spin_margin = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(SPIN_MARGIN_MS));
+
+    auto now = Clock::now();
+    if (now - deadline > period) { deadline = now; }  // Late, the schedule starts again
+
+    if (deadline - now > spin_margin) { std::this_thread::sleep_for(deadline - now - spin_margin); }
+
+    while (Clock::now() < deadline) { std::this_thread::yield(); }
+
+    deadline += period;
+}
+
+void FramePacer::OnInput(Clock::time_point event_time_) noexcept
+{
+    if (is_input_pending) { return; }  // The oldest input waits the longest
+
+    input_time       = event_time_;
+    is_input_pending = true;
+}
+
+void FramePacer::OnFramePresented(bool is_idle_) noexcept
+{
+    const auto now        = Clock::now();
+    auto&      mode_stats = stats[static_cast<size_t>(mode)];
+
+    if (is_interval_measured)
+    {
+        const double frame_ms = GetMs(now - last_present);
+
+        mode_stats.frame_times.Add(static_cast<float>(frame_ms));
+        mode_stats.frame_sum_ms += frame_ms;
+        mode_stats.frame_sum_sq += frame_ms * frame_ms;
+    }
+
+    if (is_input_pending)
+    {
+        mode_stats.input_latencies.Add(static_cast<float>(GetMs(now - input_time)));
+        is_input_pending = false;
+    }
+
+    last_present         = now;
+    is_interval_measured = !is_idle_;
+}
+
+const FramePacingStats& FramePacer::GetStats(FramePacingMode mode_) const noexcept
+{
+    return stats[static_cast<size_t>(mode_)];
+}
+
+void FramePacer::ResetStats() noexcept
+{
+    for (auto& mode_stats : stats)
+    {
+        mode_stats.frame_times.Clear();
+        mode_stats.input_latencies.Clear();
+        mode_stats.frame_sum_ms = 0.0;
+        mode_stats.frame_sum_sq = 0.0;
+    }
+}
+
+const char* FramePacer::GetModeName(FramePacingMode mode_) noexcept
+{
+    switch (mode_)
+    {
+        case FramePacingMode::UNCAPPED :
+            return "Uncapped";
+        case FramePacingMode::VSYNC :
+            return "Vsync";
+        case FramePacingMode::ADAPTIVE_VSYNC :
+            return "Adaptive Vsync";
+        case FramePacingMode::LIMITED :
+            return "Limited";
+        default :
+            return "Unknown";
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "FrameStats.h"
+
+enum class FramePacingMode : uint8_t {
+    UNCAPPED,       /**< No vsync, frames are presented as fast as they are drawn */
+    VSYNC,          /**< Swap interval 1, one frame per refresh */
+    ADAPTIVE_VSYNC, /**< Swap interval -1, late frames tear instead of waiting a refresh */
+    LIMITED,        /**< No vsync, the CPU waits for the target frame rate */
+    COUNT           /**< Total number of the modes */
+};
+
+/**
+ * @brief Frame times and input latencies measured while one pacing mode was active
+ */
+struct FramePacingStats {
+    FrameTimeHistogram frame_times;        /**< Between two presents */
+    FrameTimeHistogram input_latencies;    /**< From a polled input to the next present */
+    double             frame_sum_ms = 0.0;
+    double             frame_sum_sq = 0.0; /**< Sum of the squared frame times */
+
+    /**
+     * @brief Returns the standard deviation of the frame times in milliseconds
+     */
+    double GetFrameStdDevMs() const noexcept;
+};
+
+/**
+ * @brief Paces the frames of the window with the swap interval or a CPU frame limiter and
+ * measures the frame time variance and the input latency of every mode
+ *
+ * @remark The limiter waits at the start of the frame rather than before the swap, so the input
+ * is polled and drawn right before the present instead of waiting a frame in between. It sleeps
+ * until SPIN_MARGIN_MS before the deadline, because sleeps overshoot by up to a scheduler tick,
+ * and spins the rest. A frame which is late by more than a period restarts the schedule instead
+ * of rushing the following frames.
+ */
+struct FramePacer {
+    static constexpr float  MIN_TARGET_FPS = 10.0f;
+    static constexpr float  MAX_TARGET_FPS = 1000.0f;
+    static constexpr double SPIN_MARGIN_MS = 2.0; /**< Spun, not slept, before the deadline */
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @remark Must be created with the context of the window current
+     */
+    explicit FramePacer() noexcept;
+
+    FramePacer(const FramePacer&)             = delete;
+    FramePacer& operator= (const FramePacer&) = delete;
+
+    /**
+     * @brief Sets the mode and its swap interval, adaptive vsync falls back to vsync where the
+     * driver lacks the swap control tear extension
+     */
+    void            SetMode(FramePacingMode mode_) noexcept;
+    FramePacingMode GetMode() const noexcept;
+
+    bool IsAdaptiveVsyncSupported() const noexcept;
+
+    /**
+     * @brief Sets the frame rate of the limited mode
+     */
+    void  SetTargetFps(float target_fps_) noexcept;
+    float GetTargetFps() const noexcept;
+
+    /**
+     * @brief Waits until the frame may start, only in the limited mode
+     */
+    void WaitForFrame() noexcept;
+
+    /**
+     * @brief Records that input was polled, the latency is measured to the next present
+     *
+     * @param event_time_ Arrival of the oldest of the polled events
+     */
+    void OnInput(Clock::time_point event_time_) noexcept;
+
+    /**
+     * @brief Measures the frame time and the latency of the pending input, call after the swap
+     *
+     * @param is_idle_ Flag indicating if the loop sleeps for events before the next frame, the
+     * interval is then not measured
+     */
+    void OnFramePresented(bool is_idle_) noexcept;
+
+    const FramePacingStats& GetStats(FramePacingMode mode_) const noexcept;
+
+    void ResetStats() noexcept;
+
+    static const char* GetModeName(FramePacingMode mode_) noexcept;
+
+private:
+    FramePacingMode mode                 = FramePacingMode::VSYNC;
+    float           target_fps           = 60.0f;
+    bool            is_adaptive_vsync    = false; /**< Swap control tear is supported */
+    bool            is_interval_measured = false; /**< The last present starts a measured frame */
+    bool            is_input_pending     = false;
+
+    Clock::time_point deadline;   /**< Earliest start of the next limited frame */
+    Clock::time_point last_present;
+    Clock::time_point input_time; /**< Of the oldest input not presented yet */
+
+    std::array<FramePacingStats, static_cast<size_t>(FramePacingMode::COUNT)> stats;
+};
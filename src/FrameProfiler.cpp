@@ -0,0 +1,172 @@
+#include "FrameProfiler.h"
+
+FrameProfiler::FrameProfiler() noexcept
+{
+    for (auto& query_set : query_sets)
+    {
+        glGenQueries(static_cast<GLsizei>(query_set.queries.size()), query_set.queries.data());
+    }
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    for (auto& query_set : query_sets)
+    {
+        glDeleteQueries(static_cast<GLsizei>(query_set.queries.size()), query_set.queries.data());
+    }
+}
+
+void FrameProfiler::SetEnabled(bool is_enabled_) noexcept
+{
+    is_enabled  = is_enabled_;
+    is_in_frame = false;
+
+    // Results of the frames before the pause would land in the wrong place of the history
+    for (auto& query_set : query_sets) { query_set.is_pending = false; }
+}
+
+bool FrameProfiler::IsEnabled() const noexcept { return is_enabled; }
+
+void FrameProfiler::BeginFrame() noexcept
+{
+    if (!is_enabled) { return; }
+
+    // The set was recorded QUERY_FRAME_COUNT frames ago, its results are usually ready by now
+    auto& query_set = query_sets[frame % QUERY_FRAME_COUNT];
+    if (query_set.is_pending) { CollectQuerySet(query_set); }
+
+    query_set.is_recorded.fill(false);
+    query_set.frame = frame;
+
+    current     = FrameTimings {};
+    is_in_frame = true;
+
+    stage_depths.fill(0);  // A stage left open by the last frame is not ended in this one
+}
+
+void FrameProfiler::EndFrame() noexcept
+{
+    if (!is_in_frame) { return; }
+
+    auto& query_set      = query_sets[frame % QUERY_FRAME_COUNT];
+    query_set.is_pending = std::any_of(query_set.is_recorded.begin(),
+                                       query_set.is_recorded.end(),
+                                       [](bool is_recorded) { return is_recorded; });
+
+    history[frame % HISTORY_SIZE] = current;
+    history_count                 = std::min(history_count + 1, HISTORY_SIZE);
+
+    ++frame;
+    is_in_frame = false;
+}
+
+void FrameProfiler::BeginStage(ProfileStage stage_) noexcept
+{
+    if (!is_in_frame) { return; }
+
+    const auto index     = static_cast<size_t>(stage_);
+    auto&      query_set = query_sets[frame % QUERY_FRAME_COUNT];
+
+    // Only the outermost begin of the first span of the frame writes the queries
+    if (stage_depths[index]++ > 0) { return; }
+
+    is_stage_timed[index] = !query_set.is_recorded[index];
+    if (!is_stage_timed[index]) { return; }
+
+    stage_starts[index] = Clock::now();
+
+    glQueryCounter(query_set.queries[index * 2], GL_TIMESTAMP);
+}
+
+void FrameProfiler::EndStage(ProfileStage stage_) noexcept
+{
+    if (!is_in_frame) { return; }
+
+    const auto index     = static_cast<size_t>(stage_);
+    auto&      query_set = query_sets[frame % QUERY_FRAME_COUNT];
+
+    if (stage_depths[index] == 0) { return; }  // Begun before the frame or not at all
+    if (--stage_depths[index] > 0 || !is_stage_timed[index]) { return; }
+
+    glQueryCounter(query_set.queries[index * 2 + 1], GL_TIMESTAMP);
+    query_set.is_recorded[index] = true;
+
+    current.cpu_ms[index] +=
+        std::chrono::duration<float, std::milli>(Clock::now() - stage_starts[index]).count();
+}
+
+const FrameTimings& FrameProfiler::GetHistory(size_t age_) const noexcept
+{
+    return history[(frame - 1 - age_) % HISTORY_SIZE];
+}
+
+size_t FrameProfiler::GetHistoryCount() const noexcept { return history_count; }
+
+FrameTimings FrameProfiler::GetAverage(size_t frame_count_) const noexcept
+{
+    FrameTimings average;
+
+    const size_t count     = std::min(frame_count_, history_count);
+    size_t       gpu_count = 0;
+
+    for (size_t age = 0; age < count; ++age)
+    {
+        const auto& timings = GetHistory(age);
+
+        for (size_t i = 0; i < STAGE_COUNT; ++i)
+        {
+            average.cpu_ms[i] += timings.cpu_ms[i];
+            if (timings.has_gpu) { average.gpu_ms[i] += timings.gpu_ms[i]; }
+        }
+
+        if (timings.has_gpu) { ++gpu_count; }
+    }
+
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (count) { average.cpu_ms[i] /= count; }
+        if (gpu_count) { average.gpu_ms[i] /= gpu_count; }
+    }
+
+    average.has_gpu = gpu_count > 0;
+    return average;
+}
+
+uint64_t FrameProfiler::GetDroppedCount() const noexcept { return dropped_count; }
+
+void FrameProfiler::CollectQuerySet(QuerySet& query_set_) noexcept
+{
+    query_set_.is_pending = false;
+
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (!query_set_.is_recorded[i]) { continue; }
+
+        GLint is_available = GL_FALSE;
+        glGetQueryObjectiv(query_set_.queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+        if (!is_available)  // Waiting would stall, the timestamps are overwritten this frame
+        {
+            ++dropped_count;
+            return;
+        }
+    }
+
+    // Frame already left the history
+    if (frame - query_set_.frame >= HISTORY_SIZE) { return; }
+
+    auto& timings = history[query_set_.frame % HISTORY_SIZE];
+
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (!query_set_.is_recorded[i]) { continue; }
+
+        GLuint64 begin_ns = 0;
+        GLuint64 end_ns   = 0;
+        glGetQueryObjectui64v(query_set_.queries[i * 2], GL_QUERY_RESULT, &begin_ns);
+        glGetQueryObjectui64v(query_set_.queries[i * 2 + 1], GL_QUERY_RESULT, &end_ns);
+
+        timings.gpu_ms[i] = static_cast<float>(end_ns - begin_ns) / 1e6f;
+    }
+
+    timings.has_gpu = true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Stages of the main loop which are timed by the FrameProfiler
+ */
+enum class ProfileStage {
+    SHADER_UPDATE, /**< Change detection, synchronous compiles and swapping in finished programs */
+    SHADER_DRAW,   /**< Uniform upload and the draw of the shader */
+    UI,            /**< ImGui frame and its draw */
+    SWAP,          /**< Buffer swap and event polling */
+    COUNT          /**< Total number of the stages */
+};
+
+/**
+ * @brief CPU and GPU time of every stage of one frame, in milliseconds
+ */
+struct FrameTimings {
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(ProfileStage::COUNT);
+
+    std::array<float, STAGE_COUNT> cpu_ms {};
+    std::array<float, STAGE_COUNT> gpu_ms {};
+    bool                           has_gpu = false; /**< Flag indicating if gpu_ms is filled */
+};
+
+/**
+ * @brief Measures every stage of the main loop with CPU timers and GPU timestamp queries and
+ * keeps a rolling history for the frame timing overlay
+ *
+ * @remark GPU results are read QUERY_FRAME_COUNT frames later and only when already available,
+ * so profiling never stalls the pipeline. A result which is still not ready is dropped. While
+ * disabled, the stage calls return right away and no queries are issued.
+ */
+struct FrameProfiler {
+    static constexpr size_t STAGE_COUNT       = FrameTimings::STAGE_COUNT;
+    static constexpr size_t QUERY_FRAME_COUNT = 3;   /**< Query sets in flight */
+    static constexpr size_t HISTORY_SIZE      = 240; /**< Frames kept for the rolling graph */
+
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit FrameProfiler() noexcept;
+
+    FrameProfiler(const FrameProfiler&)             = delete;
+    FrameProfiler& operator= (const FrameProfiler&) = delete;
+
+    ~FrameProfiler();
+
+    void SetEnabled(bool is_enabled_) noexcept;
+    bool IsEnabled() const noexcept;
+
+    /**
+     * @brief Starts the frame and collects the GPU results of the older frames which are ready
+     */
+    void BeginFrame() noexcept;
+
+    void EndFrame() noexcept;
+
+    /**
+     * @remark A stage is timed once per frame. A nested begin of an open stage and a begin of a
+     * stage already timed in this frame are ignored together with their end, so the CPU and the
+     * GPU time always cover the same span.
+     */
+    void BeginStage(ProfileStage stage_) noexcept;
+    void EndStage(ProfileStage stage_) noexcept;
+
+    /**
+     * @brief Times the stage until the end of the scope
+     */
+    struct ScopedStage {
+        explicit ScopedStage(FrameProfiler& profiler_, ProfileStage stage_) noexcept :
+            profiler(profiler_),
+            stage(stage_)
+        {
+            profiler.BeginStage(stage);
+        }
+
+        ScopedStage(const ScopedStage&)             = delete;
+        ScopedStage& operator= (const ScopedStage&) = delete;
+
+        ~ScopedStage() { profiler.EndStage(stage); }
+
+    private:
+        FrameProfiler& profiler;
+        ProfileStage   stage;
+    };
+
+    /**
+     * @brief Returns the timings of the frame which is the given number of frames old
+     *
+     * @param age_ 0 is the last finished frame, must be less than GetHistoryCount()
+     */
+    const FrameTimings& GetHistory(size_t age_) const noexcept;
+
+    size_t GetHistoryCount() const noexcept;
+
+    /**
+     * @brief Returns the average timings over the last frames with GPU results
+     */
+    FrameTimings GetAverage(size_t frame_count_) const noexcept;
+
+    /**
+     * @brief Returns the number of the GPU results which were not ready in time
+     */
+    uint64_t GetDroppedCount() const noexcept;
+
+private:
+
+    /**
+     * @brief GPU timestamps of one frame
+     */
+    struct QuerySet {
+        std::array<GLuint, STAGE_COUNT * 2> queries {}; /**< Begin and end timestamp per stage */
+        std::array<bool, STAGE_COUNT>       is_recorded {};
+        uint64_t                            frame      = 0;
+        bool                                is_pending = false;
+    };
+
+    /**
+     * @brief Reads the timestamps of the set into the history if all of them are available
+     */
+    void CollectQuerySet(QuerySet& query_set_) noexcept;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool     is_enabled  = false;
+    bool     is_in_frame = false; /**< Flag indicating if the current frame is measured */
+    uint64_t frame       = 0;     /**< Number of the current frame */
+
+    std::array<QuerySet, QUERY_FRAME_COUNT>    query_sets;   /**< Ring indexed by the frame */
+    std::array<Clock::time_point, STAGE_COUNT> stage_starts;      /**< CPU start of every stage */
+    std::array<uint32_t, STAGE_COUNT>          stage_depths {};   /**< Open begins per stage */
+    std::array<bool, STAGE_COUNT>              is_stage_timed {}; /**< The open span is timed */
+
+    std::array<FrameTimings, HISTORY_SIZE> history; /**< Ring indexed by the frame number */
+    FrameTimings                           current; /**< Timings of the frame being measured */
+    size_t                                 history_count = 0;
+    uint64_t                               dropped_count = 0;
+};
@@ -0,0 +1,186 @@
+#include "FrameStats.h"
+
+#include "Utils.h"
+
+void FrameTimeHistogram::Add(float ms_) noexcept
+{
+    // Clamped in double, UINT32_MAX rounds up to 2^32 as a float and would overflow the cast
+    constexpr double MAX_US = static_cast<double>(std::numeric_limits<uint32_t>::max());
+
+    const double   clamped_us = ms_ > 0.0f ? std::min(ms_ * 1000.0, MAX_US) : 0.0;  // Also NaN
+    const uint32_t us         = static_cast<uint32_t>(clamped_us + 0.5);
+
+    ++buckets[GetBucketIndex(us)];
+    ++count;
+    sum_us += us;
+    max_us  = std::max(max_us, us);
+}
+
+void FrameTimeHistogram::Clear() noexcept
+{
+    buckets.fill(0);
+    count  = 0;
+    sum_us = 0.0;
+    max_us = 0;
+}
+
+void FrameTimeHistogram::Merge(const FrameTimeHistogram& other_) noexcept
+{
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) { buckets[i] += other_.buckets[i]; }
+
+    count  += other_.count;
+    sum_us += other_.sum_us;
+    max_us  = std::max(max_us, other_.max_us);
+}
+
+float FrameTimeHistogram::GetQuantile(double quantile_) const noexcept
+{
+    if (count == 0) { return 0.0f; }
+
+    // Rank of the sample, counted from 1
+    const auto rank = std::max<uint64_t>(
+        1,
+        static_cast<uint64_t>(std::ceil(std::clamp(quantile_, 0.0, 1.0) * count)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            // The middle of the last bucket may be above the real maximum
+            return std::min(GetBucketValue(i), static_cast<float>(max_us)) / 1000.0f;
+        }
+    }
+
+    return GetMax();
+}
+
+uint64_t FrameTimeHistogram::GetCount() const noexcept { return count; }
+
+float FrameTimeHistogram::GetAverage() const noexcept
+{
+    return count ? static_cast<float>(sum_us / count / 1000.0) : 0.0f;
+}
+
+float FrameTimeHistogram::GetMax() const noexcept { return max_us / 1000.0f; }
+
+size_t FrameTimeHistogram::GetBucketIndex(uint32_t us_) noexcept
+{
+    if (us_ < 2 * SUB_BUCKETS) { return us_; }  // Exact
+
+    // Top SUB_BUCKET_BITS + 1 bits of the value select the bucket within its power of two
+    const uint32_t exponent = static_cast<uint32_t>(std::bit_width(us_)) - 1;
+    const uint32_t mantissa = us_ >> (exponent - SUB_BUCKET_BITS);
+
+    return 2 * SUB_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS
+         + (mantissa - SUB_BUCKETS);
+}
+
+float FrameTimeHistogram::GetBucketValue(size_t index_) noexcept
+{
+    if (index_ < 2 * SUB_BUCKETS) { return static_cast<float>(index_); }
+
+    const size_t   offset   = index_ - 2 * SUB_BUCKETS;
+    const uint32_t shift    = static_cast<uint32_t>(offset / SUB_BUCKETS) + 1;
+    const uint64_t mantissa = SUB_BUCKETS + offset % SUB_BUCKETS;
+
+    const uint64_t lower = mantissa << shift;
+    const uint64_t width = uint64_t { 1 } << shift;
+
+    return static_cast<float>(lower) + static_cast<float>(width) * 0.5f;
+}
+
+float FrameStatsSnapshot::GetAverageFPS() const noexcept
+{
+    return avg_ms > 0.0f ? 1000.0f / avg_ms : 0.0f;
+}
+
+float FrameStatsSnapshot::GetOnePercentLowFPS() const noexcept
+{
+    return p99_ms > 0.0f ? 1000.0f / p99_ms : 0.0f;
+}
+
+float FrameStatsSnapshot::GetPointOnePercentLowFPS() const noexcept
+{
+    return p999_ms > 0.0f ? 1000.0f / p999_ms : 0.0f;
+}
+
+nlohmann::json FrameStatsSnapshot::ToJson() const
+{
+    return { { "frames", frames },
+             { "seconds", seconds },
+             { "avg_ms", avg_ms },
+             { "p50_ms", p50_ms },
+             { "p99_ms", p99_ms },
+             { "p999_ms", p999_ms },
+             { "max_ms", max_ms },
+             { "avg_fps", GetAverageFPS() },
+             { "low_1_fps", GetOnePercentLowFPS() },
+             { "low_0_1_fps", GetPointOnePercentLowFPS() } };
+}
+
+FrameStats::FrameStats(float interval_seconds_) noexcept : interval_seconds(interval_seconds_) {}
+
+bool FrameStats::AddFrame(float delta_time_) noexcept
+{
+    current.Add(delta_time_ * 1000.0f);
+    interval_elapsed += delta_time_;
+
+    if (interval_elapsed < interval_seconds) { return false; }
+
+    interval_snapshot = MakeSnapshot(current, interval_elapsed);
+
+    // The oldest interval leaves the window
+    intervals[next_interval]          = current;
+    interval_durations[next_interval] = interval_elapsed;
+    next_interval                     = (next_interval + 1) % WINDOW_INTERVALS;
+
+    window.Clear();
+    for (const auto& interval : intervals) { window.Merge(interval); }
+
+    float window_seconds = 0.0f;
+    for (float duration : interval_durations) { window_seconds += duration; }
+    window_snapshot = MakeSnapshot(window, window_seconds);
+
+    total.Merge(current);
+    total_elapsed  += interval_elapsed;
+    total_snapshot  = MakeSnapshot(total, total_elapsed);
+
+    current.Clear();
+    interval_elapsed = 0.0f;
+
+    return true;
+}
+
+const FrameStatsSnapshot& FrameStats::GetInterval() const noexcept { return interval_snapshot; }
+
+const FrameStatsSnapshot& FrameStats::GetWindow() const noexcept { return window_snapshot; }
+
+const FrameStatsSnapshot& FrameStats::GetTotal() const noexcept { return total_snapshot; }
+
+nlohmann::json FrameStats::ToJson() const
+{
+    return { { "interval", interval_snapshot.ToJson() },
+             { "window", window_snapshot.ToJson() },
+             { "total", total_snapshot.ToJson() } };
+}
+
+bool FrameStats::Export(std::string_view file_path_) const noexcept
+{
+    return WriteTextToFile(file_path_, ToJson().dump(2));
+}
+
+FrameStatsSnapshot FrameStats::MakeSnapshot(const FrameTimeHistogram& histogram_,
+                                            float                     seconds_) noexcept
+{
+    FrameStatsSnapshot snapshot;
+    snapshot.frames  = histogram_.GetCount();
+    snapshot.seconds = seconds_;
+    snapshot.avg_ms  = histogram_.GetAverage();
+    snapshot.p50_ms  = histogram_.GetQuantile(0.50);
+    snapshot.p99_ms  = histogram_.GetQuantile(0.99);
+    snapshot.p999_ms = histogram_.GetQuantile(0.999);
+    snapshot.max_ms  = histogram_.GetMax();
+    return snapshot;
+}
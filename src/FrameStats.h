@@ -0,0 +1,154 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Fixed-size log-linear histogram of frame times, exact to 1 microsecond below 64 us and
+ * within about 3% above, up to about an hour
+ *
+ * @remark Adding a sample never allocates, so it can be called every frame at any frame rate
+ */
+struct FrameTimeHistogram {
+    static constexpr uint32_t SUB_BUCKET_BITS = 5; /**< 32 sub-buckets per power of two */
+    static constexpr uint32_t SUB_BUCKETS     = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_EXPONENT    = 31;
+    static constexpr size_t   BUCKET_COUNT =
+        2 * SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    /**
+     * @param ms_ Frame time in milliseconds
+     */
+    void Add(float ms_) noexcept;
+
+    void Clear() noexcept;
+
+    /**
+     * @brief Adds the samples of the other histogram to this one
+     */
+    void Merge(const FrameTimeHistogram& other_) noexcept;
+
+    /**
+     * @brief Returns the frame time in milliseconds below which the given part of the samples is
+     *
+     * @param quantile_ Part of the samples, from 0 to 1 (e.g. 0.99 for p99)
+     */
+    float GetQuantile(double quantile_) const noexcept;
+
+    uint64_t GetCount() const noexcept;
+    float    GetAverage() const noexcept;
+    float    GetMax() const noexcept;
+
+private:
+
+    static size_t GetBucketIndex(uint32_t us_) noexcept;
+
+    /**
+     * @brief Returns the middle of the bucket in microseconds
+     */
+    static float GetBucketValue(size_t index_) noexcept;
+
+private:
+    std::array<uint32_t, BUCKET_COUNT> buckets {};
+    uint64_t                           count  = 0;
+    double                             sum_us = 0.0;
+    uint32_t                           max_us = 0;
+};
+
+/**
+ * @brief Frame time summary of one interval or window, times are in milliseconds
+ */
+struct FrameStatsSnapshot {
+    uint64_t frames  = 0;
+    float    seconds = 0.0f; /**< Covered time */
+    float    avg_ms  = 0.0f;
+    float    p50_ms  = 0.0f;
+    float    p99_ms  = 0.0f;
+    float    p999_ms = 0.0f;
+    float    max_ms  = 0.0f;
+
+    float GetAverageFPS() const noexcept;
+
+    /**
+     * @brief Returns the "1% low" frame rate, the frame rate of the 99th percentile frame time
+     */
+    float GetOnePercentLowFPS() const noexcept;
+
+    /**
+     * @brief Returns the "0.1% low" frame rate, the frame rate of the 99.9th percentile frame time
+     */
+    float GetPointOnePercentLowFPS() const noexcept;
+
+    nlohmann::json ToJson() const;
+};
+
+/**
+ * @brief Streaming frame time statistics with fixed memory, replaces collecting and sorting
+ * every frame time
+ *
+ * @remark The samples are grouped into intervals (1 second by default). The sliding window is
+ * made of the last WINDOW_INTERVALS intervals and is updated when an interval completes.
+ */
+struct FrameStats {
+    static constexpr size_t WINDOW_INTERVALS = 10;
+
+    explicit FrameStats(float interval_seconds_ = 1.0f) noexcept;
+
+    /**
+     * @brief Adds the frame time
+     *
+     * @param delta_time_ Frame time in seconds
+     *
+     * @return true if the interval completed and the snapshots were updated
+     */
+    bool AddFrame(float delta_time_) noexcept;
+
+    /**
+     * @brief Returns the summary of the last completed interval
+     */
+    const FrameStatsSnapshot& GetInterval() const noexcept;
+
+    /**
+     * @brief Returns the summary of the sliding window over the last intervals
+     */
+    const FrameStatsSnapshot& GetWindow() const noexcept;
+
+    /**
+     * @brief Returns the summary of all frames since the start
+     */
+    const FrameStatsSnapshot& GetTotal() const noexcept;
+
+    /**
+     * @brief Returns the machine-readable summary of the interval, window and total
+     */
+    nlohmann::json ToJson() const;
+
+    /**
+     * @brief Writes ToJson() to the file
+     *
+     * @param file_path_ Path relative to the application directory
+     *
+     * @return true if the file was written, false otherwise
+     */
+    bool Export(std::string_view file_path_) const noexcept;
+
+private:
+
+    static FrameStatsSnapshot MakeSnapshot(const FrameTimeHistogram& histogram_,
+                                           float                     seconds_) noexcept;
+
+private:
+    float interval_seconds;
+    float interval_elapsed = 0.0f; /**< Time covered by the current interval */
+    float total_elapsed    = 0.0f; /**< Time covered by all intervals */
+
+    FrameTimeHistogram                               current;   /**< Interval being filled */
+    std::array<FrameTimeHistogram, WINDOW_INTERVALS> intervals; /**< Completed, a ring */
+    std::array<float, WINDOW_INTERVALS>              interval_durations {};
+    size_t                                           next_interval = 0;
+    FrameTimeHistogram                               window; /**< Merge of the intervals */
+    FrameTimeHistogram                               total;  /**< All completed intervals */
+
+    FrameStatsSnapshot interval_snapshot;
+    FrameStatsSnapshot window_snapshot;
+    FrameStatsSnapshot total_snapshot;
+};
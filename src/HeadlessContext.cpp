@@ -0,0 +1,168 @@
+#include "HeadlessContext.h"
+
+#ifdef GLSL_LIVE_EGL
+    #define EGL_NO_X11  // Keeps the X11 macros out, the display is never used
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+namespace {
+
+constexpr std::array<int, 2> MINOR_VERSIONS = { 6, 5 };  // OpenGL 4.6, then 4.5 (llvmpipe)
+
+}  // namespace
+
+HeadlessContext::HeadlessContext() noexcept
+{
+    if (!CreateEGLContext() && !CreateGLFWContext())
+    {
+        LOG_CRITICAL("Failed to create a headless OpenGL context");
+        return;
+    }
+
+    LOG_INFO("Headless context ({}): {} | {}",
+             backend_name,
+             reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+             reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+    is_valid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+#ifdef GLSL_LIVE_EGL
+    if (egl_display)
+    {
+        eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (egl_context) { eglDestroyContext(egl_display, egl_context); }
+        eglTerminate(egl_display);
+    }
+#endif
+
+    if (window) { glfwDestroyWindow(window); }
+    if (is_glfw_initialized) { glfwTerminate(); }
+}
+
+bool HeadlessContext::IsValid() const noexcept { return is_valid; }
+
+std::string_view HeadlessContext::GetBackendName() const noexcept { return backend_name; }
+
+bool HeadlessContext::CreateEGLContext() noexcept
+{
+#ifdef GLSL_LIVE_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Surfaceless platform needs neither a display server nor a GPU
+    const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display)
+    {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) { display = eglGetDisplay(EGL_DEFAULT_DISPLAY); }
+
+    EGLint major = 0;
+    EGLint minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        LOG_WARN("EGL is not available, error 0x{:X}", eglGetError());
+        return false;
+    }
+
+    egl_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        LOG_WARN("EGL does not support desktop OpenGL");
+        return false;
+    }
+
+    // No surface is created, the context renders into framebuffer objects only
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,               EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,               EGL_ALPHA_SIZE,      8,
+        EGL_NONE
+    };
+
+    EGLConfig config       = nullptr;
+    EGLint    config_count = 0;
+    eglChooseConfig(display, config_attributes, &config, 1, &config_count);
+
+    for (int minor_version : MINOR_VERSIONS)
+    {
+        const EGLint context_attributes[] = { EGL_CONTEXT_MAJOR_VERSION,
+                                              4,
+                                              EGL_CONTEXT_MINOR_VERSION,
+                                              minor_version,
+                                              EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                              EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                              EGL_NONE };
+
+        EGLContext context = eglCreateContext(display,
+                                              config_count > 0 ? config : EGL_NO_CONFIG_KHR,
+                                              EGL_NO_CONTEXT,
+                                              context_attributes);
+        if (context == EGL_NO_CONTEXT) { continue; }
+
+        if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            eglDestroyContext(display, context);
+            continue;
+        }
+
+        egl_context  = context;
+        backend_name = "EGL surfaceless";
+
+        // EGL returns the core functions too (EGL 1.5)
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+        {
+            LOG_WARN("Failed to initialize GLAD with EGL");
+            return false;
+        }
+
+        return true;
+    }
+
+    LOG_WARN("EGL could not create an OpenGL 4.5 core context, error 0x{:X}", eglGetError());
+    return false;
+#else
+    return false;
+#endif
+}
+
+bool HeadlessContext::CreateGLFWContext() noexcept
+{
+    if (!glfwInit())
+    {
+        LOG_WARN("Failed to initialize GLFW");
+        return false;
+    }
+
+    is_glfw_initialized = true;
+
+    for (int minor_version : MINOR_VERSIONS)
+    {
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor_version);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        window = glfwCreateWindow(1, 1, "GLSL Live (headless)", nullptr, nullptr);
+        if (window) { break; }
+    }
+
+    if (!window) { return false; }
+
+    glfwMakeContextCurrent(window);
+    backend_name = "GLFW hidden window";
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    {
+        LOG_WARN("Failed to initialize GLAD with GLFW");
+        return false;
+    }
+
+    return true;
+}
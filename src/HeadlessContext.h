@@ -0,0 +1,44 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief OpenGL context without a visible window, used to render on machines without a display
+ *
+ * @remark Tries an EGL surfaceless context first (Mesa llvmpipe works without a GPU), then a
+ * hidden GLFW window. Core profile 4.6 is requested, 4.5 is accepted.
+ */
+struct HeadlessContext {
+    /**
+     * @brief Creates the context, makes it current and loads the GL functions
+     *
+     * @remark Check IsValid() for success
+     */
+    explicit HeadlessContext() noexcept;
+
+    HeadlessContext(const HeadlessContext&)             = delete;
+    HeadlessContext& operator= (const HeadlessContext&) = delete;
+
+    ~HeadlessContext();
+
+    bool IsValid() const noexcept;
+
+    /**
+     * @brief Returns the name of the backend which created the context (e.g. "EGL surfaceless")
+     */
+    std::string_view GetBackendName() const noexcept;
+
+private:
+
+    bool CreateEGLContext() noexcept;
+
+    bool CreateGLFWContext() noexcept;
+
+private:
+    void*       egl_display         = nullptr; /**< EGLDisplay, null if EGL is not used */
+    void*       egl_context         = nullptr; /**< EGLContext, null if EGL is not used */
+    GLFWwindow* window              = nullptr; /**< Hidden window, null if GLFW is not used */
+    bool        is_glfw_initialized = false;
+    bool        is_valid            = false;
+    std::string backend_name;
+};
@@ -0,0 +1,423 @@
+#include "HeadlessRenderer.h"
+
+#include "Utils.h"
+#include "ScreenQuad.h"
+#include "RenderTarget.h"
+#include "RenderGraph.h"
+#include "ResolutionScaler.h"
+#include "ProgressiveRenderer.h"
+#include "ShaderManager.h"
+#include "BuiltinUniforms.h"
+#include "HeadlessContext.h"
+#include "LatencyTracker.h"
+#include "MouseInput.h"
+
+namespace {
+
+constexpr std::string_view HEADLESS_USAGE =
+    "Usage: GLSL_Live --headless <fragment.glsl> [--size WxH] [--frames N] [--time-step S] "
+    "[--start-time S] [--scale S] [--samples N] [--synthetic-input HZ] [--buffers] "
+    "[--format png|raw|y4m|none] [--output DIR]";
+
+using Clock = std::chrono::steady_clock;
+
+double GetElapsedMs(Clock::time_point start_) noexcept
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+}
+
+/**
+ * @brief Min, max and average of a series of durations
+ */
+struct TimingSummary {
+    double min_ms   = 0.0;
+    double max_ms   = 0.0;
+    double total_ms = 0.0;
+
+    void Add(double ms_, bool is_first_) noexcept
+    {
+        min_ms    = is_first_ ? ms_ : std::min(min_ms, ms_);
+        max_ms    = is_first_ ? ms_ : std::max(max_ms, ms_);
+        total_ms += ms_;
+    }
+
+    double GetAverageMs(int32_t count_) const noexcept
+    {
+        return count_ > 0 ? total_ms / count_ : 0.0;
+    }
+};
+
+/**
+ * @brief Fake mouse on its own thread which drags on a circle and clicks again every few
+ * hundred events, pushed through the same queue as the callbacks of a real one
+ */
+struct SyntheticInputSource {
+    static constexpr uint64_t CLICK_PERIOD = 250; /**< Events from one press to the next */
+    static constexpr uint64_t DRAG_LENGTH  = 200; /**< Events from a press to its release */
+
+    explicit SyntheticInputSource(MouseInput& mouse_input_, float rate_) noexcept :
+        mouse_input(mouse_input_),
+        period(std::chrono::duration_cast<MouseInput::Clock::duration>(
+            std::chrono::duration<double>(1.0 / rate_))),
+        thread(&SyntheticInputSource::Run, this)
+    {
+    }
+
+    SyntheticInputSource(const SyntheticInputSource&)             = delete;
+    SyntheticInputSource& operator= (const SyntheticInputSource&) = delete;
+
+    ~SyntheticInputSource()
+    {
+        is_stopping = true;
+        thread.join();
+    }
+
+private:
+    void Run() noexcept
+    {
+        auto next_time = MouseInput::Clock::now();
+
+        for (uint64_t event = 0; !is_stopping; ++event)
+        {
+            next_time += period;
+            std::this_thread::sleep_until(next_time);
+
+            const float     angle = static_cast<float>(event) * 0.01f;
+            const glm::vec2 position =
+                glm::vec2(0.5f) + 0.25f * glm::vec2(std::cos(angle), std::sin(angle));
+
+            switch (event % CLICK_PERIOD)
+            {
+                case 0 :
+                    mouse_input.PushButton(position, true);
+                    break;
+
+                case DRAG_LENGTH :
+                    mouse_input.PushButton(position, false);
+                    break;
+
+                default :
+                    mouse_input.PushMove(position);
+                    break;
+            }
+        }
+    }
+
+private:
+    MouseInput&                       mouse_input;
+    const MouseInput::Clock::duration period;
+    std::atomic<bool>                 is_stopping = false;
+
+    std::thread thread; /**< Declared last, starts after the other members */
+};
+
+}  // namespace
+
+bool IsHeadlessRequested(int argc, char* argv[]) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--headless") { return true; }
+    }
+
+    return false;
+}
+
+bool ParseHeadlessOptions(int argc, char* argv[], HeadlessOptions& options_) noexcept
+{
+    bool is_valid = true;
+
+    for (int i = 1; i < argc && is_valid; ++i)
+    {
+        const std::string_view argument = argv[i];
+        const bool             has_value = i + 1 < argc;
+
+        if (argument == "--headless" && has_value) { options_.shader_path = argv[++i]; }
+        else if (argument == "--size" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%dx%d", &options_.width, &options_.height) == 2;
+        }
+        else if (argument == "--frames" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%d", &options_.frame_count) == 1;
+        }
+        else if (argument == "--time-step" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%f", &options_.time_step) == 1;
+        }
+        else if (argument == "--start-time" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%f", &options_.start_time) == 1;
+        }
+        else if (argument == "--scale" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%f", &options_.scale) == 1;
+        }
+        else if (argument == "--samples" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%d", &options_.sample_count) == 1;
+        }
+        else if (argument == "--synthetic-input" && has_value)
+        {
+            is_valid = std::sscanf(argv[++i], "%f", &options_.input_rate) == 1;
+        }
+        else if (argument == "--buffers") { options_.is_buffer_loaded = true; }
+        else if (argument == "--output" && has_value) { options_.output_directory = argv[++i]; }
+        else if (argument == "--format" && has_value)
+        {
+            const std::string_view format = argv[++i];
+
+            if (format == "png") { options_.output_format = FrameOutputFormat::PNG; }
+            else if (format == "raw") { options_.output_format = FrameOutputFormat::RAW; }
+            else if (format == "y4m") { options_.output_format = FrameOutputFormat::Y4M; }
+            else if (format == "none") { options_.output_format = FrameOutputFormat::NONE; }
+            else { is_valid = false; }
+        }
+        else
+        {
+            LOG_ERROR("Unknown or incomplete argument: {}", argument);
+            is_valid = false;
+        }
+    }
+
+    if (options_.shader_path.empty() || options_.width <= 0 || options_.height <= 0
+        || options_.frame_count <= 0 || options_.sample_count <= 0 || options_.time_step < 0.0f
+        || options_.input_rate < 0.0f
+        || options_.scale < ResolutionScaler::MIN_SCALE
+        || options_.scale > ResolutionScaler::MAX_SCALE)
+    {
+        is_valid = false;
+    }
+
+    if (!is_valid)
+    {
+        LOG_ERROR("Invalid headless arguments");
+        LOG_ERROR("{}", HEADLESS_USAGE);
+        return false;
+    }
+
+    // Shaders are loaded relative to the application, the command line is relative to the
+    // working directory
+    std::error_code error;
+    auto            shader_path = std::filesystem::relative(
+        std::filesystem::absolute(options_.shader_path, error), GetApplicationPath(), error);
+    if (!error && !shader_path.empty()) { options_.shader_path = shader_path.generic_string(); }
+
+    return true;
+}
+
+int RunHeadless(const HeadlessOptions& options_) noexcept
+{
+    const auto run_start = Clock::now();
+
+    HeadlessContext context;
+    if (!context.IsValid()) { return -1; }
+
+    {  // Create an scope for correct destruction of the resources before the context
+
+        RenderTarget render_target(options_.width, options_.height);
+        if (!render_target.IsValid()) { return -1; }
+
+        ShaderManager shader_manager(ShaderManagerMode::HEADLESS);
+
+        const auto compile_start = Clock::now();
+        if (!shader_manager.LoadFragmentShaderFromPath(options_.shader_path))
+        {
+            LOG_CRITICAL("Failed to compile the fragment shader: {}", options_.shader_path);
+            LOG_CRITICAL("{}", shader_manager.GetFragmentShader().GetCompilationError());
+            return -1;
+        }
+        if (options_.is_buffer_loaded) { shader_manager.LoadSavedBuffers(); }
+        const double compile_ms = GetElapsedMs(compile_start);
+
+        auto& shader_program = shader_manager.GetShaderProgram();
+        if (shader_program.GetID() == 0)
+        {
+            LOG_CRITICAL("Failed to link the shader program");
+            return -1;
+        }
+
+        ScreenQuad         screen_quad;
+        BuiltinUniformData builtin_uniforms;
+
+        // Buffers loaded with --buffers are drawn like in the window, feedback starts from black
+        TextureManager texture_manager("shaders");
+        RenderGraph    render_graph(texture_manager);
+
+        // Above 1 the frames are supersampled, below 1 they are drawn smaller and stretched
+        ResolutionScaler resolution_scaler;
+        resolution_scaler.SetScale(options_.scale);
+
+        // Several samples per frame are averaged like while accumulating in the window
+        ProgressiveRenderer progressive_renderer;
+        progressive_renderer.SetAccumulationEnabled(true);
+
+        const bool is_accumulating = options_.sample_count > 1;
+        render_graph.SetPass(RenderPassId::IMAGE,
+                             &shader_program,
+                             shader_manager.GetShaderProgramGeneration(),
+                             shader_manager.GetFragmentShader().GetCodeConst());
+
+        for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+        {
+            render_graph.SetPass(static_cast<RenderPassId>(i),
+                                 shader_manager.GetBufferProgram(i),
+                                 shader_manager.GetBufferProgramGeneration(i),
+                                 shader_manager.GetBufferShader(i).GetCodeConst());
+        }
+
+        // Every frame sees the loaded files, also the first one
+        texture_manager.Finish();
+
+        // Fixed for the whole run, so the same arguments give the same frames
+        builtin_uniforms.time_delta = options_.time_step;
+        builtin_uniforms.frame_rate = options_.time_step > 0.0f ? 1.0f / options_.time_step : 0.0f;
+        builtin_uniforms.date       = GetBuiltinDate();
+
+        // Frames are read back and written while the next ones are drawn
+        const bool    is_writing = options_.output_format != FrameOutputFormat::NONE;
+        FrameExporter frame_exporter;
+
+        FrameExportSettings export_settings;
+        export_settings.output_directory = options_.output_directory;
+        export_settings.output_format    = options_.output_format;
+        export_settings.width            = options_.width;
+        export_settings.height           = options_.height;
+        export_settings.frame_count      = options_.frame_count;
+        export_settings.start_time       = options_.start_time;
+        export_settings.time_step        = options_.time_step;
+
+        if (is_writing && !frame_exporter.Begin(export_settings)) { return -1; }
+
+        // A fake mouse drives the same latency measurement as the cursor in the window
+        LatencyTracker                        latency_tracker;
+        MouseInput                            mouse_input;
+        std::unique_ptr<SyntheticInputSource> input_source;
+        if (options_.input_rate > 0.0f)
+        {
+            latency_tracker.SetEnabled(true);
+            input_source =
+                std::make_unique<SyntheticInputSource>(mouse_input, options_.input_rate);
+        }
+
+        TimingSummary render_timing;
+
+        for (int32_t frame = 0; frame < options_.frame_count; ++frame)
+        {
+            builtin_uniforms.time = options_.start_time + options_.time_step * frame;
+
+            LatencyTracker::Clock::time_point event_time;
+            uint64_t                          event_count = 0;
+            if (mouse_input.Update(event_time, event_count))
+            {
+                latency_tracker.OnInput(event_time, event_count);
+            }
+
+            const auto render_start = Clock::now();
+            render_target.Bind();
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            const GLuint output_framebuffer = render_target.GetFramebuffer();
+            const GLuint scaled_framebuffer =
+                resolution_scaler.Begin(options_.width, options_.height, output_framebuffer);
+
+            const int32_t render_width  = resolution_scaler.GetRenderWidth();
+            const int32_t render_height = resolution_scaler.GetRenderHeight();
+            render_graph.SetSize(render_width, render_height);
+            builtin_uniforms.resolution = glm::vec3(render_width, render_height, 1.0f);
+            builtin_uniforms.mouse = mouse_input.GetMouse(glm::vec2(render_width, render_height));
+            mouse_input.OnFrameConsumed();
+            latency_tracker.OnInputConsumed();
+
+            if (is_accumulating)
+            {
+                progressive_renderer.Restart();  // Every frame averages its own samples
+
+                for (int32_t sample = 0; sample < options_.sample_count; ++sample)
+                {
+                    builtin_uniforms.frame = frame * options_.sample_count + sample;
+
+                    progressive_renderer.BeginFrame(
+                        render_graph, builtin_uniforms, render_width, render_height, true);
+                    progressive_renderer.Render(render_graph, screen_quad, scaled_framebuffer);
+                }
+            }
+            else
+            {
+                builtin_uniforms.frame = frame;
+                render_graph.Execute(builtin_uniforms, screen_quad, scaled_framebuffer);
+            }
+
+            resolution_scaler.End();  // Presents into the render target
+            if (is_writing) { frame_exporter.Capture(render_target.GetTexture()); }
+
+            latency_tracker.OnFrameSwapped();  // Without a window the frame ends here
+
+            if (is_writing) { frame_exporter.Update(); }
+            else { glFinish(); }  // Only timed, the GPU time is included
+
+            latency_tracker.Update();
+
+            render_timing.Add(GetElapsedMs(render_start), frame == 0);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        const bool is_written = !is_writing || frame_exporter.Finish();
+
+        input_source.reset();
+        latency_tracker.Finish();
+
+        const double total_ms = GetElapsedMs(run_start);
+
+        LOG_INFO("Headless render: {} frames of {}x{} with {} ({})",
+                 options_.frame_count,
+                 options_.width,
+                 options_.height,
+                 options_.shader_path,
+                 context.GetBackendName());
+        LOG_INFO("Compile: {:.3f} ms (cache hits: {})",
+                 compile_ms,
+                 shader_manager.GetStats().cache_hits);
+        LOG_INFO("Scale: {:.3f}, passes drawn at {}x{}",
+                 resolution_scaler.GetCurrentScale(),
+                 resolution_scaler.GetRenderWidth(),
+                 resolution_scaler.GetRenderHeight());
+        LOG_INFO("Passes: {} drawn and {} reused in the last frame, {} buffer textures",
+                 render_graph.GetStats().executed_passes,
+                 render_graph.GetStats().skipped_passes,
+                 render_graph.GetStats().texture_count);
+        LOG_INFO("Channel textures: {} uploaded, {} failed, last decode {:.3f} ms",
+                 texture_manager.GetStats().uploads,
+                 texture_manager.GetStats().failures,
+                 texture_manager.GetStats().last_decode_ms);
+
+        // While writing the GPU time overlaps the next frames and is not included
+        LOG_INFO("{}: avg {:.3f} ms, min {:.3f} ms, max {:.3f} ms",
+                 is_writing ? "Submit" : "Render",
+                 render_timing.GetAverageMs(options_.frame_count),
+                 render_timing.min_ms,
+                 render_timing.max_ms);
+
+        LOG_INFO("Total: {:.3f} ms, {:.2f} frames per second",
+                 total_ms,
+                 options_.frame_count * 1000.0 / total_ms);
+
+        if (latency_tracker.IsEnabled())
+        {
+            latency_tracker.LogStats();
+            LOG_INFO("Synthetic mouse events dropped: {}", mouse_input.GetDroppedEventCount());
+
+            if (latency_tracker.GetStats().measured_frames == 0)
+            {
+                LOG_ERROR("No frame read the synthetic input and finished");
+                return -1;
+            }
+        }
+
+        if (!is_written) { return -1; }
+    }
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "FrameExporter.h"
+
+/**
+ * @brief Settings of the headless render, filled from the command line
+ */
+struct HeadlessOptions {
+    std::string       shader_path;                        /**< Fragment shader, app relative */
+    std::string       output_directory = "frames";        /**< Relative to the working directory */
+    FrameOutputFormat output_format    = FrameOutputFormat::PNG;
+    int32_t           width            = 1920;            /**< Width of the frames in pixels */
+    int32_t           height           = 1080;            /**< Height of the frames in pixels */
+    int32_t           frame_count      = 1;               /**< Number of the rendered frames */
+    float             start_time       = 0.0f;            /**< iTime of the first frame */
+    float             time_step        = 1.0f / 60.0f;    /**< Fixed iTimeDelta in seconds */
+    float             scale            = 1.0f;            /**< Resolution scale, 0.25 to 2 */
+    int32_t           sample_count     = 1;               /**< Samples averaged per frame */
+    float             input_rate       = 0.0f;            /**< Synthetic cursor events per s */
+    bool              is_buffer_loaded = false;           /**< Draws shaders/buffers too */
+};
+
+/**
+ * @brief Checks if the application was started with --headless
+ */
+bool IsHeadlessRequested(int argc, char* argv[]) noexcept;
+
+/**
+ * @brief Parses the headless command line:
+ * --headless <fragment.glsl> [--size WxH] [--frames N] [--time-step S] [--start-time S]
+ * [--scale S] [--samples N] [--synthetic-input HZ] [--buffers] [--format png|raw|y4m|none]
+ * [--output DIR]
+ *
+ * @param options_ Storage for the options
+ *
+ * @return true if the options are valid, false otherwise (the usage is logged)
+ */
+bool ParseHeadlessOptions(int argc, char* argv[], HeadlessOptions& options_) noexcept;
+
+/**
+ * @brief Renders the fragment shader into an offscreen framebuffer for the given number of frames
+ * with a fixed time step and logs a timing summary, no window or UI is created
+ *
+ * @remark Uses the same ShaderManager and ShaderProgram as the interactive mode, in its headless
+ * mode which restores nothing of the last session and records no history. The frames are
+ * written by a FrameExporter while the next ones are drawn. With a synthetic input rate a fake
+ * mouse clicks and drags on its own thread, iMouse follows it and the input latency is measured
+ * like in the window, the run fails if no frame read and finished its input.
+ *
+ * @return Exit code of the application, 0 on success
+ */
+int RunHeadless(const HeadlessOptions& options_) noexcept;
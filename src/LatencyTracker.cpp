@@ -0,0 +1,183 @@
+#include "LatencyTracker.h"
+
+namespace {
+
+constexpr GLuint64 WAIT_TIMEOUT_NS = 1'000'000'000; /**< Blocking waits retry every second */
+
+float GetMs(LatencyTracker::Clock::duration duration_) noexcept
+{
+    return std::chrono::duration<float, std::milli>(duration_).count();
+}
+
+void LogHistogram(const char* label_, const FrameTimeHistogram& histogram_) noexcept
+{
+    LOG_INFO("{}: p50 {:.3f} ms, p90 {:.3f} ms, p99 {:.3f} ms, p99.9 {:.3f} ms, max {:.3f} ms",
+             label_,
+             histogram_.GetQuantile(0.5),
+             histogram_.GetQuantile(0.9),
+             histogram_.GetQuantile(0.99),
+             histogram_.GetQuantile(0.999),
+             histogram_.GetMax());
+}
+
+}  // namespace
+
+LatencyTracker::LatencyTracker() noexcept {}
+
+LatencyTracker::~LatencyTracker()
+{
+    if (is_enabled) { SetEnabled(false); }
+}
+
+void LatencyTracker::SetEnabled(bool is_enabled_) noexcept
+{
+    if (is_enabled == is_enabled_) { return; }
+
+    if (is_enabled_)
+    {
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(queries.size()), queries.data());
+        free_queries.assign(queries.begin(), queries.end());
+    }
+    else
+    {
+        Finish();
+        DeleteQueries();
+    }
+
+    is_enabled        = is_enabled_;
+    is_input_pending  = false;
+    is_input_consumed = false;
+}
+
+bool LatencyTracker::IsEnabled() const noexcept { return is_enabled; }
+
+void LatencyTracker::OnInput(Clock::time_point event_time_, uint64_t event_count_) noexcept
+{
+    if (!is_enabled) { return; }
+
+    stats.events += event_count_;
+
+    // Later events of the same frame are shown by it too, the oldest one waited the longest
+    if (is_input_pending) { return; }
+
+    input_time       = event_time_;
+    is_input_pending = true;
+}
+
+void LatencyTracker::OnInputConsumed() noexcept
+{
+    if (!is_enabled || !is_input_pending || is_input_consumed) { return; }
+
+    consumed_input_time = input_time;
+    is_input_consumed   = true;
+    is_input_pending    = false;
+
+    ++stats.consumed_frames;
+    stats.to_consume.Add(GetMs(Clock::now() - consumed_input_time));
+}
+
+void LatencyTracker::DropPendingInput() noexcept { is_input_pending = false; }
+
+void LatencyTracker::OnFrameSwapped() noexcept
+{
+    if (!is_enabled || !is_input_consumed) { return; }
+
+    is_input_consumed = false;
+    stats.to_swap.Add(GetMs(Clock::now() - consumed_input_time));
+
+    // All queries in flight, the frame is not measured rather than waiting for the GPU
+    if (free_queries.empty()) { Update(); }
+    if (free_queries.empty()) { return; }
+
+    PendingFrame frame;
+    frame.query      = free_queries.back();
+    frame.input_time = consumed_input_time;
+    free_queries.pop_back();
+
+    glQueryCounter(frame.query, GL_TIMESTAMP);
+
+    // Read right after each other, the difference maps the GPU time of the query to the CPU clock
+    GLint64 gpu_now_ns = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_now_ns);
+    const auto cpu_now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                Clock::now().time_since_epoch())
+                                .count();
+
+    frame.gpu_offset_ns = cpu_now_ns - gpu_now_ns;
+    frame.fence         = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    pending_frames.push_back(frame);
+}
+
+void LatencyTracker::Update() noexcept
+{
+    while (!pending_frames.empty() && Collect(pending_frames.front(), false))
+    {
+        pending_frames.pop_front();
+    }
+}
+
+void LatencyTracker::Finish() noexcept
+{
+    while (!pending_frames.empty())
+    {
+        Collect(pending_frames.front(), true);
+        pending_frames.pop_front();
+    }
+}
+
+const LatencyStats& LatencyTracker::GetStats() const noexcept { return stats; }
+
+void LatencyTracker::LogStats() const noexcept
+{
+    LOG_INFO("Input latency: {} events, {} frames read input, {} measured on the GPU",
+             stats.events,
+             stats.consumed_frames,
+             stats.measured_frames);
+    LogHistogram("Input to frame", stats.to_consume);
+    LogHistogram("Input to swap", stats.to_swap);
+    LogHistogram("Input to GPU complete", stats.to_complete);
+}
+
+void LatencyTracker::ResetStats() noexcept { stats = {}; }
+
+bool LatencyTracker::Collect(PendingFrame& frame_, bool is_blocking_) noexcept
+{
+    GLenum result = glClientWaitSync(frame_.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (is_blocking_ && result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(frame_.fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+    }
+
+    if (result == GL_TIMEOUT_EXPIRED) { return false; }
+
+    glDeleteSync(frame_.fence);
+    free_queries.push_back(frame_.query);
+
+    if (result == GL_WAIT_FAILED)
+    {
+        LOG_ERROR("Failed to wait for a measured frame");
+        return true;
+    }
+
+    // The query is before the fence, so its result is available
+    GLuint64 gpu_time_ns = 0;
+    glGetQueryObjectui64v(frame_.query, GL_QUERY_RESULT, &gpu_time_ns);
+
+    const int64_t complete_ns = static_cast<int64_t>(gpu_time_ns) + frame_.gpu_offset_ns;
+    const int64_t input_ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 frame_.input_time.time_since_epoch())
+                                 .count();
+
+    stats.to_complete.Add(static_cast<float>(complete_ns - input_ns) / 1'000'000.0f);
+    ++stats.measured_frames;
+
+    return true;
+}
+
+void LatencyTracker::DeleteQueries() noexcept
+{
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    queries.fill(0);
+    free_queries.clear();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "FrameStats.h"
+
+/**
+ * @brief Input-to-photon latencies, times are in milliseconds from the input event
+ */
+struct LatencyStats {
+    FrameTimeHistogram to_consume;          /**< Until a frame read the input */
+    FrameTimeHistogram to_swap;             /**< Until the swap of that frame returned */
+    FrameTimeHistogram to_complete;         /**< Until the GPU finished the frame and its present */
+    uint64_t           events          = 0; /**< Input events seen */
+    uint64_t           consumed_frames = 0; /**< Frames which read new input */
+    uint64_t           measured_frames = 0; /**< Of them, frames whose completion was measured */
+};
+
+/**
+ * @brief Measures the latency from input events to the frames which show them
+ *
+ * @remark Events are timestamped where they arrive (the cursor callback or a synthetic source).
+ * The first frame drawn after them is tagged as consuming them, and after its swap a fence and a
+ * GL_TIMESTAMP query are put into the command stream. The fence is polled without waiting, once
+ * it is signaled the query holds the GPU time the frame was finished, which is mapped to the CPU
+ * clock with the offset between the two clocks at the swap. Frames which read no new input cost
+ * nothing.
+ */
+struct LatencyTracker {
+    static constexpr size_t MAX_FRAMES_IN_FLIGHT = 8; /**< Measured frames whose fence is polled */
+
+    using Clock = std::chrono::steady_clock;
+
+    explicit LatencyTracker() noexcept;
+
+    LatencyTracker(const LatencyTracker&)             = delete;
+    LatencyTracker& operator= (const LatencyTracker&) = delete;
+
+    /**
+     * @remark Must be destroyed with the GL context current if it was ever enabled
+     */
+    ~LatencyTracker();
+
+    /**
+     * @remark Must be called with a current GL context, the queries are created on enabling
+     */
+    void SetEnabled(bool is_enabled_) noexcept;
+    bool IsEnabled() const noexcept;
+
+    /**
+     * @brief Records input events polled on the render thread
+     *
+     * @param event_time_ Arrival of the oldest of the events
+     * @param event_count_ Number of the events
+     */
+    void OnInput(Clock::time_point event_time_, uint64_t event_count_ = 1) noexcept;
+
+    /**
+     * @brief Tags the frame being drawn as the consumer of the pending input
+     */
+    void OnInputConsumed() noexcept;
+
+    /**
+     * @brief Forgets the pending input, call on frames which do not draw the shader (paused or
+     * without a program), so the wait until a later frame reads it is not measured as latency
+     */
+    void DropPendingInput() noexcept;
+
+    /**
+     * @brief Puts the fence and the timestamp behind the frame if it consumed input, call right
+     * after the swap (or after the last draw without a window)
+     */
+    void OnFrameSwapped() noexcept;
+
+    /**
+     * @brief Collects the frames the GPU finished, never waits
+     */
+    void Update() noexcept;
+
+    /**
+     * @brief Waits for all frames in flight and collects them
+     */
+    void Finish() noexcept;
+
+    const LatencyStats& GetStats() const noexcept;
+
+    /**
+     * @brief Logs the percentiles of the latencies
+     */
+    void LogStats() const noexcept;
+
+    void ResetStats() noexcept;
+
+private:
+
+    /**
+     * @brief Measured frame whose fence is not signaled yet
+     */
+    struct PendingFrame {
+        GLsync            fence         = nullptr;
+        GLuint            query         = 0;
+        Clock::time_point input_time;
+        int64_t           gpu_offset_ns = 0; /**< CPU minus GPU clock at the swap */
+    };
+
+    /**
+     * @brief Records the frame if its fence is signaled, waiting for it if is_blocking_
+     *
+     * @return true if the frame was recorded
+     */
+    bool Collect(PendingFrame& frame_, bool is_blocking_) noexcept;
+
+    void DeleteQueries() noexcept;
+
+private:
+    bool is_enabled = false;
+
+    bool              is_input_pending  = false; /**< Input arrived and no frame read it yet */
+    bool              is_input_consumed = false; /**< The current frame read input */
+    Clock::time_point input_time;                /**< Oldest event of the pending input */
+    Clock::time_point consumed_input_time;       /**< Oldest event the current frame read */
+
+    std::array<GLuint, MAX_FRAMES_IN_FLIGHT> queries {};   /**< Created while enabled */
+    std::vector<GLuint>                      free_queries; /**< Not used by a pending frame */
+    std::deque<PendingFrame>                 pending_frames;
+
+    LatencyStats stats;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Lock-free single-slot mailbox for handing objects between two threads
+ *
+ * @remark Posting into a full mailbox replaces the unread value, so the receiver always gets
+ * the latest one
+ */
+template<typename T>
+struct Mailbox {
+    explicit Mailbox() noexcept = default;
+
+    Mailbox(const Mailbox&)             = delete;
+    Mailbox& operator= (const Mailbox&) = delete;
+
+    ~Mailbox() { delete slot.exchange(nullptr, std::memory_order_acquire); }
+
+    /**
+     * @brief Puts the value into the mailbox
+     *
+     * @param value_ Value to post
+     *
+     * @return The unread value which was replaced or nullptr
+     */
+    std::unique_ptr<T> Post(std::unique_ptr<T> value_) noexcept
+    {
+        return std::unique_ptr<T>(slot.exchange(value_.release(), std::memory_order_acq_rel));
+    }
+
+    /**
+     * @brief Takes the value out of the mailbox
+     *
+     * @return The posted value or nullptr if the mailbox is empty
+     */
+    std::unique_ptr<T> Take() noexcept
+    {
+        // Cheap check first, so polling an empty mailbox every frame does not write the cache line
+        if (slot.load(std::memory_order_relaxed) == nullptr) { return nullptr; }
+
+        return std::unique_ptr<T>(slot.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+    bool IsEmpty() const noexcept { return slot.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    std::atomic<T*> slot { nullptr }; /**< Posted value, nullptr if the mailbox is empty */
+};
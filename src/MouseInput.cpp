@@ -0,0 +1,136 @@
+#include "MouseInput.h"
+
+MouseInput::MouseInput() noexcept {}
+
+void MouseInput::PushMove(glm::vec2 position_) noexcept { Push(position_, MouseEventType::MOVE); }
+
+void MouseInput::PushButton(glm::vec2 position_, bool is_pressed_) noexcept
+{
+    Push(position_, is_pressed_ ? MouseEventType::PRESS : MouseEventType::RELEASE);
+}
+
+bool MouseInput::Update(Clock::time_point& oldest_time_, uint64_t& count_) noexcept
+{
+    count_ = 0;
+
+    MouseEvent event;
+    while (queue.Pop(event))
+    {
+        if (count_ == 0) { oldest_time_ = event.time; }
+        ++count_;
+
+        switch (event.type)
+        {
+            case MouseEventType::MOVE :
+                if (is_down) { drag_position = event.position; }
+                break;
+
+            case MouseEventType::PRESS :
+                is_down        = true;
+                is_clicked     = true;  // Kept until a frame shows it, even if released already
+                click_position = event.position;
+                drag_position  = event.position;
+                break;
+
+            case MouseEventType::RELEASE :
+                if (is_down) { drag_position = event.position; }
+                is_down = false;
+                break;
+        }
+
+        AddSample(event);
+    }
+
+    if (count_ > 0) { update_time = Clock::now(); }
+
+    return count_ > 0;
+}
+
+glm::vec4 MouseInput::GetMouse(glm::vec2 resolution_) const noexcept
+{
+    const glm::vec2 drag  = drag_position * resolution_;
+    const glm::vec2 click = click_position * resolution_;
+
+    return glm::vec4(drag, is_down ? click.x : -click.x, is_clicked ? click.y : -click.y);
+}
+
+size_t MouseInput::GetSamples(glm::vec2                        resolution_,
+                              std::array<Sample, MAX_SAMPLES>& samples_) const noexcept
+{
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        const MotionSample& sample  = samples[i];
+        const float         is_down = sample.is_down ? 1.0f : 0.0f;
+        const auto          age     = std::chrono::duration<float>(update_time - sample.time);
+
+        samples_[i] = Sample(sample.position * resolution_, is_down, age.count());
+    }
+
+    return sample_count;
+}
+
+void MouseInput::OnFrameConsumed() noexcept
+{
+    is_clicked   = false;
+    sample_count = 0;
+}
+
+uint64_t MouseInput::GetDroppedEventCount() const noexcept
+{
+    return dropped_events.load(std::memory_order_relaxed);
+}
+
+void MouseInput::Push(glm::vec2 position_, MouseEventType type_) noexcept
+{
+    if (!queue.Push(MouseEvent { Clock::now(), position_, type_ }))
+    {
+        dropped_events.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MouseInput::AddSample(const MouseEvent& event_) noexcept
+{
+    // A full buffer keeps replacing its last sample, so the stroke still ends at the cursor
+    const size_t index = std::min(sample_count, MAX_SAMPLES - 1);
+
+    samples[index] = MotionSample { event_.time, event_.position, is_down };
+    sample_count   = index + 1;
+}
+
+MouseSampleBuffer::MouseSampleBuffer() noexcept
+{
+    glCreateBuffers(1, &buffer);
+    glNamedBufferData(buffer, sizeof(Data), nullptr, GL_STREAM_DRAW);
+}
+
+MouseSampleBuffer::~MouseSampleBuffer()
+{
+    if (buffer) { glDeleteBuffers(1, &buffer); }
+}
+
+void MouseSampleBuffer::Update(const MouseInput& mouse_input_, glm::vec2 resolution_) noexcept
+{
+    if (!buffer) { return; }
+
+    data.count = static_cast<int32_t>(mouse_input_.GetSamples(resolution_, data.samples));
+    Upload();
+}
+
+void MouseSampleBuffer::Clear() noexcept
+{
+    if (!buffer) { return; }
+
+    data.count = 0;
+    Upload();
+}
+
+void MouseSampleBuffer::Upload() noexcept
+{
+    // Orphaned, the draws of the previous frame keep their storage
+    const GLsizeiptr size = static_cast<GLsizeiptr>(offsetof(Data, samples)
+                                                    + sizeof(MouseInput::Sample) * data.count);
+
+    glNamedBufferData(buffer, sizeof(Data), nullptr, GL_STREAM_DRAW);
+    glNamedBufferSubData(buffer, 0, size, &data);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, buffer);
+}
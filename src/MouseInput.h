@@ -0,0 +1,178 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "SpscQueue.h"
+
+enum class MouseEventType : uint8_t {
+    MOVE,    /**< The cursor moved */
+    PRESS,   /**< The left button was pressed */
+    RELEASE  /**< The left button was released */
+};
+
+/**
+ * @brief Mouse event as it arrived, the position is normalized to 0 to 1 with the origin at
+ * the bottom left, so it maps onto any render size
+ */
+struct MouseEvent {
+    std::chrono::steady_clock::time_point time;
+    glm::vec2                             position { 0.0f };
+    MouseEventType                        type = MouseEventType::MOVE;
+};
+
+/**
+ * @brief Mouse state with the ShaderToy iMouse semantics, fed through a lock-free event queue
+ *
+ * @remark The producer (the GLFW callbacks or a synthetic source on another thread) only pushes
+ * timestamped events. The render thread applies them in order once per loop, so clicks and
+ * drags shorter than a frame are not lost, and records every position since the last drawn
+ * frame as a motion sample for shaders which draw strokes.
+ *
+ * iMouse is in pixels of the render size: xy is the cursor while the button is down and keeps
+ * the last position after the release, zw is the click position. z is positive while the
+ * button is down and w is positive only in the first frame drawn after the click, both are
+ * negated otherwise.
+ */
+struct MouseInput {
+    static constexpr size_t QUEUE_CAPACITY = 1024; /**< Events between two updates */
+    static constexpr size_t MAX_SAMPLES    = 256;  /**< Motion samples kept per drawn frame */
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Motion sample in the GLSLLiveMouseSamples layout: xy position in pixels, z 1 if
+     * the button is down, w age in seconds at the last update
+     */
+    using Sample = glm::vec4;
+
+    explicit MouseInput() noexcept;
+
+    MouseInput(const MouseInput&)             = delete;
+    MouseInput& operator= (const MouseInput&) = delete;
+
+    /**
+     * @brief Queues a cursor move, called only by the producer
+     */
+    void PushMove(glm::vec2 position_) noexcept;
+
+    /**
+     * @brief Queues a press or a release of the left button, called only by the producer
+     */
+    void PushButton(glm::vec2 position_, bool is_pressed_) noexcept;
+
+    /**
+     * @brief Applies the queued events, called by the render thread once per loop
+     *
+     * @param oldest_time_ Arrival of the oldest applied event
+     * @param count_ Number of the applied events
+     *
+     * @return true if there were events, false otherwise
+     */
+    bool Update(Clock::time_point& oldest_time_, uint64_t& count_) noexcept;
+
+    /**
+     * @brief Returns iMouse for the render size
+     */
+    glm::vec4 GetMouse(glm::vec2 resolution_) const noexcept;
+
+    /**
+     * @brief Writes the motion samples since the last drawn frame for the render size
+     *
+     * @return Number of the written samples
+     */
+    size_t GetSamples(glm::vec2                        resolution_,
+                      std::array<Sample, MAX_SAMPLES>& samples_) const noexcept;
+
+    /**
+     * @brief Marks the state as shown, clears the click flag and the motion samples, call after
+     * the builtins of a drawn frame are set
+     */
+    void OnFrameConsumed() noexcept;
+
+    /**
+     * @brief Returns the number of the events lost because the queue was full
+     */
+    uint64_t GetDroppedEventCount() const noexcept;
+
+private:
+
+    /**
+     * @brief Position of a motion sample, normalized like the events
+     */
+    struct MotionSample {
+        Clock::time_point time;
+        glm::vec2         position { 0.0f };
+        bool              is_down = false;
+    };
+
+    void Push(glm::vec2 position_, MouseEventType type_) noexcept;
+
+    void AddSample(const MouseEvent& event_) noexcept;
+
+private:
+    SpscQueue<MouseEvent, QUEUE_CAPACITY> queue;
+    std::atomic<uint64_t>                 dropped_events = 0; /**< Written by the producer */
+
+    glm::vec2 drag_position { 0.0f };  /**< Cursor while the button is down, iMouse.xy */
+    glm::vec2 click_position { 0.0f }; /**< Position of the last press, iMouse.zw */
+    bool      is_down    = false;
+    bool      is_clicked = false;      /**< Pressed and no frame was drawn since */
+
+    Clock::time_point                     update_time; /**< Of the last applied events */
+    std::array<MotionSample, MAX_SAMPLES> samples;
+    size_t                                sample_count = 0;
+};
+
+/**
+ * @brief Shader storage buffer with the motion samples of the frame, read by shaders which
+ * use iMouseSamples and iMouseSampleCount
+ *
+ * @remark The samples are few and the buffer is small, it is orphaned and only the used part is
+ * written every frame, so the driver never waits for a draw still reading the previous samples.
+ */
+struct MouseSampleBuffer {
+    static constexpr GLuint BINDING = 1; /**< Binding point of the GLSLLiveMouseSamples block */
+
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit MouseSampleBuffer() noexcept;
+
+    MouseSampleBuffer(const MouseSampleBuffer&)             = delete;
+    MouseSampleBuffer& operator= (const MouseSampleBuffer&) = delete;
+
+    ~MouseSampleBuffer();
+
+    /**
+     * @brief Uploads the samples since the last drawn frame and binds the buffer
+     */
+    void Update(const MouseInput& mouse_input_, glm::vec2 resolution_) noexcept;
+
+    /**
+     * @brief Uploads no samples and binds the buffer, for frames which must not depend on the
+     * mouse
+     */
+    void Clear() noexcept;
+
+private:
+
+    /**
+     * @brief std430 layout of the GLSLLiveMouseSamples block
+     */
+    struct Data {
+        static constexpr size_t SAMPLE_COUNT = MouseInput::MAX_SAMPLES;
+
+        int32_t                                      count = 0;
+        int32_t                                      padding[3] {}; /**< Aligns the samples */
+        std::array<MouseInput::Sample, SAMPLE_COUNT> samples {};
+    };
+
+    /**
+     * @brief Writes the used part of the data into a new storage of the buffer and binds it
+     */
+    void Upload() noexcept;
+
+private:
+    GLuint buffer = 0;
+    Data   data;
+};
@@ -18,6 +18,8 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
 #include <random>
 #include <optional>
@@ -28,6 +30,12 @@
 #include <stdexcept>
 #include <algorithm>
 #include <numeric>
+#include <ctime>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <bit>
+#include <charconv>
 
 // Third-party library headers
 #include <glad/glad.h>  // GLAD MUST BE FIRST
@@ -57,5 +65,12 @@
 #define LOG_ERROR(...)    SPDLOG_ERROR(__VA_ARGS__)
 #define LOG_CRITICAL(...) SPDLOG_CRITICAL(__VA_ARGS__)  // Highest level
 
+// stb headers, the implementation is compiled in StbImplementation.cpp
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+// JSON library
+#include <nlohmann/json.hpp>
+
 // Magic Enum library
 #include <magic_enum/magic_enum.hpp>
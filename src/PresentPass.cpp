@@ -0,0 +1,63 @@
+#include "PresentPass.h"
+
+namespace {
+
+constexpr std::string_view PRESENT_VERTEX = R"(#version 450 core
+out vec2 uv;
+void main()
+{
+    // One triangle which covers the viewport
+    uv          = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+constexpr std::string_view PRESENT_FRAGMENT = R"(#version 450 core
+in vec2 uv;
+layout(binding = 0) uniform sampler2D source;
+out vec4 color;
+void main() { color = texture(source, uv); }
+)";
+
+}  // namespace
+
+PresentPass::PresentPass() noexcept
+{
+    if (!vertex_shader.CompileFromText(PRESENT_VERTEX, ShaderType::VERTEX)
+        || !fragment_shader.CompileFromText(PRESENT_FRAGMENT, ShaderType::FRAGMENT))
+    {
+        LOG_ERROR("Failed to compile the present pass: {}{}",
+                  vertex_shader.GetCompilationError(),
+                  fragment_shader.GetCompilationError());
+        return;
+    }
+
+    program = ShaderProgram(vertex_shader, fragment_shader);
+    if (program.GetID() == 0) { LOG_ERROR("Failed to link the present pass"); }
+
+    glCreateVertexArrays(1, &vertex_array);
+}
+
+PresentPass::~PresentPass()
+{
+    if (vertex_array) { glDeleteVertexArrays(1, &vertex_array); }
+}
+
+bool PresentPass::IsValid() const noexcept { return program.GetID() != 0; }
+
+void PresentPass::Draw(GLuint  texture_,
+                       GLuint  framebuffer_,
+                       int32_t width_,
+                       int32_t height_) noexcept
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width_, height_);
+
+    if (!IsValid()) { return; }
+
+    program.Use();
+    glBindTextureUnit(0, texture_);
+    glBindVertexArray(vertex_array);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindTextureUnit(0, 0);
+}
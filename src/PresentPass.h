@@ -0,0 +1,39 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "Shader.h"
+#include "ShaderProgram.h"
+
+/**
+ * @brief Draws a texture stretched over a framebuffer with bilinear filtering
+ *
+ * @remark Used instead of glBlitFramebuffer, which can not write into the multisampled window
+ * framebuffer. A 2x larger texture is box filtered, every sample lands between four texels.
+ */
+struct PresentPass {
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit PresentPass() noexcept;
+
+    PresentPass(const PresentPass&)             = delete;
+    PresentPass& operator= (const PresentPass&) = delete;
+
+    ~PresentPass();
+
+    bool IsValid() const noexcept;
+
+    /**
+     * @brief Draws the texture over the whole framebuffer, which is left bound
+     *
+     * @param texture_ 2D texture with linear filtering
+     */
+    void Draw(GLuint texture_, GLuint framebuffer_, int32_t width_, int32_t height_) noexcept;
+
+private:
+    Shader        vertex_shader;
+    Shader        fragment_shader;
+    ShaderProgram program;
+    GLuint        vertex_array = 0; /**< Empty, the triangle is made from gl_VertexID */
+};
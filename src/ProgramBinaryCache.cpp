@@ -0,0 +1,317 @@
+#include "ProgramBinaryCache.h"
+
+#include "Utils.h"
+
+namespace {
+
+constexpr uint32_t ENTRY_MAGIC   = 0x43424C47;  // "GLBC"
+constexpr uint32_t ENTRY_VERSION = 1;
+
+/**
+ * @brief Header written in front of every cached binary
+ */
+struct EntryHeader {
+    uint32_t magic         = ENTRY_MAGIC;
+    uint32_t version       = ENTRY_VERSION;
+    uint64_t key           = 0; /**< Key of the entry, must match the file name */
+    uint64_t driver_hash   = 0; /**< Driver which produced the binary */
+    uint32_t binary_format = 0; /**< Driver specific format of the binary */
+    uint32_t binary_size   = 0; /**< Size of the binary following the header */
+    uint64_t checksum      = 0; /**< Hash of the binary, detects corrupt entries */
+};
+
+/**
+ * @brief Returns true if the name is a key written by GetEntryPath(), 16 hex digits
+ */
+bool IsEntryStem(const std::string& stem_)
+{
+    constexpr size_t KEY_DIGITS = 16;
+    return stem_.size() == KEY_DIGITS
+        && std::all_of(stem_.begin(),
+                       stem_.end(),
+                       [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; });
+}
+
+std::string GetGLString(GLenum name_)
+{
+    const auto* value = reinterpret_cast<const char*>(glGetString(name_));
+    return value ? value : "";
+}
+
+}  // namespace
+
+ProgramBinaryCache::ProgramBinaryCache(std::string_view directory_path_,
+                                       uint64_t         max_bytes_) noexcept :
+    directory(GetApplicationPath() + "/" + std::string(directory_path_)),
+    max_bytes(max_bytes_),
+    driver_hash(0),
+    is_enabled(false)
+{}
+
+bool ProgramBinaryCache::Initialize() noexcept
+{
+    GLint formats_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_count);
+
+    if (formats_count <= 0)
+    {
+        LOG_WARN("Driver does not support program binaries, the program cache is disabled");
+        return false;
+    }
+
+    binary_formats.resize(static_cast<size_t>(formats_count));
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, binary_formats.data());
+
+    // Any change of the driver makes the old binaries stale, the format is checked per entry
+    driver_hash = HashText(GetGLString(GL_VENDOR));
+    driver_hash = HashText(GetGLString(GL_RENDERER), driver_hash);
+    driver_hash = HashText(GetGLString(GL_VERSION), driver_hash);
+
+    // Write time, key and size of every entry, listed without the lock
+    std::vector<std::tuple<std::filesystem::file_time_type, uint64_t, uint64_t>> files;
+
+    try
+    {
+        std::filesystem::create_directories(directory);
+
+        for (const auto& p : std::filesystem::directory_iterator(directory))
+        {
+            if (!p.is_regular_file()) { continue; }
+
+            // Only files the cache wrote are touched, anything else in the directory is kept
+            const auto& path = p.path();
+            if (!IsEntryStem(path.stem().stem().string())) { continue; }
+
+            if (path.extension() == ".tmp" && path.stem().extension() == ".bin")
+            {
+                std::filesystem::remove(path);  // Leftover of an interrupted store
+                continue;
+            }
+
+            if (path.extension() != ".bin") { continue; }
+
+            const uint64_t key = std::strtoull(path.stem().string().c_str(), nullptr, 16);
+            files.emplace_back(p.last_write_time(), key, p.file_size());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("Failed to open the program cache directory {}: {}", directory, e.what());
+        return false;
+    }
+
+    // Index the entries from the oldest to the newest, so the LRU order survives restarts
+    std::sort(files.begin(),
+              files.end(),
+              [](const auto& a, const auto& b) { return std::get<0>(a) < std::get<0>(b); });
+
+    std::lock_guard lock(mutex);
+
+    for (const auto& [time, key, size] : files)
+    {
+        entries[key] = Entry { size, ++use_tick };
+        total_bytes += size;
+    }
+
+    Evict();  // The limit could be lowered since the last run
+
+    LOG_INFO("Program cache: {} entries, {} bytes", entries.size(), total_bytes);
+
+    is_enabled = true;
+    return true;
+}
+
+bool ProgramBinaryCache::IsEnabled() const noexcept { return is_enabled; }
+
+uint64_t ProgramBinaryCache::MakeKey(std::string_view vertex_source_,
+                                     std::string_view fragment_source_) const noexcept
+{
+    return HashCombine(HashCombine(driver_hash, HashText(vertex_source_)),
+                       HashText(fragment_source_));
+}
+
+bool ProgramBinaryCache::Load(uint64_t key_, ShaderProgram& shader_program_) noexcept
+{
+    if (!is_enabled) { return false; }
+
+    {
+        std::lock_guard lock(mutex);
+
+        if (!entries.contains(key_))
+        {
+            ++stats.misses;
+            return false;
+        }
+    }
+
+    // Read without the lock, a concurrent store of the key replaces the file atomically
+    const auto path = GetEntryPath(key_);
+
+    std::error_code error;
+    const auto      file_size = std::filesystem::file_size(path, error);
+
+    std::ifstream in_file(path, std::ios::in | std::ios::binary);
+
+    EntryHeader       header;
+    std::vector<char> binary;
+
+    // The size check also protects against allocating a garbage size from a corrupt header
+    if (!error && in_file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        && sizeof(header) + header.binary_size == file_size)
+    {
+        binary.resize(header.binary_size);
+        in_file.read(binary.data(), header.binary_size);
+    }
+
+    const uint64_t checksum = HashText(std::string_view(binary.data(), binary.size()));
+
+    const bool is_format_supported =
+        std::find(binary_formats.begin(),
+                  binary_formats.end(),
+                  static_cast<GLint>(header.binary_format))
+        != binary_formats.end();
+
+    const bool is_valid = in_file.good() && header.magic == ENTRY_MAGIC
+                       && header.version == ENTRY_VERSION && header.key == key_
+                       && header.driver_hash == driver_hash && header.checksum == checksum
+                       && is_format_supported;
+
+    in_file.close();
+
+    ShaderProgram shader_program;
+
+    if (is_valid)
+    {
+        shader_program = ShaderProgram(static_cast<GLenum>(header.binary_format),
+                                       binary.data(),
+                                       static_cast<GLsizei>(binary.size()));
+    }
+
+    // Corrupt file or a binary the driver does not accept anymore
+    if (shader_program.GetID() == 0)
+    {
+        LOG_WARN("Removing invalid program cache entry: {}", path);
+
+        std::lock_guard lock(mutex);
+        RemoveEntry(key_);
+        ++stats.rejected;
+        ++stats.misses;
+        return false;
+    }
+
+    shader_program_ = std::move(shader_program);
+
+    {
+        std::lock_guard lock(mutex);
+
+        auto it = entries.find(key_);
+        if (it != entries.end()) { it->second.last_used = ++use_tick; }
+        ++stats.hits;
+    }
+
+    try  // Persist the LRU order for the next run
+    {
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_WARN("Failed to touch program cache entry: {}", e.what());
+    }
+
+    return true;
+}
+
+bool ProgramBinaryCache::Store(uint64_t key_, const ShaderProgram& shader_program_) noexcept
+{
+    if (!is_enabled) { return false; }
+
+    EntryHeader       header;
+    std::vector<char> binary;
+    GLenum            binary_format = 0;
+
+    if (!shader_program_.GetBinary(binary_format, binary)) { return false; }
+
+    header.key           = key_;
+    header.driver_hash   = driver_hash;
+    header.binary_format = static_cast<uint32_t>(binary_format);
+    header.binary_size   = static_cast<uint32_t>(binary.size());
+    header.checksum      = HashText(std::string_view(binary.data(), binary.size()));
+
+    std::lock_guard lock(mutex);
+
+    const auto path      = GetEntryPath(key_);
+    const auto temp_path = path + ".tmp";
+
+    {
+        std::ofstream out_file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+        if (!out_file.good())
+        {
+            LOG_ERROR("Failed to write program cache entry: {}", temp_path);
+            return false;
+        }
+    }
+
+    try  // Readers never see a half written entry
+    {
+        std::filesystem::rename(temp_path, path);
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("Failed to store program cache entry: {}", e.what());
+        std::error_code error;
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    const uint64_t size = sizeof(header) + binary.size();
+
+    if (auto it = entries.find(key_); it != entries.end()) { total_bytes -= it->second.size; }
+
+    entries[key_] = Entry { size, ++use_tick };
+    total_bytes  += size;
+    ++stats.stores;
+
+    Evict();
+
+    return true;
+}
+
+ProgramCacheStats ProgramBinaryCache::GetStats() const noexcept
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+std::string ProgramBinaryCache::GetEntryPath(uint64_t key_) const
+{
+    return fmt::format("{}/{:016x}.bin", directory, key_);
+}
+
+void ProgramBinaryCache::RemoveEntry(uint64_t key_) noexcept
+{
+    if (auto it = entries.find(key_); it != entries.end())
+    {
+        total_bytes -= it->second.size;
+        entries.erase(it);
+    }
+
+    std::error_code error;
+    std::filesystem::remove(GetEntryPath(key_), error);
+}
+
+void ProgramBinaryCache::Evict() noexcept
+{
+    while (total_bytes > max_bytes && !entries.empty())
+    {
+        auto oldest = std::min_element(entries.begin(),
+                                       entries.end(),
+                                       [](const auto& a, const auto& b)
+                                       { return a.second.last_used < b.second.last_used; });
+
+        RemoveEntry(oldest->first);
+        ++stats.evictions;
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "ShaderProgram.h"
+
+/**
+ * @brief Counters of the program binary cache
+ */
+struct ProgramCacheStats {
+    uint64_t hits      = 0; /**< Programs loaded from the cache */
+    uint64_t misses    = 0; /**< Lookups without a usable entry */
+    uint64_t stores    = 0; /**< Programs written to the cache */
+    uint64_t evictions = 0; /**< Entries removed to stay under the size limit */
+    uint64_t rejected  = 0; /**< Corrupt or stale entries which were removed */
+};
+
+/**
+ * @brief Persistent on-disk cache of linked program binaries, so unchanged shaders skip compile
+ * and link on start-up and when switching shaders
+ *
+ * @remark Entries are keyed by the shader sources and the driver vendor, renderer and version. The
+ * binary format the driver picked is stored in the entry and checked on load, so a driver which
+ * only adds or drops formats keeps the entries of the formats it still supports. The total size
+ * is bounded, the least recently used entries are evicted first. Thread safe, the files are read
+ * without holding the lock.
+ */
+struct ProgramBinaryCache {
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 64ull * 1024 * 1024;
+
+    /**
+     * @param directory_path_ Directory of the cache, relative to the application directory
+     * @param max_bytes_ Maximum total size of the entries
+     */
+    explicit ProgramBinaryCache(std::string_view directory_path_,
+                                uint64_t         max_bytes_ = DEFAULT_MAX_BYTES) noexcept;
+
+    ProgramBinaryCache(const ProgramBinaryCache&)             = delete;
+    ProgramBinaryCache& operator= (const ProgramBinaryCache&) = delete;
+
+    /**
+     * @brief Reads the driver identification and indexes the entries on disk
+     *
+     * @remark Must be called with a current GL context
+     *
+     * @return true if the cache can be used, false if the driver does not support program binaries
+     */
+    bool Initialize() noexcept;
+
+    bool IsEnabled() const noexcept;
+
+    /**
+     * @brief Creates the key of the program linked from the given sources on this driver
+     */
+    uint64_t MakeKey(std::string_view vertex_source_,
+                     std::string_view fragment_source_) const noexcept;
+
+    /**
+     * @brief Loads the cached program
+     *
+     * @param key_ Key of the program
+     * @param shader_program_ Storage for the loaded program, untouched on a miss
+     *
+     * @return true if the program was loaded, false if there is no usable entry
+     *
+     * @remark Corrupt or stale entries are removed
+     */
+    bool Load(uint64_t key_, ShaderProgram& shader_program_) noexcept;
+
+    /**
+     * @brief Stores the binary of the linked program and evicts old entries if needed
+     *
+     * @return true if the entry was written, false otherwise
+     */
+    bool Store(uint64_t key_, const ShaderProgram& shader_program_) noexcept;
+
+    ProgramCacheStats GetStats() const noexcept;
+
+private:
+
+    struct Entry {
+        uint64_t size      = 0; /**< Size of the file in bytes */
+        uint64_t last_used = 0; /**< Tick of the last load or store */
+    };
+
+    std::string GetEntryPath(uint64_t key_) const;
+
+    /**
+     * @brief Removes the entry from disk and from the index, the mutex must be locked
+     */
+    void RemoveEntry(uint64_t key_) noexcept;
+
+    /**
+     * @brief Removes the least recently used entries until the size fits, the mutex must be locked
+     */
+    void Evict() noexcept;
+
+private:
+    std::string directory;   /**< Full path of the cache directory */
+    uint64_t    max_bytes;   /**< Maximum total size of the entries */
+    uint64_t    driver_hash; /**< Hash of the vendor, renderer and version */
+    bool        is_enabled;  /**< Flag indicating if the cache can be used */
+
+    std::vector<GLint> binary_formats; /**< Formats the driver accepts, set by Initialize() */
+
+    mutable std::mutex                  mutex;
+    std::unordered_map<uint64_t, Entry> entries;         /**< Index of the entries on disk */
+    uint64_t                            total_bytes = 0; /**< Total size of the entries */
+    uint64_t                            use_tick    = 0; /**< Increasing LRU clock */
+    ProgramCacheStats                   stats;
+};
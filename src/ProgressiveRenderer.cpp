@@ -0,0 +1,188 @@
+#include "ProgressiveRenderer.h"
+
+ProgressiveRenderer::ProgressiveRenderer() noexcept {}
+
+ProgressiveRenderer::~ProgressiveRenderer() { DeleteBuffer(); }
+
+void ProgressiveRenderer::SetTiled(bool is_tiled_) noexcept
+{
+    if (is_tiled == is_tiled_) { return; }
+
+    is_tiled             = is_tiled_;
+    is_restart_requested = true;
+}
+
+bool ProgressiveRenderer::IsTiled() const noexcept { return is_tiled; }
+
+void ProgressiveRenderer::SetTileSize(int32_t tile_size_) noexcept
+{
+    tile_size_ = std::clamp(tile_size_, MIN_TILE_SIZE, MAX_TILE_SIZE);
+    if (tile_size == tile_size_) { return; }
+
+    tile_size            = tile_size_;
+    is_restart_requested = true;
+}
+
+int32_t ProgressiveRenderer::GetTileSize() const noexcept { return tile_size; }
+
+void ProgressiveRenderer::SetTilesPerFrame(int32_t tiles_per_frame_) noexcept
+{
+    tiles_per_frame = std::max(tiles_per_frame_, 1);
+}
+
+int32_t ProgressiveRenderer::GetTilesPerFrame() const noexcept { return tiles_per_frame; }
+
+void ProgressiveRenderer::SetAccumulationEnabled(bool is_enabled_) noexcept
+{
+    is_accumulation = is_enabled_;
+}
+
+bool ProgressiveRenderer::IsAccumulationEnabled() const noexcept { return is_accumulation; }
+
+bool ProgressiveRenderer::IsActive(bool is_paused_) const noexcept
+{
+    return is_tiled || (is_paused_ && is_accumulation);
+}
+
+const BuiltinUniformData& ProgressiveRenderer::BeginFrame(
+    const RenderGraph&        render_graph_,
+    const BuiltinUniformData& builtins_,
+    int32_t                   width_,
+    int32_t                   height_,
+    bool                      is_accumulating_) noexcept
+{
+    if (width != width_ || height != height_)
+    {
+        DeleteBuffer();
+
+        width  = width_;
+        height = height_;
+        CreateBuffer();
+
+        is_restart_requested = true;
+    }
+
+    // A sample with the camera somewhere else would smear the average
+    const bool is_mouse_moved =
+        is_accumulating_ && tile == 0 && builtins_.mouse != image_builtins.mouse;
+
+    if (is_restart_requested || is_mouse_moved || is_accumulating_ != is_accumulating
+        || render_graph_.GetVersion() != graph_version)
+    {
+        tile                 = 0;
+        sample_count         = 0;
+        is_accumulating      = is_accumulating_;
+        graph_version        = render_graph_.GetVersion();
+        is_restart_requested = false;
+    }
+
+    if (tile == 0) { image_builtins = builtins_; }
+
+    return image_builtins;
+}
+
+void ProgressiveRenderer::Render(RenderGraph&      render_graph_,
+                                 const ScreenQuad& screen_quad_,
+                                 GLuint            framebuffer_) noexcept
+{
+    if (!framebuffer) { return; }
+
+    // The buffers are drawn once per image, all tiles read the same buffers
+    if (tile == 0) { render_graph_.ExecuteBuffers(image_builtins, screen_quad_); }
+
+    const int32_t tile_count = GetTileCount();
+    const int32_t last_tile  = is_tiled ? std::min(tile + tiles_per_frame, tile_count) : tile_count;
+
+    // Running average, the n-th sample gets the weight 1 / n and the older ones keep the rest
+    const bool is_blended = is_accumulating && sample_count > 0;
+    if (is_blended)
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+        glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / static_cast<float>(sample_count + 1));
+    }
+
+    for (; tile < last_tile; ++tile)
+    {
+        const glm::ivec4 rect = GetTileRect(tile);
+        render_graph_.ExecuteImage(image_builtins,
+                                   screen_quad_,
+                                   framebuffer,
+                                   is_tiled ? &rect : nullptr);
+
+        // Every tile is submitted on its own, the driver never waits for the whole image
+        if (is_tiled) { glFlush(); }
+    }
+
+    if (is_blended) { glDisable(GL_BLEND); }
+
+    if (tile == tile_count)
+    {
+        tile = 0;
+        ++image_count;
+
+        if (is_accumulating) { ++sample_count; }
+    }
+
+    present_pass.Draw(texture, framebuffer_, width, height);
+}
+
+void ProgressiveRenderer::Restart() noexcept { is_restart_requested = true; }
+
+int32_t ProgressiveRenderer::GetTileCount() const noexcept
+{
+    if (!is_tiled) { return 1; }
+
+    const int32_t columns = (width + tile_size - 1) / tile_size;
+    const int32_t rows    = (height + tile_size - 1) / tile_size;
+    return std::max(columns * rows, 1);
+}
+
+int32_t ProgressiveRenderer::GetCompletedTileCount() const noexcept { return tile; }
+
+uint32_t ProgressiveRenderer::GetSampleCount() const noexcept { return sample_count; }
+
+uint64_t ProgressiveRenderer::GetImageCount() const noexcept { return image_count; }
+
+glm::ivec4 ProgressiveRenderer::GetTileRect(int32_t tile_) const noexcept
+{
+    if (!is_tiled) { return glm::ivec4(0, 0, width, height); }
+
+    const int32_t columns = (width + tile_size - 1) / tile_size;
+    const int32_t x       = (tile_ % columns) * tile_size;
+    const int32_t y       = (tile_ / columns) * tile_size;
+
+    return glm::ivec4(x, y, std::min(tile_size, width - x), std::min(tile_size, height - y));
+}
+
+void ProgressiveRenderer::CreateBuffer() noexcept
+{
+    if (width <= 0 || height <= 0) { return; }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, BUFFER_FORMAT, width, height);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glClearTexImage(texture, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0);
+
+    const GLenum status = glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR("Progressive framebuffer is incomplete: 0x{:X}", status);
+        DeleteBuffer();
+    }
+}
+
+void ProgressiveRenderer::DeleteBuffer() noexcept
+{
+    if (framebuffer) { glDeleteFramebuffers(1, &framebuffer); }
+    if (texture) { glDeleteTextures(1, &texture); }
+
+    framebuffer = 0;
+    texture     = 0;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "RenderGraph.h"
+#include "PresentPass.h"
+
+/**
+ * @brief Draws the image of the render graph over several frames into a persistent buffer
+ *
+ * @remark Two modes, which can be combined:
+ * - Tiled: the image pass is drawn in scissored tiles, a few per frame, so a shader which takes
+ *   seconds per frame never blocks the driver for long (or trips the GPU watchdog). The buffers and
+ *   the builtins are frozen from the first tile until the image is complete, the finished tiles of
+ *   the previous image stay visible as a progressive preview.
+ * - Accumulation: while iTime is paused every image is one sample, blended into the buffer with the
+ *   weight 1 / (samples + 1) so it holds the average of all samples. iFrame keeps counting, so
+ *   stochastic shaders seeded by it converge.
+ *
+ * The buffer is RGBA32F and restarts when the size, a program or a binding changes, or the mouse
+ * moves while accumulating.
+ */
+struct ProgressiveRenderer {
+    static constexpr GLenum  BUFFER_FORMAT           = GL_RGBA32F;
+    static constexpr int32_t MIN_TILE_SIZE           = 32;
+    static constexpr int32_t MAX_TILE_SIZE           = 2048;
+    static constexpr int32_t DEFAULT_TILE_SIZE       = 256;
+    static constexpr int32_t DEFAULT_TILES_PER_FRAME = 4;
+
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit ProgressiveRenderer() noexcept;
+
+    ProgressiveRenderer(const ProgressiveRenderer&)             = delete;
+    ProgressiveRenderer& operator= (const ProgressiveRenderer&) = delete;
+
+    ~ProgressiveRenderer();
+
+    void SetTiled(bool is_tiled_) noexcept;
+    bool IsTiled() const noexcept;
+
+    void    SetTileSize(int32_t tile_size_) noexcept;
+    int32_t GetTileSize() const noexcept;
+
+    void    SetTilesPerFrame(int32_t tiles_per_frame_) noexcept;
+    int32_t GetTilesPerFrame() const noexcept;
+
+    /**
+     * @brief Enables averaging the samples while iTime is paused
+     */
+    void SetAccumulationEnabled(bool is_enabled_) noexcept;
+    bool IsAccumulationEnabled() const noexcept;
+
+    /**
+     * @brief Returns true if the frame must be drawn by the renderer instead of the graph directly
+     *
+     * @param is_paused_ Flag indicating if iTime is paused
+     */
+    bool IsActive(bool is_paused_) const noexcept;
+
+    /**
+     * @brief Starts the frame and returns the builtins it must be drawn with, which are the ones
+     * of the first tile of the image
+     *
+     * @param is_accumulating_ Flag indicating if the image is a sample of the paused frame
+     */
+    const BuiltinUniformData& BeginFrame(const RenderGraph&        render_graph_,
+                                         const BuiltinUniformData& builtins_,
+                                         int32_t                   width_,
+                                         int32_t                   height_,
+                                         bool                      is_accumulating_) noexcept;
+
+    /**
+     * @brief Draws the tiles of the frame into the buffer, then copies the buffer into the
+     * framebuffer
+     */
+    void Render(RenderGraph&      render_graph_,
+                const ScreenQuad& screen_quad_,
+                GLuint            framebuffer_) noexcept;
+
+    /**
+     * @brief Discards the buffer, the next frame starts a new image
+     */
+    void Restart() noexcept;
+
+    int32_t  GetTileCount() const noexcept;
+    int32_t  GetCompletedTileCount() const noexcept; /**< Of the image being drawn */
+    uint32_t GetSampleCount() const noexcept;        /**< Samples in the buffer */
+    uint64_t GetImageCount() const noexcept;         /**< Images completed since the start */
+
+private:
+
+    /**
+     * @brief Returns the region of the tile (x, y, width, height), the whole image if not tiled
+     */
+    glm::ivec4 GetTileRect(int32_t tile_) const noexcept;
+
+    void CreateBuffer() noexcept;
+    void DeleteBuffer() noexcept;
+
+private:
+    bool    is_tiled             = false;
+    bool    is_accumulation      = false; /**< Flag indicating if accumulation is enabled */
+    int32_t tile_size            = DEFAULT_TILE_SIZE;
+    int32_t tiles_per_frame      = DEFAULT_TILES_PER_FRAME;
+    bool    is_accumulating      = false; /**< Flag indicating if the image is a sample */
+    bool    is_restart_requested = true;
+
+    GLuint      texture     = 0; /**< Persistent buffer */
+    GLuint      framebuffer = 0;
+    int32_t     width       = 0;
+    int32_t     height      = 0;
+    PresentPass present_pass; /**< Copies the buffer into the framebuffer */
+
+    BuiltinUniformData image_builtins; /**< Builtins of the first tile of the image */
+    uint64_t           graph_version = 0;
+    int32_t            tile          = 0; /**< Next tile of the image */
+    uint32_t           sample_count  = 0;
+    uint64_t           image_count   = 0;
+};
@@ -0,0 +1,44 @@
+#include "RecompileScheduler.h"
+
+uint64_t RecompileStats::GetCompilesSkipped() const noexcept
+{
+    return edits_coalesced + requests_superseded + compiles_cancelled;
+}
+
+RecompileScheduler::RecompileScheduler(std::chrono::milliseconds idle_window_) noexcept :
+    idle_window(idle_window_)
+{}
+
+bool RecompileScheduler::Update(uint64_t code_hash_, Clock::time_point now_) noexcept
+{
+    if (!has_pending || code_hash_ != pending_hash)
+    {
+        // The previous edit was not compiled yet, this one replaces it
+        if (has_pending) { ++stats.edits_coalesced; }
+
+        ++stats.edits;
+        pending_hash   = code_hash_;
+        last_edit_time = now_;
+        has_pending    = true;
+    }
+
+    if (now_ - last_edit_time < idle_window) { return false; }
+
+    has_pending = false;
+    ++stats.requests_issued;
+    return true;
+}
+
+void RecompileScheduler::SetIdleWindow(std::chrono::milliseconds idle_window_) noexcept
+{
+    idle_window = idle_window_;
+}
+
+std::chrono::milliseconds RecompileScheduler::GetIdleWindow() const noexcept
+{
+    return idle_window;
+}
+
+RecompileStats& RecompileScheduler::GetStats() noexcept { return stats; }
+
+const RecompileStats& RecompileScheduler::GetStats() const noexcept { return stats; }
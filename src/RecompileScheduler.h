@@ -0,0 +1,54 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Counters of the recompile scheduling, used to see how much driver work is avoided
+ */
+struct RecompileStats {
+    uint64_t edits               = 0; /**< Number of the code changes seen */
+    uint64_t requests_issued     = 0; /**< Number of the compile requests issued */
+    uint64_t edits_coalesced     = 0; /**< Edits merged into a later request */
+    uint64_t requests_superseded = 0; /**< Requests replaced by newer ones before compiling */
+    uint64_t compiles_cancelled  = 0; /**< Compiles of stale revisions stopped before linking */
+
+    /**
+     * @brief Returns the number of the compiles which were not done thanks to the scheduling
+     */
+    uint64_t GetCompilesSkipped() const noexcept;
+};
+
+/**
+ * @brief Coalesces bursts of edits into one compile request issued after an idle window
+ */
+struct RecompileScheduler {
+    using Clock = std::chrono::steady_clock;
+
+    explicit RecompileScheduler(std::chrono::milliseconds idle_window_) noexcept;
+
+    /**
+     * @brief Reports the current revision of the code and checks if it should be compiled now
+     *
+     * @param code_hash_ Hash of the code which differs from the last compiled one
+     * @param now_ Current time
+     *
+     * @return true if the code did not change for the idle window and should be compiled
+     */
+    bool Update(uint64_t code_hash_, Clock::time_point now_) noexcept;
+
+    void SetIdleWindow(std::chrono::milliseconds idle_window_) noexcept;
+
+    std::chrono::milliseconds GetIdleWindow() const noexcept;
+
+    RecompileStats& GetStats() noexcept;
+
+    const RecompileStats& GetStats() const noexcept;
+
+private:
+    std::chrono::milliseconds idle_window;          /**< Time without edits before compiling */
+    Clock::time_point         last_edit_time;       /**< Time of the last seen edit */
+    uint64_t                  pending_hash = 0;     /**< Hash of the edit waiting for compile */
+    bool                      has_pending  = false; /**< Flag indicating if an edit is waiting */
+
+    RecompileStats stats;
+};
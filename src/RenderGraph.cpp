@@ -0,0 +1,593 @@
+#include "RenderGraph.h"
+
+namespace {
+
+constexpr size_t IMAGE_PASS = static_cast<size_t>(RenderPassId::IMAGE);
+
+constexpr std::array<std::string_view, BUFFER_PASS_COUNT> BUFFER_NAMES = {
+    "BufferA", "BufferB", "BufferC", "BufferD"
+};
+
+/**
+ * @brief Builtins which change from frame to frame, a pass reading none of them can be reused
+ */
+constexpr std::array<std::string_view, 8> TIME_BUILTIN_NAMES = {
+    "iTime", "iTimeDelta", "iFrame", "iFrameRate", "iMouse", "iDate",
+    "iMouseSamples", "iMouseSampleCount"
+};
+
+bool IsIdentifierChar(char c_)
+{
+    return std::isalnum(static_cast<unsigned char>(c_)) || c_ == '_';
+}
+
+/**
+ * @brief Splits the text into identifiers and numbers
+ */
+template<typename Function>
+void ForEachToken(std::string_view text_, Function&& function_)
+{
+    size_t i = 0;
+    while (i < text_.size())
+    {
+        if (!IsIdentifierChar(text_[i]))
+        {
+            ++i;
+            continue;
+        }
+
+        const size_t start = i;
+        while (i < text_.size() && IsIdentifierChar(text_[i])) { ++i; }
+
+        if (!function_(text_.substr(start, i - start))) { return; }
+    }
+}
+
+}  // namespace
+
+ChannelBindings ParseChannelBindings(std::string_view code_)
+{
+    ChannelBindings channels;
+
+    for (size_t start = 0; start < code_.size();)
+    {
+        const size_t end  = std::min(code_.find('\n', start), code_.size());
+        const auto   line = code_.substr(start, end - start);
+        start             = end + 1;
+
+        const size_t hash = line.find_first_not_of(" \t");
+        if (hash == std::string_view::npos || line[hash] != '#') { continue; }
+
+        std::array<std::string_view, 3> tokens;
+        size_t                          token_count = 0;
+        ForEachToken(line.substr(hash + 1),
+                     [&](std::string_view token)
+                     {
+                         tokens[token_count++] = token;
+                         return token_count < tokens.size();
+                     });
+
+        if (token_count < 2 || tokens[0] != "pragma" || !tokens[1].starts_with("iChannel")
+            || tokens[1].size() != 9)
+        {
+            continue;
+        }
+
+        const int32_t channel = tokens[1].back() - '0';
+        if (channel < 0 || channel >= static_cast<int32_t>(RENDER_CHANNEL_COUNT))
+        {
+            LOG_WARN("Unknown channel in the binding: {}", line);
+            continue;
+        }
+
+        // Files are quoted, the path may contain any character but the quote
+        const size_t quote = line.find('"');
+        if (quote != std::string_view::npos)
+        {
+            const size_t closing_quote = line.find('"', quote + 1);
+            if (closing_quote == std::string_view::npos || closing_quote == quote + 1)
+            {
+                LOG_WARN("Invalid path in the binding: {}", line);
+                continue;
+            }
+
+            const bool is_cubemap  = token_count == 3 && tokens[2] == "cube"
+                                 && tokens[2].data() < line.data() + quote;
+            channels[channel].kind = is_cubemap ? ChannelInput::Kind::CUBEMAP
+                                                : ChannelInput::Kind::TEXTURE;
+            channels[channel].path = line.substr(quote + 1, closing_quote - quote - 1);
+            continue;
+        }
+
+        auto name = token_count == 3
+                      ? std::find(BUFFER_NAMES.begin(), BUFFER_NAMES.end(), tokens[2])
+                      : BUFFER_NAMES.end();
+        if (name == BUFFER_NAMES.end())
+        {
+            LOG_WARN("Unknown input in the binding: {}", line);
+            continue;
+        }
+
+        channels[channel].kind   = ChannelInput::Kind::BUFFER;
+        channels[channel].buffer = static_cast<RenderPassId>(name - BUFFER_NAMES.begin());
+    }
+
+    return channels;
+}
+
+RenderGraph::RenderGraph(TextureManager& texture_manager_) noexcept :
+    texture_manager(texture_manager_)
+{}
+
+RenderGraph::~RenderGraph() { DeleteTextures(); }
+
+void RenderGraph::SetPass(RenderPassId     id_,
+                          ShaderProgram*   program_,
+                          uint64_t         generation_,
+                          std::string_view code_) noexcept
+{
+    auto& pass = passes[static_cast<size_t>(id_)];
+
+    if (program_ && program_->GetID() == 0) { program_ = nullptr; }
+
+    if (pass.program == program_ && pass.generation == generation_) { return; }
+
+    pass.program    = program_;
+    pass.generation = generation_;
+    pass.is_changed = true;
+    is_planned      = false;
+    ++version;
+
+    if (!program_)
+    {
+        pass.channels         = {};
+        pass.channel_textures = {};
+        return;
+    }
+
+    // Handles and bindings are resolved once per program, not per frame
+    pass.channels = ParseChannelBindings(code_);
+    pass.builtin_handles.Resolve(*program_);
+
+    // Acquired before the old ones are dropped, so files bound by both programs stay loaded
+    decltype(pass.channel_textures) channel_textures;
+    for (size_t i = 0; i < RENDER_CHANNEL_COUNT; ++i)
+    {
+        const auto& channel = pass.channels[i];
+        if (channel.kind == ChannelInput::Kind::TEXTURE)
+        {
+            channel_textures[i] =
+                texture_manager.Acquire(channel.path, ChannelTextureKind::TEXTURE_2D);
+        }
+        else if (channel.kind == ChannelInput::Kind::CUBEMAP)
+        {
+            channel_textures[i] =
+                texture_manager.Acquire(channel.path, ChannelTextureKind::CUBEMAP);
+        }
+    }
+
+    pass.channel_textures = std::move(channel_textures);
+
+    for (size_t i = 0; i < RENDER_CHANNEL_COUNT; ++i)
+    {
+        pass.channel_handles[i] = program_->GetUniformHandle(fmt::format("iChannel{}", i));
+    }
+
+    pass.is_time_dependent = IsTimeDependent(*program_, code_);
+}
+
+void RenderGraph::SetSize(int32_t width_, int32_t height_) noexcept
+{
+    if (width == width_ && height == height_) { return; }
+
+    DeleteTextures();
+
+    width      = width_;
+    height     = height_;
+    is_planned = false;
+    ++version;
+}
+
+void RenderGraph::Execute(const BuiltinUniformData& builtins_,
+                          const ScreenQuad&         screen_quad_,
+                          GLuint                    framebuffer_) noexcept
+{
+    ExecuteBuffers(builtins_, screen_quad_);
+    ExecuteImage(builtins_, screen_quad_, framebuffer_, nullptr);
+}
+
+void RenderGraph::ExecuteBuffers(const BuiltinUniformData& builtins_,
+                                 const ScreenQuad&         screen_quad_) noexcept
+{
+    if (width <= 0 || height <= 0) { return; }
+
+    if (!is_planned) { Plan(); }
+
+    stats.executed_passes = 0;
+    stats.skipped_passes  = 0;
+    is_executed           = {};
+
+    for (size_t p = 0; p < IMAGE_PASS; ++p)
+    {
+        auto& pass = passes[p];
+        if (!pass.is_active) { continue; }
+
+        // A static pass is drawn again only if a pass it reads was drawn this frame or a file it
+        // reads finished loading
+        bool is_due = pass.is_dynamic || pass.is_dirty;
+        for (size_t i = 0; i < RENDER_CHANNEL_COUNT; ++i)
+        {
+            const int32_t input = GetChannelPass(pass.channels[i]);
+            is_due              = is_due || (input >= 0 && is_executed[input]);
+            is_due              = is_due || GetChannelTexture(pass, i) != pass.drawn_textures[i];
+        }
+
+        if (!is_due)
+        {
+            ++stats.skipped_passes;
+            continue;
+        }
+
+        // The previous frame stays in the front target while the back one is written
+        const int32_t back = pass.has_history ? 1 - pass.front : pass.front;
+        DrawPass(p, builtins_, screen_quad_, pass.targets[back].framebuffer);
+        pass.front = back;
+    }
+
+    for (GLuint i = 0; i < RENDER_CHANNEL_COUNT; ++i) { glBindTextureUnit(i, 0); }
+}
+
+void RenderGraph::ExecuteImage(const BuiltinUniformData& builtins_,
+                               const ScreenQuad&         screen_quad_,
+                               GLuint                    framebuffer_,
+                               const glm::ivec4*         scissor_) noexcept
+{
+    if (width <= 0 || height <= 0) { return; }
+
+    if (!is_planned) { Plan(); }
+
+    if (passes[IMAGE_PASS].is_active)
+    {
+        if (scissor_)
+        {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(scissor_->x, scissor_->y, scissor_->z, scissor_->w);
+        }
+
+        DrawPass(IMAGE_PASS, builtins_, screen_quad_, framebuffer_);
+
+        if (scissor_) { glDisable(GL_SCISSOR_TEST); }
+    }
+
+    for (GLuint i = 0; i < RENDER_CHANNEL_COUNT; ++i) { glBindTextureUnit(i, 0); }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width, height);
+}
+
+void RenderGraph::Reset() noexcept
+{
+    auto clear = [](const GraphTexture& texture)
+    {
+        if (texture.texture) { glClearTexImage(texture.texture, 0, GL_RGBA, GL_FLOAT, nullptr); }
+    };
+
+    for (auto& pass : passes)
+    {
+        for (const auto& texture : pass.owned_textures) { clear(texture); }
+
+        pass.front    = 0;
+        pass.is_dirty = true;
+    }
+
+    for (const auto& texture : transient_textures) { clear(texture); }
+
+    ++version;
+}
+
+const RenderGraphStats& RenderGraph::GetStats() const noexcept { return stats; }
+
+uint64_t RenderGraph::GetVersion() const noexcept { return version; }
+
+bool RenderGraph::IsBufferActive(RenderPassId id_) const noexcept
+{
+    return id_ != RenderPassId::IMAGE && passes[static_cast<size_t>(id_)].is_active;
+}
+
+void RenderGraph::GetChannelResolutions(
+    RenderPassId id_,
+    glm::vec4 (&resolutions_)[RENDER_CHANNEL_COUNT]) const noexcept
+{
+    const auto& pass = passes[static_cast<size_t>(id_)];
+
+    for (size_t i = 0; i < RENDER_CHANNEL_COUNT; ++i)
+    {
+        resolutions_[i] = glm::vec4(0.0f);
+
+        if (GetChannelPass(pass.channels[i]) >= 0)
+        {
+            resolutions_[i] = glm::vec4(width, height, 1.0f, 0.0f);
+        }
+        else if (pass.channel_textures[i])
+        {
+            resolutions_[i] = glm::vec4(pass.channel_textures[i]->resolution, 0.0f);
+        }
+    }
+}
+
+void RenderGraph::Plan() noexcept
+{
+    ++stats.plans;
+    is_planned = true;
+
+    std::array<bool, RENDER_PASS_COUNT> was_static {};
+    for (size_t p = 0; p < RENDER_PASS_COUNT; ++p)
+    {
+        auto& pass    = passes[p];
+        was_static[p] = pass.is_active && !pass.is_dynamic;
+
+        pass.is_active   = false;
+        pass.is_dynamic  = false;
+        pass.has_history = false;
+    }
+
+    // Buffers are active if the image reads them, directly or through other buffers
+    passes[IMAGE_PASS].is_active = passes[IMAGE_PASS].program != nullptr;
+
+    for (bool is_changed = true; is_changed;)
+    {
+        is_changed = false;
+
+        for (const auto& pass : passes)
+        {
+            if (!pass.is_active) { continue; }
+
+            for (const auto& channel : pass.channels)
+            {
+                const int32_t input = GetChannelPass(channel);
+                if (input >= 0 && !passes[input].is_active)
+                {
+                    passes[input].is_active = true;
+                    is_changed              = true;
+                }
+            }
+        }
+    }
+
+    // Reading the pass itself or a later one means reading the previous frame
+    for (size_t p = 0; p < RENDER_PASS_COUNT; ++p)
+    {
+        if (!passes[p].is_active) { continue; }
+
+        for (const auto& channel : passes[p].channels)
+        {
+            const int32_t input = GetChannelPass(channel);
+            if (input >= static_cast<int32_t>(p)) { passes[input].has_history = true; }
+        }
+    }
+
+    // Last pass reading each buffer, the end of the lifetime of an in-frame buffer
+    std::array<size_t, RENDER_PASS_COUNT> last_reader {};
+
+    for (size_t p = 0; p < RENDER_PASS_COUNT; ++p)
+    {
+        auto& pass = passes[p];
+        if (!pass.is_active) { continue; }
+
+        pass.is_dynamic = pass.is_time_dependent || pass.has_history;
+
+        for (const auto& channel : pass.channels)
+        {
+            const int32_t input = GetChannelPass(channel);
+            if (input < 0) { continue; }
+
+            // A previous frame changes every frame, and a later input is not planned yet, so
+            // in a feedback loop such as A reading B and B reading A both passes stay dynamic
+            const bool is_history = input >= static_cast<int32_t>(p);
+
+            pass.is_dynamic    = pass.is_dynamic || is_history || passes[input].is_dynamic;
+            last_reader[input] = std::max(last_reader[input], p);
+        }
+
+        // Passes are reused only while the program and the inputs stay the same
+        pass.is_dirty = pass.is_dirty || pass.is_changed || !was_static[p];
+    }
+
+    std::vector<size_t> transient_free_after;  // Last reader of each shared texture
+
+    for (size_t p = 0; p < IMAGE_PASS; ++p)
+    {
+        auto& pass   = passes[p];
+        auto& owned  = pass.owned_textures;
+        pass.targets = {};
+
+        const bool is_owned = pass.is_active && (pass.has_history || !pass.is_dynamic);
+
+        if (!is_owned || !pass.has_history) { DeleteTexture(owned[1]); }
+        if (!is_owned) { DeleteTexture(owned[0]); }
+
+        if (!pass.is_active) { continue; }
+
+        if (is_owned)
+        {
+            for (size_t i = 0; i < (pass.has_history ? 2 : 1); ++i)
+            {
+                if (owned[i].texture) { continue; }
+
+                owned[i]      = CreateTexture();
+                pass.is_dirty = true;
+            }
+
+            pass.targets = owned;
+            pass.front   = pass.has_history ? pass.front : 0;
+            continue;
+        }
+
+        // The first shared texture whose last reader was drawn before this pass
+        size_t slot = 0;
+        while (slot < transient_free_after.size() && transient_free_after[slot] >= p) { ++slot; }
+
+        if (slot == transient_free_after.size())
+        {
+            transient_free_after.push_back(0);
+            if (slot == transient_textures.size())
+            {
+                transient_textures.push_back(CreateTexture());
+            }
+        }
+
+        transient_free_after[slot] = last_reader[p];
+        pass.targets[0]            = transient_textures[slot];
+        pass.front                 = 0;
+    }
+
+    while (transient_textures.size() > transient_free_after.size())
+    {
+        DeleteTexture(transient_textures.back());
+        transient_textures.pop_back();
+    }
+
+    stats.texture_count = static_cast<uint32_t>(transient_textures.size());
+    stats.culled_passes = 0;
+
+    for (auto& pass : passes)
+    {
+        for (const auto& texture : pass.owned_textures)
+        {
+            if (texture.texture) { ++stats.texture_count; }
+        }
+
+        if (pass.program && !pass.is_active) { ++stats.culled_passes; }
+
+        pass.is_changed = false;
+    }
+
+    stats.texture_bytes = static_cast<uint64_t>(stats.texture_count) * static_cast<uint64_t>(width)
+                        * static_cast<uint64_t>(height) * 16;  // 4 floats per pixel
+}
+
+bool RenderGraph::IsTimeDependent(const ShaderProgram& program_, std::string_view code_) noexcept
+{
+    for (const auto name : TIME_BUILTIN_NAMES)
+    {
+        if (program_.FindUniform(name)) { return true; }
+    }
+
+    if (glGetUniformBlockIndex(program_.GetID(), "GLSLLiveBuiltins") == GL_INVALID_INDEX)
+    {
+        return false;
+    }
+
+    // Builtins used only in included files are not seen, such passes are drawn every frame
+    bool is_time_dependent = false;
+    ForEachToken(code_,
+                 [&](std::string_view token)
+                 {
+                     is_time_dependent = token == "include"
+                                      || std::find(TIME_BUILTIN_NAMES.begin(),
+                                                   TIME_BUILTIN_NAMES.end(),
+                                                   token)
+                                             != TIME_BUILTIN_NAMES.end();
+                     return !is_time_dependent;
+                 });
+
+    return is_time_dependent;
+}
+
+void RenderGraph::DrawPass(size_t                    index_,
+                           const BuiltinUniformData& builtins_,
+                           const ScreenQuad&         screen_quad_,
+                           GLuint                    framebuffer_) noexcept
+{
+    auto& pass = passes[index_];
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width, height);
+
+    BuiltinUniformData pass_builtins = builtins_;
+    GetChannelResolutions(static_cast<RenderPassId>(index_), pass_builtins.channel_resolution);
+
+    pass.program->Use();
+    pass.builtin_handles.Apply(*pass.program, pass_builtins);
+
+    for (size_t i = 0; i < RENDER_CHANNEL_COUNT; ++i)
+    {
+        const int32_t input   = GetChannelPass(pass.channels[i]);
+        const GLuint  texture = input >= 0 ? passes[input].targets[passes[input].front].texture
+                                           : GetChannelTexture(pass, i);
+
+        glBindTextureUnit(static_cast<GLuint>(i), texture);
+        pass.program->SetUniform(pass.channel_handles[i], static_cast<int>(i));
+
+        pass.drawn_textures[i] = GetChannelTexture(pass, i);
+    }
+
+    screen_quad_.Draw();
+
+    pass.is_dirty       = false;
+    is_executed[index_] = true;
+    ++stats.executed_passes;
+}
+
+int32_t RenderGraph::GetChannelPass(const ChannelInput& channel_) const noexcept
+{
+    if (channel_.kind != ChannelInput::Kind::BUFFER) { return -1; }
+
+    const auto index = static_cast<int32_t>(channel_.buffer);
+    return passes[index].program ? index : -1;
+}
+
+GLuint RenderGraph::GetChannelTexture(const Pass& pass_, size_t channel_) noexcept
+{
+    const auto& texture = pass_.channel_textures[channel_];
+    return texture ? texture->texture : 0;
+}
+
+RenderGraph::GraphTexture RenderGraph::CreateTexture() const noexcept
+{
+    GraphTexture result;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &result.texture);
+    glTextureStorage2D(result.texture, 1, BUFFER_FORMAT, width, height);
+    glTextureParameteri(result.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(result.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(result.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(result.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Buffers start black, like on the first frame in ShaderToy
+    glClearTexImage(result.texture, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    glCreateFramebuffers(1, &result.framebuffer);
+    glNamedFramebufferTexture(result.framebuffer, GL_COLOR_ATTACHMENT0, result.texture, 0);
+
+    const GLenum status = glCheckNamedFramebufferStatus(result.framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR("Render graph framebuffer is incomplete: 0x{:X}", status);
+    }
+
+    return result;
+}
+
+void RenderGraph::DeleteTexture(GraphTexture& texture_) noexcept
+{
+    if (texture_.framebuffer) { glDeleteFramebuffers(1, &texture_.framebuffer); }
+    if (texture_.texture) { glDeleteTextures(1, &texture_.texture); }
+
+    texture_ = {};
+}
+
+void RenderGraph::DeleteTextures() noexcept
+{
+    for (auto& pass : passes)
+    {
+        for (auto& texture : pass.owned_textures) { DeleteTexture(texture); }
+
+        pass.targets  = {};
+        pass.front    = 0;
+        pass.is_dirty = true;
+    }
+
+    for (auto& texture : transient_textures) { DeleteTexture(texture); }
+    transient_textures.clear();
+}
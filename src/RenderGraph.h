@@ -0,0 +1,243 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "ScreenQuad.h"
+#include "ShaderProgram.h"
+#include "BuiltinUniforms.h"
+#include "TextureManager.h"
+
+/**
+ * @brief Passes of a ShaderToy-style multipass shader, executed in this order
+ */
+enum class RenderPassId : uint8_t {
+    BUFFER_A,
+    BUFFER_B,
+    BUFFER_C,
+    BUFFER_D,
+    IMAGE /**< Final pass, drawn into the target framebuffer */
+};
+
+constexpr size_t RENDER_PASS_COUNT    = 5;
+constexpr size_t BUFFER_PASS_COUNT    = 4;
+constexpr size_t RENDER_CHANNEL_COUNT = 4; /**< iChannel0 to iChannel3 */
+
+/**
+ * @brief Input bound to one iChannel of a pass
+ */
+struct ChannelInput {
+    enum class Kind {
+        NONE,    /**< Nothing is bound, the sampler reads black */
+        BUFFER,  /**< Output of a buffer pass */
+        TEXTURE, /**< Image file, read with a sampler2D */
+        CUBEMAP  /**< Six image files, read with a samplerCube */
+    };
+
+    Kind         kind   = Kind::NONE;
+    RenderPassId buffer = RenderPassId::BUFFER_A; /**< Only for BUFFER */
+    std::string  path;                            /**< Only for TEXTURE and CUBEMAP */
+
+    bool operator== (const ChannelInput&) const = default;
+};
+
+using ChannelBindings = std::array<ChannelInput, RENDER_CHANNEL_COUNT>;
+
+/**
+ * @brief Reads the channel bindings of a pass from its code
+ *
+ * @remark A binding is a line "#pragma iChannel0 BufferA", "#pragma iChannel1 "rock.png"" or
+ * "#pragma iChannel2 cube "sky.png"", the GLSL compilers ignore pragmas they do not know. Channels
+ * without a line are not bound.
+ */
+ChannelBindings ParseChannelBindings(std::string_view code_);
+
+/**
+ * @brief Work done by the render graph
+ */
+struct RenderGraphStats {
+    uint32_t executed_passes = 0; /**< Passes drawn in the last frame */
+    uint32_t skipped_passes  = 0; /**< Active passes reused from an earlier frame */
+    uint32_t culled_passes   = 0; /**< Enabled passes which the image does not read */
+    uint32_t texture_count   = 0; /**< Textures of the buffers, after aliasing */
+    uint64_t texture_bytes   = 0;
+    uint64_t plans           = 0; /**< Number of the times the passes were planned */
+};
+
+/**
+ * @brief Executes the buffer passes and the image pass of a multipass shader
+ *
+ * @remark Buffers are RGBA32F textures the size of the image. The passes are planned again only
+ * when a program, a binding or the size changes:
+ * - Buffers the image does not read, directly or through other buffers, are culled.
+ * - A buffer read by itself or by an earlier pass sees its previous frame, it gets two ping-pong
+ *   textures which keep their content across plans.
+ * - A pass which uses none of the time, frame or mouse builtins and reads no changing buffer is
+ *   static, it is drawn once and then reused until its program or its inputs change, including an
+ *   image file finishing its upload.
+ * - The other buffers only live within the frame, they share pooled textures when their lifetimes
+ *   from the writing pass to the last reading pass do not overlap.
+ */
+struct RenderGraph {
+    static constexpr GLenum BUFFER_FORMAT = GL_RGBA32F;
+
+    /**
+     * @param texture_manager_ Loads the image files bound to the channels
+     */
+    explicit RenderGraph(TextureManager& texture_manager_) noexcept;
+
+    RenderGraph(const RenderGraph&)             = delete;
+    RenderGraph& operator= (const RenderGraph&) = delete;
+
+    ~RenderGraph();
+
+    /**
+     * @brief Sets the program of the pass, cheap if nothing changed
+     *
+     * @param program_ Linked program or nullptr if the pass is disabled
+     * @param generation_ Number which changes whenever the program is replaced
+     * @param code_ Code of the program, the channel bindings are read from it on a new generation
+     */
+    void SetPass(RenderPassId     id_,
+                 ShaderProgram*   program_,
+                 uint64_t         generation_,
+                 std::string_view code_) noexcept;
+
+    /**
+     * @brief Sets the size of the buffers, they start from black again when it changes
+     */
+    void SetSize(int32_t width_, int32_t height_) noexcept;
+
+    /**
+     * @brief Draws the passes which are due and the image into the framebuffer
+     *
+     * @param builtins_ Builtins of the frame
+     * @param screen_quad_ Rectangle drawn by every pass
+     * @param framebuffer_ Target of the image pass, 0 for the window
+     */
+    void Execute(const BuiltinUniformData& builtins_,
+                 const ScreenQuad&         screen_quad_,
+                 GLuint                    framebuffer_) noexcept;
+
+    /**
+     * @brief Draws the buffer passes which are due, the first half of Execute()
+     */
+    void ExecuteBuffers(const BuiltinUniformData& builtins_,
+                        const ScreenQuad&         screen_quad_) noexcept;
+
+    /**
+     * @brief Draws the image pass from the current buffers, the second half of Execute()
+     *
+     * @param scissor_ Region to draw (x, y, width, height), nullptr for the whole image. Drawing an
+     * image in regions after one ExecuteBuffers() splits a heavy pass over several submissions.
+     */
+    void ExecuteImage(const BuiltinUniformData& builtins_,
+                      const ScreenQuad&         screen_quad_,
+                      GLuint                    framebuffer_,
+                      const glm::ivec4*         scissor_) noexcept;
+
+    /**
+     * @brief Clears the buffers, so feedback starts from black like on the first frame
+     */
+    void Reset() noexcept;
+
+    const RenderGraphStats& GetStats() const noexcept;
+
+    /**
+     * @brief Returns a number which changes whenever a program, a binding or the size changes, or
+     * the buffers are reset
+     */
+    uint64_t GetVersion() const noexcept;
+
+    /**
+     * @brief Returns true if the image pass reads the buffer
+     */
+    bool IsBufferActive(RenderPassId id_) const noexcept;
+
+    /**
+     * @brief Returns iChannelResolution of the pass, 0 for channels without an input or with an
+     * image which is still loading
+     */
+    void GetChannelResolutions(RenderPassId id_,
+                               glm::vec4 (&resolutions_)[RENDER_CHANNEL_COUNT]) const noexcept;
+
+private:
+
+    /**
+     * @brief Color texture with its framebuffer
+     */
+    struct GraphTexture {
+        GLuint texture     = 0;
+        GLuint framebuffer = 0;
+    };
+
+    struct Pass {
+        ShaderProgram*        program    = nullptr;
+        uint64_t              generation = 0;
+        ChannelBindings       channels;
+        BuiltinUniformHandles builtin_handles;
+        std::array<UniformHandle, RENDER_CHANNEL_COUNT> channel_handles;
+        std::array<std::shared_ptr<const ChannelTexture>, RENDER_CHANNEL_COUNT> channel_textures;
+        std::array<GLuint, RENDER_CHANNEL_COUNT> drawn_textures {}; /**< Files of the last draw */
+        bool is_time_dependent = false; /**< Flag indicating if a changing builtin is read */
+        bool is_changed        = true;  /**< Flag indicating if the program is new since the plan */
+
+        bool is_active   = false; /**< Flag indicating if the image reads the pass */
+        bool is_dynamic  = false; /**< Flag indicating if the pass is drawn every frame */
+        bool has_history = false; /**< Flag indicating if the previous frame is read */
+        bool is_dirty    = true;  /**< Flag indicating if a static pass must be drawn again */
+
+        std::array<GraphTexture, 2> owned_textures; /**< Kept across plans, static and history */
+        std::array<GraphTexture, 2> targets;        /**< Textures written and read this plan */
+        int32_t                     front = 0;      /**< Target holding the last written frame */
+    };
+
+    /**
+     * @brief Decides which passes run, which textures they use and which can be reused
+     */
+    void Plan() noexcept;
+
+    /**
+     * @brief Returns true if the program reads a builtin which changes from frame to frame
+     *
+     * @remark All members of the builtin block are active, so with the block the code is searched
+     * for the names instead
+     */
+    static bool IsTimeDependent(const ShaderProgram& program_, std::string_view code_) noexcept;
+
+    /**
+     * @brief Returns the index of the enabled buffer bound to the channel, -1 if none
+     */
+    int32_t GetChannelPass(const ChannelInput& channel_) const noexcept;
+
+    /**
+     * @brief Returns the uploaded file bound to the channel, 0 if none or while it is loading
+     */
+    static GLuint GetChannelTexture(const Pass& pass_, size_t channel_) noexcept;
+
+    /**
+     * @brief Draws the pass into the framebuffer with its channels bound
+     */
+    void DrawPass(size_t                    index_,
+                  const BuiltinUniformData& builtins_,
+                  const ScreenQuad&         screen_quad_,
+                  GLuint                    framebuffer_) noexcept;
+
+    GraphTexture CreateTexture() const noexcept;
+    static void  DeleteTexture(GraphTexture& texture_) noexcept;
+    void         DeleteTextures() noexcept;
+
+private:
+    TextureManager& texture_manager;
+
+    std::array<Pass, RENDER_PASS_COUNT> passes;
+    std::vector<GraphTexture>           transient_textures; /**< Shared by the in-frame buffers */
+
+    std::array<bool, RENDER_PASS_COUNT> is_executed {}; /**< Passes drawn in this frame */
+
+    int32_t  width      = 0;
+    int32_t  height     = 0;
+    bool     is_planned = false; /**< Flag indicating if the plan matches the passes */
+    uint64_t version    = 0;
+
+    RenderGraphStats stats;
+};
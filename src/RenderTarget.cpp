@@ -0,0 +1,66 @@
+#include "RenderTarget.h"
+
+RenderTarget::RenderTarget(int32_t width_, int32_t height_) noexcept :
+    width(width_),
+    height(height_)
+{
+    if (width <= 0 || height <= 0)
+    {
+        LOG_ERROR("Invalid render target size: {}x{}", width, height);
+        return;
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_RGBA8, width, height);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0);
+
+    const GLenum status = glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR("Render target framebuffer is incomplete: 0x{:X}", status);
+        return;
+    }
+
+    is_valid = true;
+}
+
+RenderTarget::~RenderTarget()
+{
+    if (framebuffer) { glDeleteFramebuffers(1, &framebuffer); }
+    if (texture) { glDeleteTextures(1, &texture); }
+}
+
+bool RenderTarget::IsValid() const noexcept { return is_valid; }
+
+void RenderTarget::Bind() const noexcept
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+GLuint RenderTarget::GetFramebuffer() const noexcept { return framebuffer; }
+
+GLuint RenderTarget::GetTexture() const noexcept { return texture; }
+
+int32_t RenderTarget::GetWidth() const noexcept { return width; }
+
+int32_t RenderTarget::GetHeight() const noexcept { return height; }
+
+void RenderTarget::ReadPixels(std::vector<uint8_t>& pixels_) const noexcept
+{
+    pixels_.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(texture,
+                      0,
+                      GL_RGBA,
+                      GL_UNSIGNED_BYTE,
+                      static_cast<GLsizei>(pixels_.size()),
+                      pixels_.data());
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Offscreen framebuffer with a single RGBA8 color texture
+ */
+struct RenderTarget {
+    /**
+     * @remark Must be created with a current GL context, check IsValid() for success
+     */
+    explicit RenderTarget(int32_t width_, int32_t height_) noexcept;
+
+    RenderTarget(const RenderTarget&)             = delete;
+    RenderTarget& operator= (const RenderTarget&) = delete;
+
+    ~RenderTarget();
+
+    bool IsValid() const noexcept;
+
+    /**
+     * @brief Binds the framebuffer for drawing and sets the viewport to its size
+     */
+    void Bind() const noexcept;
+
+    GLuint GetFramebuffer() const noexcept;
+    GLuint GetTexture() const noexcept;
+
+    int32_t GetWidth() const noexcept;
+    int32_t GetHeight() const noexcept;
+
+    /**
+     * @brief Reads the color texture back as tightly packed RGBA8 rows, bottom row first
+     *
+     * @param pixels_ Storage for the pixels, resized to width * height * 4
+     *
+     * @remark Blocks until the GPU finished drawing into the target
+     */
+    void ReadPixels(std::vector<uint8_t>& pixels_) const noexcept;
+
+private:
+    GLuint  framebuffer = 0; /**< Framebuffer object */
+    GLuint  texture     = 0; /**< Color attachment */
+    int32_t width;           /**< Width in pixels */
+    int32_t height;          /**< Height in pixels */
+    bool    is_valid    = false;
+};
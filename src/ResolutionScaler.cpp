@@ -0,0 +1,190 @@
+#include "ResolutionScaler.h"
+
+namespace {
+
+constexpr float SLOW_THRESHOLD = 1.05f; /**< Above target * this the scale goes down */
+constexpr float FAST_THRESHOLD = 0.7f;  /**< Below target * this the scale goes up */
+
+int32_t GetScaledSize(int32_t size_, float scale_, int32_t max_size_)
+{
+    const auto scaled = static_cast<int32_t>(std::lround(static_cast<float>(size_) * scale_));
+    return std::clamp(scaled, 1, std::max(max_size_, 1));
+}
+
+}  // namespace
+
+ResolutionScaler::ResolutionScaler() noexcept
+{
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    glCreateQueries(GL_TIME_ELAPSED, static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+ResolutionScaler::~ResolutionScaler()
+{
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+void ResolutionScaler::SetMode(ResolutionScaleMode mode_) noexcept
+{
+    if (mode == mode_) { return; }
+
+    mode = mode_;
+
+    // Adaptive starts from the set scale and goes down only if the shader is too slow
+    current_scale = scale;
+    sample_sum_ms = 0.0f;
+    sample_count  = 0;
+}
+
+ResolutionScaleMode ResolutionScaler::GetMode() const noexcept { return mode; }
+
+void ResolutionScaler::SetScale(float scale_) noexcept
+{
+    scale = std::clamp(scale_, MIN_SCALE, MAX_SCALE);
+
+    current_scale = mode == ResolutionScaleMode::FIXED ? scale : std::min(current_scale, scale);
+    sample_sum_ms = 0.0f;
+    sample_count  = 0;
+}
+
+float ResolutionScaler::GetScale() const noexcept { return scale; }
+
+float ResolutionScaler::GetCurrentScale() const noexcept { return current_scale; }
+
+void ResolutionScaler::SetTargetFrameMs(float target_frame_ms_) noexcept
+{
+    target_frame_ms = std::max(target_frame_ms_, 0.1f);
+}
+
+float ResolutionScaler::GetTargetFrameMs() const noexcept { return target_frame_ms; }
+
+GLuint ResolutionScaler::Begin(int32_t output_width_,
+                               int32_t output_height_,
+                               GLuint  output_framebuffer_) noexcept
+{
+    CollectQueries();
+
+    output_width       = output_width_;
+    output_height      = output_height_;
+    output_framebuffer = output_framebuffer_;
+    render_width       = GetScaledSize(output_width, current_scale, max_size);
+    render_height      = GetScaledSize(output_height, current_scale, max_size);
+
+    if (!target || target->GetWidth() != render_width || target->GetHeight() != render_height)
+    {
+        target         = std::make_unique<RenderTarget>(render_width, render_height);
+        is_frame_drawn = false;
+
+        // Drawn at the output size rather than not at all
+        if (!target->IsValid())
+        {
+            target.reset();
+            render_width  = output_width;
+            render_height = output_height;
+        }
+    }
+
+    // A query whose result was not read yet is skipped, its frame is not measured
+    if (!is_query_pending[query_index])
+    {
+        glBeginQuery(GL_TIME_ELAPSED, queries[query_index]);
+        is_timing = true;
+    }
+
+    return target ? target->GetFramebuffer() : output_framebuffer;
+}
+
+void ResolutionScaler::End() noexcept
+{
+    if (is_timing)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        is_query_pending[query_index] = true;
+        is_timing                     = false;
+    }
+
+    query_index = (query_index + 1) % QUERY_COUNT;
+
+    is_frame_drawn = target != nullptr;
+
+    if (target)
+    {
+        present_pass.Draw(target->GetTexture(), output_framebuffer, output_width, output_height);
+    }
+    else
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer);
+        glViewport(0, 0, output_width, output_height);
+    }
+}
+
+bool ResolutionScaler::PresentLastFrame(int32_t output_width_,
+                                        int32_t output_height_,
+                                        GLuint  output_framebuffer_) noexcept
+{
+    if (!target || !is_frame_drawn) { return false; }
+
+    present_pass.Draw(target->GetTexture(), output_framebuffer_, output_width_, output_height_);
+    return true;
+}
+
+int32_t ResolutionScaler::GetRenderWidth() const noexcept { return render_width; }
+
+int32_t ResolutionScaler::GetRenderHeight() const noexcept { return render_height; }
+
+float ResolutionScaler::GetGpuMs() const noexcept { return gpu_ms; }
+
+uint64_t ResolutionScaler::GetScaleChangeCount() const noexcept { return scale_change_count; }
+
+void ResolutionScaler::CollectQueries() noexcept
+{
+    for (size_t i = 0; i < QUERY_COUNT; ++i)
+    {
+        if (!is_query_pending[i]) { continue; }
+
+        GLint is_available = 0;
+        glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &is_available);
+        if (!is_available) { continue; }
+
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed_ns);
+        is_query_pending[i] = false;
+
+        sample_sum_ms += static_cast<float>(static_cast<double>(elapsed_ns) / 1'000'000.0);
+        ++sample_count;
+    }
+
+    if (sample_count < ADJUST_INTERVAL) { return; }
+
+    gpu_ms        = sample_sum_ms / static_cast<float>(sample_count);
+    sample_sum_ms = 0.0f;
+    sample_count  = 0;
+
+    if (mode == ResolutionScaleMode::ADAPTIVE) { Adapt(gpu_ms); }
+}
+
+void ResolutionScaler::Adapt(float average_ms_) noexcept
+{
+    // The cost follows the pixel count, the square of the scale
+    const float desired = current_scale * std::sqrt(target_frame_ms / std::max(average_ms_, 0.01f));
+    const float stepped = std::floor(desired / SCALE_STEP) * SCALE_STEP;
+
+    float next = current_scale;
+    if (average_ms_ > target_frame_ms * SLOW_THRESHOLD) { next = stepped; }
+    else if (average_ms_ < target_frame_ms * FAST_THRESHOLD)
+    {
+        next = std::min(stepped, current_scale + SCALE_STEP);  // Up slowly, a resize is visible
+    }
+
+    next = std::clamp(next, MIN_SCALE, scale);
+    if (next == current_scale) { return; }
+
+    LOG_DEBUG("Resolution scale {:.3f} -> {:.3f} ({:.2f} ms of {:.2f} ms)",
+              current_scale,
+              next,
+              average_ms_,
+              target_frame_ms);
+
+    current_scale = next;
+    ++scale_change_count;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "RenderTarget.h"
+#include "PresentPass.h"
+
+enum class ResolutionScaleMode : uint8_t {
+    FIXED,   /**< The shader is drawn at the set scale */
+    ADAPTIVE /**< The scale follows the GPU time, up to the set scale */
+};
+
+/**
+ * @brief Draws the shader at a fraction or a multiple of the output resolution
+ *
+ * @remark The shader is always drawn into an offscreen target, which is presented with a
+ * bilinear PresentPass: below 1 the target is smaller and stretched, above 1 it is supersampled
+ * and filtered down. The target keeps the last frame, so a paused scene is presented again
+ * without running the shader. The GPU time of the passes is measured with timer queries which
+ * are read only once available, so measuring never stalls. In adaptive mode the scale moves in
+ * SCALE_STEP steps at most once per ADJUST_INTERVAL frames, because a new size restarts the
+ * feedback buffers of the render graph.
+ */
+struct ResolutionScaler {
+    static constexpr float    MIN_SCALE       = 0.25f;
+    static constexpr float    MAX_SCALE       = 2.0f;
+    static constexpr float    SCALE_STEP      = 0.125f; /**< Granularity of the adaptive scale */
+    static constexpr uint32_t ADJUST_INTERVAL = 30;     /**< Measured frames per adaptive step */
+    static constexpr size_t   QUERY_COUNT     = 4;      /**< Timer queries in flight */
+
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit ResolutionScaler() noexcept;
+
+    ResolutionScaler(const ResolutionScaler&)             = delete;
+    ResolutionScaler& operator= (const ResolutionScaler&) = delete;
+
+    ~ResolutionScaler();
+
+    void                SetMode(ResolutionScaleMode mode_) noexcept;
+    ResolutionScaleMode GetMode() const noexcept;
+
+    /**
+     * @brief Sets the scale of the fixed mode, which is also the highest scale of the adaptive mode
+     */
+    void  SetScale(float scale_) noexcept;
+    float GetScale() const noexcept;
+
+    /**
+     * @brief Returns the scale the frames are drawn at right now
+     */
+    float GetCurrentScale() const noexcept;
+
+    /**
+     * @brief Sets the GPU time of the passes the adaptive mode aims for
+     */
+    void  SetTargetFrameMs(float target_frame_ms_) noexcept;
+    float GetTargetFrameMs() const noexcept;
+
+    /**
+     * @brief Starts a frame of the output size and the timer of its passes
+     *
+     * @param output_framebuffer_ Framebuffer which receives the frame, 0 for the window
+     *
+     * @return Framebuffer to draw the passes into, GetRenderWidth() x GetRenderHeight() pixels
+     */
+    GLuint Begin(int32_t output_width_,
+                 int32_t output_height_,
+                 GLuint  output_framebuffer_) noexcept;
+
+    /**
+     * @brief Stops the timer and scales the frame into the output framebuffer, which is left bound
+     */
+    void End() noexcept;
+
+    /**
+     * @brief Scales the last frame into the output framebuffer again, no pass is drawn
+     *
+     * @return true if a frame was presented, false if none was drawn yet
+     */
+    bool PresentLastFrame(int32_t output_width_,
+                          int32_t output_height_,
+                          GLuint  output_framebuffer_) noexcept;
+
+    int32_t GetRenderWidth() const noexcept;
+    int32_t GetRenderHeight() const noexcept;
+
+    /**
+     * @brief Returns the average GPU time of the passes over the last adjust interval
+     */
+    float GetGpuMs() const noexcept;
+
+    /**
+     * @brief Returns how often the adaptive mode changed the scale
+     */
+    uint64_t GetScaleChangeCount() const noexcept;
+
+private:
+
+    /**
+     * @brief Reads the timer queries which are ready and adapts the scale
+     */
+    void CollectQueries() noexcept;
+
+    void Adapt(float average_ms_) noexcept;
+
+private:
+    ResolutionScaleMode mode            = ResolutionScaleMode::FIXED;
+    float               scale           = 1.0f;
+    float               current_scale   = 1.0f;
+    float               target_frame_ms = 12.0f; /**< Leaves the UI room within a 60 Hz frame */
+
+    int32_t max_size           = 0; /**< GL_MAX_TEXTURE_SIZE, limits the supersampling */
+    int32_t output_width       = 0;
+    int32_t output_height      = 0;
+    int32_t render_width       = 0;
+    int32_t render_height      = 0;
+    GLuint  output_framebuffer = 0;
+
+    std::unique_ptr<RenderTarget> target; /**< Offscreen frame, kept after End() */
+    PresentPass                   present_pass;
+    bool                          is_frame_drawn = false; /**< The target holds a whole frame */
+
+    std::array<GLuint, QUERY_COUNT> queries {};
+    std::array<bool, QUERY_COUNT>   is_query_pending {};
+    size_t                          query_index = 0; /**< Query of the current frame */
+    bool                            is_timing   = false;
+
+    float    gpu_ms             = 0.0f;
+    float    sample_sum_ms      = 0.0f; /**< Sum of the samples of the current interval */
+    uint32_t sample_count       = 0;
+    uint64_t scale_change_count = 0;
+};
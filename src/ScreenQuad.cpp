@@ -0,0 +1,52 @@
+#include "ScreenQuad.h"
+
+ScreenQuad::ScreenQuad() noexcept
+{
+    // Define rectangle vertices
+    float vertices[] = {
+        1.f,  1.f,  0.0f,  // Top right
+        1.f,  -1.f, 0.0f,  // Bottom right
+        -1.f, -1.f, 0.0f,  // Bottom left
+        -1.f, 1.f,  0.0f   // Top left
+    };
+    unsigned int indices[] = {
+        0, 1, 3,  // First triangle
+        1, 2, 3   // Second triangle
+    };
+
+    // Generate buffers and arrays
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    // Bind the Vertex Array Object
+    glBindVertexArray(VAO);
+
+    // Bind and set vertex buffer(s)
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // Configure vertex attributes
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Unbind the VAO
+    glBindVertexArray(0);
+}
+
+ScreenQuad::~ScreenQuad()
+{
+    // Clean up
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+void ScreenQuad::Draw() const noexcept
+{
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Rectangle which covers the whole viewport, the fragment shader is run over it
+ */
+struct ScreenQuad {
+    /**
+     * @remark Must be created with a current GL context
+     */
+    explicit ScreenQuad() noexcept;
+
+    ScreenQuad(const ScreenQuad&)             = delete;
+    ScreenQuad& operator= (const ScreenQuad&) = delete;
+
+    ~ScreenQuad();
+
+    /**
+     * @brief Draws the rectangle with the program in use
+     */
+    void Draw() const noexcept;
+
+private:
+    GLuint VAO = 0; /**< Vertex array object */
+    GLuint VBO = 0; /**< Vertex buffer */
+    GLuint EBO = 0; /**< Element buffer */
+};
@@ -1,6 +1,12 @@
 #include "Shader.h"
 
-Shader::Shader() noexcept : id(0), is_good(false)
+#include "Utils.h"
+
+Shader::Shader() noexcept :
+    id(0),
+    is_good(false),
+    compiled_type(ShaderType::COUNT),
+    compiled_hash(0)
 {
     compilation_error.reserve(1024);
     code.reserve(1024 * 10);
@@ -11,13 +17,24 @@ Shader::~Shader() { DeleteShader(); }
 bool Shader::CompileFromText(std::string_view text_, ShaderType type_) noexcept
 {
     code = text_;
-    Compile(type_);
+    Compile(code, type_);
     return is_good;
 }
 
 bool Shader::CompileFromCurrentCode(ShaderType type_) noexcept
 {
-    Compile(type_);
+    return CompileFromSource(code, type_);
+}
+
+bool Shader::CompileFromSource(std::string_view source_, ShaderType type_) noexcept
+{
+    // Nothing changed since the last compilation, so the result would be the same
+    if (compiled_type == type_ && compiled_hash == HashText(source_) && (id != 0 || !is_good))
+    {
+        return is_good;
+    }
+
+    Compile(source_, type_);
     return is_good;
 }
 
@@ -40,7 +57,29 @@ std::string_view Shader::GetCompilationError() const noexcept { return compilati
 
 bool Shader::IsGood() const noexcept { return is_good; }
 
-void Shader::Compile(ShaderType type_) noexcept
+uint64_t Shader::GetCodeHash() const noexcept { return HashText(code); }
+
+uint64_t Shader::GetCompiledHash() const noexcept { return compiled_hash; }
+
+void Shader::SetCompilationResult(ShaderType       type_,
+                                  uint64_t         code_hash_,
+                                  bool             is_good_,
+                                  std::string_view compilation_error_) noexcept
+{
+    DeleteShader();
+
+    is_good           = is_good_;
+    compilation_error = compilation_error_;
+    compiled_type     = type_;
+    compiled_hash     = code_hash_;
+}
+
+void Shader::SetLineMap(std::shared_ptr<const SourceLineMap> line_map_) noexcept
+{
+    line_map = std::move(line_map_);
+}
+
+void Shader::Compile(std::string_view source_, ShaderType type_) noexcept
 {
     // If the shader is already compiled and existed, delete it
     if (id != 0) { DeleteShader(); }
@@ -61,11 +100,14 @@ void Shader::Compile(ShaderType type_) noexcept
             is_good = false;
     }
 
-    const char* shader_code_cstr = code.c_str();
-    glShaderSource(id, 1, &shader_code_cstr, nullptr);
+    const char* shader_code = source_.data();
+    const GLint code_length = static_cast<GLint>(source_.size());
+    glShaderSource(id, 1, &shader_code, &code_length);
     glCompileShader(id);
 
-    is_good = CheckCompileErrors(id, type_);
+    is_good       = CheckCompileErrors(id, type_);
+    compiled_type = type_;
+    compiled_hash = HashText(source_);
 }
 
 bool Shader::CheckCompileErrors(GLuint shader, ShaderType type_) noexcept
@@ -78,9 +120,88 @@ bool Shader::CheckCompileErrors(GLuint shader, ShaderType type_) noexcept
     {
         char error_info[1024];
         glGetShaderInfoLog(shader, 1024, NULL, error_info);
-        compilation_error = error_info;
+        compilation_error = line_map ? line_map->Remap(error_info) : std::string(error_info);
         // LOG_WARN("Shader compilation error: {}", compilation_error);
         return false;
     }
     return true;
 }
+
+int32_t GetSupportedGLSLVersion() noexcept
+{
+    // Formatted as "<major>.<minor><digit> <vendor specific>", e.g. "4.50"
+    const auto* version = reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION));
+    if (!version) { return 0; }
+
+    int32_t major = 0;
+    int32_t minor = 0;
+    if (std::sscanf(version, "%d.%d", &major, &minor) != 2) { return 0; }
+
+    return major * 100 + (minor < 10 ? minor * 10 : minor);
+}
+
+namespace {
+
+/**
+ * @brief Finds the number of the first #version directive
+ *
+ * @return false if the code has no #version with a number
+ */
+bool FindGLSLVersion(std::string_view code_, size_t& number_start_, size_t& number_end_)
+{
+    for (size_t start = 0; start < code_.size();)
+    {
+        const size_t end = std::min(code_.find('\n', start), code_.size());
+
+        const size_t hash = code_.find_first_not_of(" \t", start);
+        if (hash < end && code_[hash] == '#')
+        {
+            const size_t directive = code_.find_first_not_of(" \t", hash + 1);
+            if (directive < end && code_.compare(directive, 7, "version") == 0)
+            {
+                number_start_ = std::min(code_.find_first_not_of(" \t", directive + 7), end);
+                number_end_   = number_start_;
+                while (number_end_ < end
+                       && std::isdigit(static_cast<unsigned char>(code_[number_end_])))
+                {
+                    ++number_end_;
+                }
+
+                return number_end_ > number_start_;  // Only the first #version counts
+            }
+        }
+
+        start = end + 1;
+    }
+
+    return false;
+}
+
+}  // namespace
+
+int32_t GetGLSLVersion(std::string_view code_)
+{
+    size_t number_start = 0;
+    size_t number_end   = 0;
+    if (!FindGLSLVersion(code_, number_start, number_end)) { return 0; }
+
+    return std::atoi(std::string(code_.substr(number_start, number_end - number_start)).c_str());
+}
+
+std::string LimitGLSLVersion(std::string_view code_, int32_t max_version_)
+{
+    std::string result(code_);
+
+    if (max_version_ <= 0) { return result; }  // Unknown, leave the code as written
+
+    size_t number_start = 0;
+    size_t number_end   = 0;
+    if (FindGLSLVersion(result, number_start, number_end)
+        && std::atoi(result.substr(number_start, number_end - number_start).c_str())
+               > max_version_)
+    {
+        result.replace(number_start, number_end - number_start, std::to_string(max_version_));
+    }
+
+    return result;
+}
@@ -2,6 +2,8 @@
 
 #include "PCH.h"
 
+#include "ShaderPreprocessor.h"
+
 enum class ShaderType {
     VERTEX,   /**< Vertex shader */
     FRAGMENT, /**< Fragment shader */
@@ -17,6 +19,14 @@ struct Shader {
     bool CompileFromText(const std::string_view text_, ShaderType type_) noexcept;
     bool CompileFromCurrentCode(ShaderType type_) noexcept;
 
+    /**
+     * @brief Compiles the source derived from the code (e.g. with an injected preamble), the code
+     * itself stays untouched
+     *
+     * @remark Nothing is compiled if the same source was compiled last time
+     */
+    bool CompileFromSource(std::string_view source_, ShaderType type_) noexcept;
+
     GLuint GetID() const noexcept;
 
     std::string_view GetCodeConst() const noexcept;
@@ -28,9 +38,39 @@ struct Shader {
 
     bool IsGood() const noexcept;
 
+    /**
+     * @brief Returns the hash of the current shader code
+     */
+    uint64_t GetCodeHash() const noexcept;
+
+    /**
+     * @brief Returns the hash of the source which was used for the last compilation
+     */
+    uint64_t GetCompiledHash() const noexcept;
+
+    /**
+     * @brief Stores the result of a compilation which was done elsewhere (e.g. by a background
+     * worker) for the code with the given hash
+     *
+     * @remark The local shader object is deleted, so the next CompileFromCurrentCode() of the
+     * good code compiles it again
+     */
+    void SetCompilationResult(ShaderType       type_,
+                              uint64_t         code_hash_,
+                              bool             is_good_,
+                              std::string_view compilation_error_) noexcept;
+
+    /**
+     * @brief Sets the origins of the source lines, so the compilation errors point at the files
+     * and lines before preprocessing
+     *
+     * @param line_map_ Line map of the next compiled source or nullptr to report the lines as is
+     */
+    void SetLineMap(std::shared_ptr<const SourceLineMap> line_map_) noexcept;
+
 protected:
 
-    void Compile(ShaderType type_) noexcept;
+    void Compile(std::string_view source_, ShaderType type_) noexcept;
 
     bool CheckCompileErrors(GLuint shader, ShaderType type_) noexcept;
 
@@ -39,4 +79,33 @@ protected:
     std::string compilation_error; /**< Compilation error message */
     GLuint      id;                /**< Shader ID */
     bool        is_good;           /**< Flag indicating if the shader is compiled */
+    ShaderType  compiled_type;     /**< Type used for the last compilation */
+    uint64_t    compiled_hash;     /**< Hash of the source used for the last compilation */
+
+    std::shared_ptr<const SourceLineMap> line_map; /**< Origins of the compiled source lines */
 };
+
+/**
+ * @brief Returns the highest GLSL version of the current context (e.g. 450 on Mesa llvmpipe)
+ *
+ * @remark Must be called with a current GL context
+ */
+int32_t GetSupportedGLSLVersion() noexcept;
+
+/**
+ * @brief Returns the number of the first #version directive of the code, 0 if it has none
+ */
+int32_t GetGLSLVersion(std::string_view code_);
+
+/**
+ * @brief Lowers the #version of the code to the given version if it asks for a newer one, so
+ * shaders written for 4.60 also run on 4.50 contexts (e.g. software rasterizers on CI machines)
+ *
+ * @remark Code asking for a version the context supports is returned unchanged
+ *
+ * @param code_ Shader code
+ * @param max_version_ Highest version supported by the context
+ *
+ * @return Code with the lowered version, the line count stays the same
+ */
+std::string LimitGLSLVersion(std::string_view code_, int32_t max_version_);
@@ -0,0 +1,98 @@
+#include "ShaderFileWatcher.h"
+#include "Utils.h"
+
+ShaderFileWatcher::ShaderFileWatcher() noexcept :
+    application_path(GetApplicationPath()),
+    watcher([this](const std::vector<std::string>& changed_paths_) { OnChanges(changed_paths_); },
+            COALESCE_DELAY)
+{
+}
+
+void ShaderFileWatcher::SetFiles(const std::vector<std::string>& file_paths_) noexcept
+{
+    std::unordered_map<std::string, std::string> new_files;
+    std::set<std::string>                        new_directories;
+
+    for (const auto& file_path : file_paths_)
+    {
+        auto full_path = GetFullPath(file_path);
+        new_directories.insert(std::filesystem::path(full_path).parent_path().generic_string());
+        new_files.emplace(std::move(full_path), file_path);
+    }
+
+    std::vector<std::string> added_directories;
+    std::vector<std::string> removed_directories;
+    {
+        std::lock_guard lock(mutex);
+
+        std::set_difference(new_directories.begin(),
+                            new_directories.end(),
+                            directories.begin(),
+                            directories.end(),
+                            std::back_inserter(added_directories));
+        std::set_difference(directories.begin(),
+                            directories.end(),
+                            new_directories.begin(),
+                            new_directories.end(),
+                            std::back_inserter(removed_directories));
+
+        files       = std::move(new_files);
+        directories = std::move(new_directories);
+    }
+
+    // Outside of the lock, the watcher thread may wait for it in OnChanges()
+    for (const auto& directory : removed_directories) { watcher.Unwatch(directory); }
+    for (const auto& directory : added_directories) { watcher.Watch(directory); }
+}
+
+std::vector<ShaderFileChange> ShaderFileWatcher::TakeChanges() noexcept
+{
+    std::vector<ShaderFileChange> result;
+
+    if (!has_changes.load(std::memory_order_acquire)) { return result; }
+
+    std::lock_guard lock(mutex);
+    result.swap(changes);
+    has_changes.store(false, std::memory_order_relaxed);
+
+    return result;
+}
+
+void ShaderFileWatcher::OnChanges(const std::vector<std::string>& changed_paths_) noexcept
+{
+    const auto detect_time = std::chrono::system_clock::now();
+
+    std::lock_guard lock(mutex);
+
+    const auto add_change = [&](const std::string& file_path)
+    {
+        const bool is_known = std::any_of(changes.begin(),
+                                          changes.end(),
+                                          [&](const auto& change)
+                                          {
+                                              return change.path == file_path;
+                                          });
+        if (!is_known) { changes.push_back({ file_path, detect_time }); }
+    };
+
+    if (changed_paths_.empty())  // Events were lost, any of the files may have changed
+    {
+        for (const auto& [full_path, file_path] : files) { add_change(file_path); }
+    }
+
+    for (const auto& changed_path : changed_paths_)
+    {
+        const auto path = std::filesystem::path(changed_path).lexically_normal().generic_string();
+
+        auto it = files.find(path);
+        if (it != files.end()) { add_change(it->second); }
+    }
+
+    has_changes.store(!changes.empty(), std::memory_order_release);
+}
+
+std::string ShaderFileWatcher::GetFullPath(std::string_view file_path_) const
+{
+    const auto full_path = std::filesystem::path(application_path) / file_path_;
+    return full_path.lexically_normal().generic_string();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "DirectoryWatcher.h"
+
+/**
+ * @brief Change of a watched shader file
+ */
+struct ShaderFileChange {
+    std::string                           path;        /**< Path relative to the application */
+    std::chrono::system_clock::time_point detect_time; /**< Time the watcher reported it */
+};
+
+/**
+ * @brief Watches the shader files used by the program, so edits made in an external editor can be
+ * reloaded
+ *
+ * @remark The directories of the files are watched, editors often save by writing a new file and
+ * renaming it over the old one, which a watch on the file itself would lose. Bursts of writes are
+ * coalesced into one change.
+ */
+struct ShaderFileWatcher {
+    static constexpr std::chrono::milliseconds COALESCE_DELAY { 15 };
+
+    explicit ShaderFileWatcher() noexcept;
+
+    ShaderFileWatcher(const ShaderFileWatcher&)             = delete;
+    ShaderFileWatcher& operator= (const ShaderFileWatcher&) = delete;
+
+    /**
+     * @brief Replaces the set of the watched files
+     *
+     * @param file_paths_ Paths relative to the application directory
+     */
+    void SetFiles(const std::vector<std::string>& file_paths_) noexcept;
+
+    /**
+     * @brief Takes the changes reported since the last call, never blocks
+     *
+     * @remark Cheap when nothing changed, meant to be called every frame
+     */
+    std::vector<ShaderFileChange> TakeChanges() noexcept;
+
+private:
+
+    /**
+     * @brief Records the changes of the watched files, called on the watcher thread
+     */
+    void OnChanges(const std::vector<std::string>& changed_paths_) noexcept;
+
+    /**
+     * @brief Returns the full, normalized path used to match the watcher reports
+     */
+    std::string GetFullPath(std::string_view file_path_) const;
+
+private:
+    std::string application_path;
+
+    std::mutex                                   mutex;
+    std::unordered_map<std::string, std::string> files;       /**< Full path to relative path */
+    std::set<std::string>                        directories; /**< Watched directories */
+    std::vector<ShaderFileChange>                changes;     /**< Changes not taken yet */
+    std::atomic<bool>                            has_changes = false;
+
+    DirectoryWatcher watcher; /**< Declared last, stops calling back before the files go away */
+};
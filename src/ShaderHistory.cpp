@@ -0,0 +1,449 @@
+#include "ShaderHistory.h"
+
+namespace {
+
+constexpr uint32_t PACK_MAGIC    = 0x50484C47;  // "GLHP"
+constexpr uint32_t PACK_VERSION  = 1;
+constexpr uint32_t RECORD_MAGIC  = 0x52484C47;  // "GLHR"
+constexpr uint32_t RECORD_FULL   = 0;
+constexpr uint32_t RECORD_DELTA  = 1;
+constexpr uint8_t  DELTA_COPY    = 0;  // Followed by the base offset and the length
+constexpr uint8_t  DELTA_INSERT  = 1;  // Followed by the length and the text
+constexpr size_t   MIN_COPY_LINE = 4;  // Shorter lines are cheaper to insert than to copy
+
+/**
+ * @brief Header at the start of the pack file
+ */
+struct PackHeader {
+    uint32_t magic   = PACK_MAGIC;
+    uint32_t version = PACK_VERSION;
+};
+
+/**
+ * @brief Header written in front of every revision
+ */
+struct RecordHeader {
+    uint32_t magic        = RECORD_MAGIC;
+    uint32_t kind         = RECORD_FULL; /**< RECORD_FULL or RECORD_DELTA */
+    int64_t  time_ms      = 0;           /**< Milliseconds since the Unix epoch */
+    uint64_t text_hash    = 0;           /**< Hash of the full text of the revision */
+    uint32_t text_size    = 0;           /**< Size of the full text of the revision */
+    uint32_t payload_size = 0;           /**< Size of the text or delta following the header */
+    uint64_t checksum     = 0;           /**< Hash of the payload, detects corrupt records */
+};
+
+void WriteVarint(std::string& out_, uint64_t value_)
+{
+    while (value_ >= 0x80)
+    {
+        out_.push_back(static_cast<char>((value_ & 0x7F) | 0x80));
+        value_ >>= 7;
+    }
+    out_.push_back(static_cast<char>(value_));
+}
+
+bool ReadVarint(std::string_view data_, size_t& position_, uint64_t& value_)
+{
+    value_ = 0;
+    for (uint32_t shift = 0; position_ < data_.size() && shift < 64; shift += 7)
+    {
+        const auto byte = static_cast<uint8_t>(data_[position_++]);
+        value_         |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) { return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the length of the line starting at the offset, including its line break
+ */
+size_t GetLineLength(std::string_view text_, size_t start_)
+{
+    const size_t line_break = text_.find('\n', start_);
+    return (line_break == std::string_view::npos ? text_.size() : line_break + 1) - start_;
+}
+
+}  // namespace
+
+ShaderHistory::ShaderHistory(std::string_view pack_path_) noexcept :
+    pack_path(pack_path_),
+    full_pack_path(GetApplicationPath() + "/" + pack_path),
+    is_writable(!pack_path.empty())
+{
+    if (is_writable) { Index(); }
+}
+
+bool ShaderHistory::Append(std::string_view text_) noexcept
+{
+    if (!is_writable) { return false; }
+
+    const uint64_t text_hash = HashText(text_);
+    if (!revisions.empty() && revisions.back().text_hash == text_hash) { return false; }
+
+    // Deltas since the last keyframe, the chain a reader has to apply
+    size_t chain_length = 0;
+    while (chain_length < revisions.size()
+           && !revisions[revisions.size() - 1 - chain_length].is_keyframe)
+    {
+        ++chain_length;
+    }
+
+    bool        is_keyframe = revisions.empty() || chain_length + 1 >= KEYFRAME_INTERVAL;
+    std::string payload;
+
+    if (!is_keyframe)
+    {
+        payload     = EncodeDelta(newest_text, text_);
+        is_keyframe = payload.size() >= text_.size();
+    }
+
+    if (is_keyframe) { payload.assign(text_); }
+
+    RecordHeader header;
+    header.kind         = is_keyframe ? RECORD_FULL : RECORD_DELTA;
+    header.time_ms      = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+    header.text_hash    = text_hash;
+    header.text_size    = static_cast<uint32_t>(text_.size());
+    header.payload_size = static_cast<uint32_t>(payload.size());
+    header.checksum     = HashText(payload);
+
+    {
+        std::ofstream out_file(full_pack_path, std::ios::out | std::ios::binary | std::ios::app);
+        out_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        out_file.flush();
+
+        if (!out_file.good())
+        {
+            LOG_ERROR("Failed to append to the shader history: {}", full_pack_path);
+
+            out_file.close();
+            pack_view.reset();  // A mapped file can not be truncated on every platform
+
+            std::error_code error;
+            std::filesystem::resize_file(full_pack_path, pack_size, error);
+            return false;
+        }
+    }
+
+    ShaderRevision revision;
+    revision.time_ms     = header.time_ms;
+    revision.text_hash   = header.text_hash;
+    revision.text_size   = header.text_size;
+    revision.stored_size = static_cast<uint32_t>(sizeof(header) + payload.size());
+    revision.is_keyframe = is_keyframe;
+    revision.offset      = pack_size;
+
+    pack_size += revision.stored_size;
+    revisions.push_back(revision);
+    newest_text.assign(text_);
+
+    return true;
+}
+
+const std::vector<ShaderRevision>& ShaderHistory::GetRevisions() const noexcept
+{
+    return revisions;
+}
+
+std::string ShaderHistory::GetText(size_t index_) noexcept
+{
+    if (index_ >= revisions.size()) { return ""; }
+    if (index_ == cached_index) { return cached_text; }
+
+    // Starts from the keyframe, or from the cached revision if it is on the way
+    size_t start = index_;
+    while (!revisions[start].is_keyframe) { --start; }
+
+    std::string text;
+    std::string next_text;
+
+    if (cached_index != SIZE_MAX && cached_index >= start && cached_index < index_)
+    {
+        text  = std::move(cached_text);
+        start = cached_index + 1;
+    }
+    else
+    {
+        text.assign(GetPayload(start));
+        ++start;
+    }
+
+    cached_index = SIZE_MAX;
+
+    for (size_t i = start; i <= index_; ++i)
+    {
+        if (!ApplyDelta(text, GetPayload(i), next_text))
+        {
+            LOG_ERROR("Corrupt delta of the shader history revision {}", i);
+            return "";
+        }
+        text.swap(next_text);
+    }
+
+    if (HashText(text) != revisions[index_].text_hash)
+    {
+        LOG_ERROR("Shader history revision {} does not match its hash", index_);
+        return "";
+    }
+
+    cached_index = index_;
+    cached_text  = text;
+    return text;
+}
+
+ShaderHistoryStats ShaderHistory::GetStats() const noexcept
+{
+    ShaderHistoryStats stats;
+    stats.revisions  = revisions.size();
+    stats.pack_bytes = pack_size;
+
+    for (const auto& revision : revisions)
+    {
+        stats.keyframes  += revision.is_keyframe ? 1 : 0;
+        stats.text_bytes += revision.text_size;
+    }
+
+    return stats;
+}
+
+void ShaderHistory::Index() noexcept
+{
+    std::error_code error;
+    const auto      file_size = std::filesystem::file_size(full_pack_path, error);
+
+    bool is_valid = !error && file_size >= sizeof(PackHeader) && MapPack(file_size);
+
+    if (is_valid)
+    {
+        PackHeader pack_header;
+        std::memcpy(&pack_header, pack_view->GetText().data(), sizeof(pack_header));
+        is_valid = pack_header.magic == PACK_MAGIC && pack_header.version == PACK_VERSION;
+    }
+
+    if (!is_valid)
+    {
+        pack_view.reset();
+
+        // A pack of another version or a damaged one is moved aside, never overwritten
+        if (!error && file_size > 0)
+        {
+            const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch());
+            const std::string aside_path =
+                fmt::format("{}.{}.bak", full_pack_path, now_ms.count());
+
+            std::filesystem::rename(full_pack_path, aside_path, error);
+            if (error)
+            {
+                LOG_ERROR("Shader history is not readable and can not be moved aside, no "
+                          "revisions are recorded: {}",
+                          error.message());
+                is_writable = false;
+                return;
+            }
+
+            LOG_WARN("Shader history is not readable, moved it to {} and starting a new one",
+                     aside_path);
+        }
+
+        error.clear();
+        std::filesystem::create_directories(std::filesystem::path(full_pack_path).parent_path(),
+                                            error);
+
+        const auto       mode = std::ios::out | std::ios::binary | std::ios::trunc;
+        const PackHeader pack_header;
+        std::ofstream    out_file(full_pack_path, mode);
+        out_file.write(reinterpret_cast<const char*>(&pack_header), sizeof(pack_header));
+
+        if (!out_file.good())
+        {
+            LOG_ERROR("Failed to create the shader history: {}", full_pack_path);
+            is_writable = false;
+        }
+
+        pack_size = sizeof(pack_header);
+        return;
+    }
+
+    const std::string_view pack = pack_view->GetText();
+
+    uint64_t offset = sizeof(PackHeader);
+    while (offset + sizeof(RecordHeader) <= pack.size())
+    {
+        RecordHeader header;
+        std::memcpy(&header, pack.data() + offset, sizeof(header));
+
+        const uint64_t end = offset + sizeof(header) + header.payload_size;
+
+        // The first revision must be a keyframe, the others are deltas against it
+        if (header.magic != RECORD_MAGIC || header.kind > RECORD_DELTA
+            || (revisions.empty() && header.kind != RECORD_FULL) || end > pack.size()
+            || HashText(pack.substr(offset + sizeof(header), header.payload_size))
+                   != header.checksum)
+        {
+            break;
+        }
+
+        ShaderRevision revision;
+        revision.time_ms     = header.time_ms;
+        revision.text_hash   = header.text_hash;
+        revision.text_size   = header.text_size;
+        revision.stored_size = static_cast<uint32_t>(end - offset);
+        revision.is_keyframe = header.kind == RECORD_FULL;
+        revision.offset      = offset;
+        revisions.push_back(revision);
+
+        offset = end;
+    }
+
+    pack_size = offset;
+
+    if (offset < pack.size())
+    {
+        LOG_WARN("Cutting off {} bytes of a torn record at the end of the shader history",
+                 pack.size() - offset);
+
+        pack_view.reset();
+        std::filesystem::resize_file(full_pack_path, offset, error);
+    }
+
+    if (!revisions.empty()) { newest_text = GetText(revisions.size() - 1); }
+
+    LOG_INFO("Shader history: {} revisions, {} bytes", revisions.size(), pack_size);
+}
+
+bool ShaderHistory::MapPack(uint64_t required_size_) noexcept
+{
+    if (pack_view && pack_view->GetText().size() >= required_size_) { return true; }
+
+    pack_view.emplace(pack_path, FileViewMode::MAP);
+    return pack_view->IsOpen() && pack_view->GetText().size() >= required_size_;
+}
+
+std::string_view ShaderHistory::GetPayload(size_t index_) noexcept
+{
+    const auto& revision = revisions[index_];
+    if (!MapPack(revision.offset + revision.stored_size)) { return {}; }
+
+    return pack_view->GetText().substr(revision.offset + sizeof(RecordHeader),
+                                       revision.stored_size - sizeof(RecordHeader));
+}
+
+std::string ShaderHistory::EncodeDelta(std::string_view base_, std::string_view target_)
+{
+    // Offsets of the lines of the base by their content, in increasing order
+    std::unordered_map<std::string_view, std::vector<size_t>> base_lines;
+    for (size_t start = 0; start < base_.size();)
+    {
+        const size_t length = GetLineLength(base_, start);
+        base_lines[base_.substr(start, length)].push_back(start);
+        start += length;
+    }
+
+    std::string delta;
+    size_t      copy_offset  = 0;
+    size_t      copy_length  = 0;
+    size_t      insert_start = 0;
+    size_t      insert_end   = 0;
+
+    const auto flush_copy = [&]
+    {
+        if (copy_length == 0) { return; }
+
+        delta.push_back(static_cast<char>(DELTA_COPY));
+        WriteVarint(delta, copy_offset);
+        WriteVarint(delta, copy_length);
+        copy_length = 0;
+    };
+
+    const auto flush_insert = [&]
+    {
+        if (insert_end == insert_start) { return; }
+
+        delta.push_back(static_cast<char>(DELTA_INSERT));
+        WriteVarint(delta, insert_end - insert_start);
+        delta.append(target_.substr(insert_start, insert_end - insert_start));
+        insert_start = insert_end;
+    };
+
+    for (size_t start = 0; start < target_.size();)
+    {
+        const size_t           length = GetLineLength(target_, start);
+        const std::string_view line   = target_.substr(start, length);
+        start                        += length;
+
+        // Unchanged lines usually follow each other, the current copy just grows
+        if (copy_length > 0 && base_.substr(copy_offset + copy_length, length) == line)
+        {
+            copy_length += length;
+            continue;
+        }
+
+        auto it = line.size() >= MIN_COPY_LINE ? base_lines.find(line) : base_lines.end();
+        if (it != base_lines.end())
+        {
+            // Prefers the copy of the line after the previous copy, which keeps the runs long
+            const auto& offsets = it->second;
+            auto        offset =
+                std::lower_bound(offsets.begin(), offsets.end(), copy_offset + copy_length);
+            if (offset == offsets.end()) { offset = offsets.begin(); }
+
+            flush_insert();
+            flush_copy();
+            copy_offset  = *offset;
+            copy_length  = length;
+            insert_start = insert_end = start;
+            continue;
+        }
+
+        flush_copy();
+        if (insert_end == insert_start) { insert_start = start - length; }
+        insert_end = start;
+    }
+
+    flush_copy();
+    flush_insert();
+
+    return delta;
+}
+
+bool ShaderHistory::ApplyDelta(std::string_view base_,
+                               std::string_view delta_,
+                               std::string&     target_)
+{
+    target_.clear();
+
+    for (size_t position = 0; position < delta_.size();)
+    {
+        const auto operation = static_cast<uint8_t>(delta_[position++]);
+        uint64_t   offset    = 0;
+        uint64_t   length    = 0;
+
+        if (operation == DELTA_COPY)
+        {
+            if (!ReadVarint(delta_, position, offset) || !ReadVarint(delta_, position, length)
+                || offset > base_.size() || length > base_.size() - offset)
+            {
+                return false;
+            }
+            target_.append(base_.substr(offset, length));
+        }
+        else if (operation == DELTA_INSERT)
+        {
+            if (!ReadVarint(delta_, position, length) || length > delta_.size() - position)
+            {
+                return false;
+            }
+            target_.append(delta_.substr(position, length));
+            position += length;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "Utils.h"
+
+/**
+ * @brief Description of one revision in the history
+ */
+struct ShaderRevision {
+    int64_t  time_ms     = 0;     /**< Time of the record, milliseconds since the Unix epoch */
+    uint64_t text_hash   = 0;     /**< Hash of the full text, checks the reconstruction */
+    uint32_t text_size   = 0;     /**< Size of the full text in bytes */
+    uint32_t stored_size = 0;     /**< Size of the record in the pack, header included */
+    bool     is_keyframe = false; /**< Flag indicating if the full text is stored */
+    uint64_t offset      = 0;     /**< Offset of the record in the pack */
+};
+
+/**
+ * @brief Sizes of the history, used to see how much the delta encoding saves
+ */
+struct ShaderHistoryStats {
+    uint64_t revisions  = 0;
+    uint64_t keyframes  = 0;
+    uint64_t pack_bytes = 0; /**< Size of the pack file */
+    uint64_t text_bytes = 0; /**< Total size of the full texts of all revisions */
+};
+
+/**
+ * @brief Append-only history of shader revisions, stored in one pack file
+ *
+ * @remark Every revision is a delta against the previous one, made of copies of base lines and
+ * inserted text. Every KEYFRAME_INTERVAL-th revision, and any revision whose delta would not be
+ * smaller, stores the full text, so reading any revision applies at most KEYFRAME_INTERVAL - 1
+ * deltas. The pack is memory-mapped for reading. A torn record at the end, left by a crash during
+ * an append, is cut off when the pack is opened. A pack with an unknown header is moved aside
+ * to "<pack>.<time>.bak", if that fails no revisions are recorded. A history without a pack
+ * path reads and records nothing.
+ */
+struct ShaderHistory {
+    static constexpr uint32_t KEYFRAME_INTERVAL = 32;
+
+    /**
+     * @param pack_path_ Path of the pack file, relative to the application directory, empty to
+     * keep no history
+     */
+    explicit ShaderHistory(std::string_view pack_path_) noexcept;
+
+    ShaderHistory(const ShaderHistory&)             = delete;
+    ShaderHistory& operator= (const ShaderHistory&) = delete;
+
+    /**
+     * @brief Appends the text as the newest revision
+     *
+     * @return true if a revision was appended, false if the text equals the newest revision or
+     * the pack can not be written
+     */
+    bool Append(std::string_view text_) noexcept;
+
+    const std::vector<ShaderRevision>& GetRevisions() const noexcept;
+
+    /**
+     * @brief Reconstructs the text of the revision
+     *
+     * @remark Reading the revisions in order applies one delta per revision
+     *
+     * @return Text of the revision or an empty string if it can not be read
+     */
+    std::string GetText(size_t index_) noexcept;
+
+    ShaderHistoryStats GetStats() const noexcept;
+
+private:
+
+    /**
+     * @brief Reads the record headers of the pack and cuts off a torn or corrupt end, an
+     * unreadable pack is moved aside
+     */
+    void Index() noexcept;
+
+    /**
+     * @brief Maps the pack again if it grew since it was mapped
+     */
+    bool MapPack(uint64_t required_size_) noexcept;
+
+    /**
+     * @brief Returns the payload of the revision in the mapped pack
+     */
+    std::string_view GetPayload(size_t index_) noexcept;
+
+    /**
+     * @brief Encodes the target as copies of lines of the base and inserted text
+     */
+    static std::string EncodeDelta(std::string_view base_, std::string_view target_);
+
+    /**
+     * @return false if the delta is corrupt
+     */
+    static bool ApplyDelta(std::string_view base_, std::string_view delta_, std::string& target_);
+
+private:
+    std::string pack_path;          /**< Relative to the application directory */
+    std::string full_pack_path;     /**< Absolute path, used for writing */
+    uint64_t    pack_size   = 0;    /**< Size of the valid records */
+    bool        is_writable = true; /**< The pack could be opened or created */
+
+    std::vector<ShaderRevision> revisions;
+    std::optional<FileView>     pack_view; /**< Mapping of the pack, replaced when it grew */
+
+    std::string newest_text;             /**< Base of the delta of the next revision */
+    size_t      cached_index = SIZE_MAX; /**< Revision of cached_text, SIZE_MAX if none */
+    std::string cached_text;             /**< Last reconstructed revision, speeds up scrubbing */
+};
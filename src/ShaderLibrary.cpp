@@ -0,0 +1,118 @@
+#include "ShaderLibrary.h"
+#include "Utils.h"
+
+ShaderLibrary::ShaderLibrary(std::string_view directory_path_,
+                             std::string_view extension_) noexcept :
+    directory(directory_path_),
+    full_directory(GetApplicationPath() + "/" + directory),
+    extension(extension_),
+    snapshot(std::make_shared<const ShaderLibrarySnapshot>()),
+    watcher([this](const std::vector<std::string>& changed_paths_) { OnChanges(changed_paths_); })
+{
+    std::error_code error;
+    std::filesystem::create_directories(full_directory, error);
+    if (error) { LOG_ERROR("Failed to create directory {}: {}", full_directory, error.message()); }
+
+    // Watching first, a file created during the scan is reported again and changes nothing
+    watcher.Watch(full_directory);
+
+    // The first listing is built here on the calling thread, which waits for the scan. The
+    // watcher thread may report changes already and waits for the lock until it is published
+    std::lock_guard lock(index_mutex);
+    Rescan();
+    Publish();
+}
+
+std::shared_ptr<const ShaderLibrarySnapshot> ShaderLibrary::GetSnapshot() const noexcept
+{
+    std::lock_guard lock(snapshot_mutex);
+    return snapshot;
+}
+
+uint64_t ShaderLibrary::GetRevision() const noexcept
+{
+    return revision.load(std::memory_order_relaxed);
+}
+
+bool ShaderLibrary::IsWatchedNatively() const noexcept { return watcher.IsNative(); }
+
+void ShaderLibrary::OnChanges(const std::vector<std::string>& changed_paths_) noexcept
+{
+    std::lock_guard lock(index_mutex);
+
+    if (changed_paths_.empty())  // Events were lost
+    {
+        Rescan();
+        Publish();
+        return;
+    }
+
+    bool is_changed = false;
+
+    for (const auto& changed_path : changed_paths_)
+    {
+        if (changed_path == full_directory)  // The directory itself was removed or moved
+        {
+            Rescan();
+            is_changed = true;
+            continue;
+        }
+
+        const std::filesystem::path path(changed_path);
+        if (path.parent_path() != full_directory || path.extension() != extension) { continue; }
+
+        std::error_code error;
+        auto            name = path.stem().string();
+
+        if (std::filesystem::is_regular_file(path, error))
+        {
+            is_changed |= names.insert(std::move(name)).second;
+        }
+        else
+        {
+            is_changed |= names.erase(name) > 0;
+        }
+    }
+
+    if (is_changed) { Publish(); }
+}
+
+void ShaderLibrary::Rescan() noexcept
+{
+    std::set<std::string> scanned_names;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(full_directory, error), end; !error && it != end;
+         it.increment(error))
+    {
+        std::error_code entry_error;
+        if (it->is_regular_file(entry_error) && it->path().extension() == extension)
+        {
+            scanned_names.insert(it->path().stem().string());
+        }
+    }
+
+    if (error) { LOG_ERROR("Failed to list directory {}: {}", full_directory, error.message()); }
+
+    names = std::move(scanned_names);
+}
+
+void ShaderLibrary::Publish() noexcept
+{
+    auto listing = std::make_shared<ShaderLibrarySnapshot>();
+    listing->reserve(names.size());
+
+    for (const auto& name : names)
+    {
+        listing->push_back({ name, directory + "/" + name + extension });
+    }
+
+    // Readers wait only for the swap, the old listing is also freed after unlocking
+    std::shared_ptr<const ShaderLibrarySnapshot> published = std::move(listing);
+    {
+        std::lock_guard lock(snapshot_mutex);
+        snapshot.swap(published);
+    }
+
+    revision.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "DirectoryWatcher.h"
+
+/**
+ * @brief Shader file of the library
+ */
+struct ShaderLibraryEntry {
+    std::string name; /**< File name without the extension */
+    std::string path; /**< Path relative to the application directory */
+};
+
+/**
+ * @brief Immutable listing of the library, sorted by name
+ */
+using ShaderLibrarySnapshot = std::vector<ShaderLibraryEntry>;
+
+/**
+ * @brief Index of the shader files in a directory, built once and kept up to date by a
+ * DirectoryWatcher, so reading it costs no file system calls
+ *
+ * @remark Readers get a shared pointer to an immutable snapshot, a change publishes a new snapshot
+ * and never touches the old one. The first scan runs synchronously in the constructor, later
+ * scans run on the watcher thread under the index mutex, which readers never take. Readers take
+ * the snapshot mutex just for swapping the pointer.
+ */
+struct ShaderLibrary {
+    /**
+     * @param directory_path_ Directory of the shaders, relative to the application directory,
+     * created if it does not exist
+     * @param extension_ Extension of the shader files, e.g. ".glsl"
+     */
+    explicit ShaderLibrary(std::string_view directory_path_, std::string_view extension_) noexcept;
+
+    ShaderLibrary(const ShaderLibrary&)             = delete;
+    ShaderLibrary& operator= (const ShaderLibrary&) = delete;
+
+    /**
+     * @brief Returns the current listing, thread safe
+     */
+    std::shared_ptr<const ShaderLibrarySnapshot> GetSnapshot() const noexcept;
+
+    /**
+     * @brief Returns the number of the snapshots published so far
+     */
+    uint64_t GetRevision() const noexcept;
+
+    /**
+     * @brief Returns true if the directory is watched by the OS, false if it is polled
+     */
+    bool IsWatchedNatively() const noexcept;
+
+private:
+
+    /**
+     * @brief Applies the changes reported by the watcher
+     */
+    void OnChanges(const std::vector<std::string>& changed_paths_) noexcept;
+
+    /**
+     * @brief Lists the whole directory again, the index mutex must be locked
+     */
+    void Rescan() noexcept;
+
+    /**
+     * @brief Builds a new snapshot from the names, the index mutex must be locked
+     */
+    void Publish() noexcept;
+
+private:
+    std::string directory;      /**< Directory relative to the application directory */
+    std::string full_directory; /**< Full path of the directory */
+    std::string extension;      /**< Extension of the shader files */
+
+    std::mutex            index_mutex; /**< Guards the names, held while scanning */
+    std::set<std::string> names;       /**< Names of the shader files */
+
+    mutable std::mutex                           snapshot_mutex; /**< Guards only the pointer */
+    std::shared_ptr<const ShaderLibrarySnapshot> snapshot;       /**< Published listing */
+    std::atomic<uint64_t>                        revision = 0;   /**< Published snapshots */
+
+    DirectoryWatcher watcher; /**< Declared last, stops calling back before the index goes away */
+};
@@ -1,10 +1,32 @@
 #include "ShaderManager.h"
 
 #include "Utils.h"
+#include "BuiltinUniforms.h"
 
-ShaderManager::ShaderManager() noexcept
+double ShaderProgramStats::GetAverageRebuildMs() const noexcept
 {
-    auto vertex_shader_source = ReadTextFromFile("shaders/default/default_vertex.glsl");
+    return rebuilds ? total_rebuild_ms / static_cast<double>(rebuilds) : 0.0;
+}
+
+double ShaderProgramStats::GetEstimatedSavedMs() const noexcept
+{
+    return GetAverageRebuildMs() * static_cast<double>(skipped_rebuilds);
+}
+
+ShaderManager::ShaderManager(ShaderManagerMode mode_) noexcept :
+    program_cache("cache/programs"),
+    recompile_scheduler(DEFAULT_RECOMPILE_DELAY),
+    supported_glsl_version(GetSupportedGLSLVersion()),
+    preprocessor("shaders"),
+    autosave_interval(DEFAULT_AUTOSAVE_INTERVAL),
+    last_autosave_time(std::chrono::steady_clock::now()),
+    history(mode_ == ShaderManagerMode::INTERACTIVE ? "history/fragment.pack" : ""),
+    history_loaded_hash(0)
+{
+    program_cache.Initialize();
+
+    vertex_shader_path        = "shaders/default/default_vertex.glsl";
+    auto vertex_shader_source = ReadTextFromFile(vertex_shader_path);
     if (vertex_shader_source.empty())
     {
         LOG_CRITICAL("Failed to load vertex shader from path: {}",
@@ -32,7 +54,13 @@ void main()
         WriteTextToFile("shaders/default/default_vertex.glsl", vertex_shader_source);
     }
 
-    auto fragment_shader_source = ReadTextFromFile("shaders/latest_fragment.glsl");
+    vertex_shader.GetCode() = vertex_shader_source;
+
+    // A headless render is built from the shader of its command line only
+    if (mode_ == ShaderManagerMode::HEADLESS) { return; }
+
+    fragment_shader_path        = "shaders/latest_fragment.glsl";
+    auto fragment_shader_source = ReadTextFromFile(fragment_shader_path);
 
     if (fragment_shader_source.empty())
     {
@@ -40,7 +68,8 @@ void main()
                      "shaders/latest_fragment.glsl");
 
         LOG_INFO("Loading default fragment shader");
-        fragment_shader_source = ReadTextFromFile("shaders/default/default_fragment.glsl");
+        fragment_shader_path   = "shaders/default/default_fragment.glsl";
+        fragment_shader_source = ReadTextFromFile(fragment_shader_path);
 
         if (fragment_shader_source.empty())
         {
@@ -78,24 +107,291 @@ void main()
     }
 
 
-    vertex_shader.CompileFromText(vertex_shader_source, ShaderType::VERTEX);
-
-    fragment_shader.CompileFromText(fragment_shader_source, ShaderType::FRAGMENT);
+    fragment_shader.GetCode() = fragment_shader_source;
 
-    shader_program = ShaderProgram(vertex_shader, fragment_shader);
+    RebuildShaderProgram();
+    LoadSavedBuffers();  // Buffers saved by the last session are enabled again
 }
 
 ShaderManager::~ShaderManager() {}
 
+void ShaderManager::LoadSavedBuffers() noexcept
+{
+    for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+    {
+        const auto full_path = std::filesystem::path(GetApplicationPath()) / BUFFER_PATHS[i];
+
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(full_path, error)) { continue; }
+
+        auto& buffer = buffer_shaders[i];
+
+        buffer.shader.GetCode() = ReadTextFromFile(BUFFER_PATHS[i]);
+        buffer.is_enabled       = !buffer.shader.GetCodeConst().empty();
+    }
+
+    RebuildBufferPrograms();
+    UpdateWatchedFiles();
+}
+
 Shader& ShaderManager::GetVertexShader() noexcept { return vertex_shader; }
 
 Shader& ShaderManager::GetFragmentShader() noexcept { return fragment_shader; }
 
 ShaderProgram& ShaderManager::GetShaderProgram() noexcept { return shader_program; }
 
+uint64_t ShaderManager::GetShaderProgramGeneration() const noexcept
+{
+    return shader_program_generation;
+}
+
+const ShaderProgramStats& ShaderManager::GetStats() const noexcept { return stats; }
+
+RecompileStats ShaderManager::GetRecompileStats() const noexcept
+{
+    RecompileStats result = recompile_scheduler.GetStats();
+
+    if (compile_service)
+    {
+        result.requests_superseded = compile_service->GetSupersededCount();
+        result.compiles_cancelled  = compile_service->GetCancelledCount();
+    }
+
+    return result;
+}
+
+void ShaderManager::SetRecompileDelay(std::chrono::milliseconds delay_) noexcept
+{
+    recompile_scheduler.SetIdleWindow(delay_);
+}
+
+std::chrono::milliseconds ShaderManager::GetRecompileDelay() const noexcept
+{
+    return recompile_scheduler.GetIdleWindow();
+}
+
+bool ShaderManager::UpdateShaderProgram() noexcept
+{
+    if (file_watcher) { ApplyFileChanges(); }
+
+    bool is_replaced = false;
+
+    if (compile_service)
+    {
+        if (auto result = compile_service->TakeResult())
+        {
+            is_replaced = ApplyCompileResult(*result);
+        }
+    }
+
+    const uint64_t vertex_hash   = vertex_shader.GetCodeHash();
+    const uint64_t fragment_hash = fragment_shader.GetCodeHash();
+
+    const bool is_image_changed =
+        vertex_hash != linked_vertex_hash || fragment_hash != linked_fragment_hash;
+
+    // Buffers are debounced together with the image, one key covers all the edited code
+    uint64_t edit_hash         = HashCombine(vertex_hash, fragment_hash);
+    bool     is_buffer_changed = false;
+
+    for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+    {
+        if (!buffer_shaders[i].is_enabled) { continue; }
+
+        const uint64_t link_hash = GetBufferLinkHash(i);
+
+        edit_hash         = HashCombine(edit_hash, link_hash);
+        is_buffer_changed = is_buffer_changed || link_hash != buffer_shaders[i].linked_hash;
+    }
+
+    if (!is_image_changed && !is_buffer_changed)
+    {
+        ++stats.skipped_rebuilds;
+        return is_replaced;
+    }
+
+    // The code is being edited, wait until the user stops typing
+    if (!recompile_scheduler.Update(edit_hash, RecompileScheduler::Clock::now()))
+    {
+        ++stats.deferred_rebuilds;
+        return is_replaced;
+    }
+
+    // Buffers are small and compiled here, only the image goes to the background worker
+    if (is_buffer_changed) { is_replaced = RebuildBufferPrograms() || is_replaced; }
+
+    if (!is_image_changed) { return is_replaced; }
+
+    if (!compile_service) { return RebuildShaderProgram(); }
+
+    SubmitCompileRequest();
+
+    linked_vertex_hash   = vertex_hash;
+    linked_fragment_hash = fragment_hash;
+
+    return is_replaced;
+}
+
+bool ShaderManager::RebuildShaderProgram() noexcept
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Remember what we tried to link, so broken code is not recompiled every frame
+    linked_vertex_hash   = vertex_shader.GetCodeHash();
+    linked_fragment_hash = fragment_shader.GetCodeHash();
+
+    // Background results which are still in flight are older than this build
+    applied_revision = ++submitted_revision;
+    submitted_fragment_code.clear();
+
+    const std::string vertex_source   = GetCompileSource(ShaderType::VERTEX);
+    const std::string fragment_source = GetCompileSource(ShaderType::FRAGMENT);
+
+    const bool is_replaced = LinkProgram(fragment_shader,
+                                         preprocessed_fragment.result,
+                                         vertex_source,
+                                         fragment_source,
+                                         shader_program);
+
+    if (is_replaced) { ++shader_program_generation; }
+
+    const std::chrono::duration<double, std::milli> rebuild_time =
+        std::chrono::steady_clock::now() - start_time;
+
+    ++stats.rebuilds;
+    stats.last_rebuild_ms   = rebuild_time.count();
+    stats.total_rebuild_ms += rebuild_time.count();
+
+    if (is_replaced) { RecordHistory(fragment_shader.GetCodeConst()); }
+
+    return is_replaced;
+}
+
+bool ShaderManager::RebuildBufferPrograms() noexcept
+{
+    bool is_replaced = false;
+
+    for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+    {
+        const auto& buffer = buffer_shaders[i];
+
+        if (buffer.is_enabled && buffer.linked_hash != GetBufferLinkHash(i))
+        {
+            is_replaced = RebuildBufferProgram(i) || is_replaced;
+        }
+    }
+
+    return is_replaced;
+}
+
+bool ShaderManager::RebuildBufferProgram(size_t index_) noexcept
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    auto& buffer       = buffer_shaders[index_];
+    buffer.linked_hash = GetBufferLinkHash(index_);
+
+    const std::string vertex_source   = GetCompileSource(ShaderType::VERTEX);
+    const std::string fragment_source = GetCompileSource(buffer.shader,
+                                                         buffer.preprocessed,
+                                                         BUFFER_ROOT_IDS[index_],
+                                                         BUFFER_PATHS[index_]);
+
+    const bool is_replaced = LinkProgram(buffer.shader,
+                                         buffer.preprocessed.result,
+                                         vertex_source,
+                                         fragment_source,
+                                         buffer.program);
+
+    if (is_replaced) { ++buffer.generation; }
+
+    const std::chrono::duration<double, std::milli> rebuild_time =
+        std::chrono::steady_clock::now() - start_time;
+
+    ++stats.rebuilds;
+    stats.last_rebuild_ms   = rebuild_time.count();
+    stats.total_rebuild_ms += rebuild_time.count();
+
+    return is_replaced;
+}
+
+bool ShaderManager::LinkProgram(Shader&                   fragment_shader_,
+                                const PreprocessedSource& fragment_preprocessed_,
+                                const std::string&        vertex_source_,
+                                const std::string&        fragment_source_,
+                                ShaderProgram&            program_) noexcept
+{
+    const uint64_t cache_key = program_cache.MakeKey(vertex_source_, fragment_source_);
+
+    if (program_cache.Load(cache_key, program_))
+    {
+        // The cached program was linked from exactly this source, so both shaders are good
+        const uint64_t vertex_source_hash   = HashText(vertex_source_);
+        const uint64_t fragment_source_hash = HashText(fragment_source_);
+
+        if (vertex_shader.GetCompiledHash() != vertex_source_hash)
+        {
+            vertex_shader.SetCompilationResult(ShaderType::VERTEX, vertex_source_hash, true, "");
+        }
+
+        if (fragment_shader_.GetCompiledHash() != fragment_source_hash)
+        {
+            fragment_shader_.SetCompilationResult(ShaderType::FRAGMENT,
+                                                  fragment_source_hash,
+                                                  true,
+                                                  "");
+        }
+
+        ++stats.cache_hits;
+        return true;
+    }
+
+    // Errors point at the lines of the files before the includes were expanded
+    vertex_shader.SetLineMap(preprocessed_vertex.result.line_map);
+    fragment_shader_.SetLineMap(fragment_preprocessed_.line_map);
+
+    // Only the shaders with changed source are really compiled
+    vertex_shader.CompileFromSource(vertex_source_, ShaderType::VERTEX);
+    fragment_shader_.CompileFromSource(fragment_source_, ShaderType::FRAGMENT);
+
+    if (!vertex_shader.IsGood() || !fragment_shader_.IsGood()) { return false; }
+
+    ShaderProgram new_program(vertex_shader, fragment_shader_);
+    if (new_program.GetID() == 0) { return false; }
+
+    program_cache.Store(cache_key, new_program);
+    program_ = std::move(new_program);
+
+    return true;
+}
+
+void ShaderManager::UpdateAutosave() noexcept
+{
+    if (autosave_interval.count() <= 0) { return; }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_autosave_time < autosave_interval) { return; }
+
+    last_autosave_time = now;
+    SaveFragmentShaderToPath(AUTOSAVE_PATH);
+    SaveBufferShaders();
+}
+
+void ShaderManager::SetAutosaveInterval(std::chrono::seconds interval_) noexcept
+{
+    autosave_interval = interval_;
+}
+
+std::chrono::seconds ShaderManager::GetAutosaveInterval() const noexcept
+{
+    return autosave_interval;
+}
+
+AsyncFileWriterStats ShaderManager::GetSaveStats() const noexcept { return file_writer.GetStats(); }
+
 bool ShaderManager::SaveFragmentShaderToPath(std::string_view fragment_shader_path_)
 {
-    return WriteTextToFile(fragment_shader_path_, fragment_shader.GetCode());
+    return file_writer.Write(fragment_shader_path_, fragment_shader.GetCodeConst());
 }
 
 bool ShaderManager::LoadFragmentShaderFromPath(std::string_view fragment_shader_path_)
@@ -104,14 +400,453 @@ bool ShaderManager::LoadFragmentShaderFromPath(std::string_view fragment_shader_
 
     if (!fragment_shader_source.empty())
     {
-        fragment_shader.CompileFromText(fragment_shader_source, ShaderType::FRAGMENT);
+        fragment_shader.GetCode() = std::move(fragment_shader_source);
 
-        if (fragment_shader.IsGood())
+        if (fragment_shader_path != fragment_shader_path_)
         {
-            shader_program = ShaderProgram(vertex_shader, fragment_shader);
-            return true;
+            fragment_shader_path = fragment_shader_path_;
+            UpdateWatchedFiles();
         }
+
+        // Compiles only if the program is not in the cache yet
+        RebuildShaderProgram();
+
+        return fragment_shader.IsGood();
     }
 
     return false;
 }
+
+ShaderHistory& ShaderManager::GetHistory() noexcept { return history; }
+
+bool ShaderManager::LoadFragmentShaderFromHistory(size_t revision_)
+{
+    auto fragment_shader_source = history.GetText(revision_);
+    if (fragment_shader_source.empty()) { return false; }
+
+    history_loaded_hash       = HashText(fragment_shader_source);
+    fragment_shader.GetCode() = std::move(fragment_shader_source);
+
+    // Compiles only if the program is not in the cache yet
+    RebuildShaderProgram();
+
+    return fragment_shader.IsGood();
+}
+
+Shader& ShaderManager::GetBufferShader(size_t index_) noexcept
+{
+    return buffer_shaders[index_].shader;
+}
+
+ShaderProgram* ShaderManager::GetBufferProgram(size_t index_) noexcept
+{
+    auto& buffer = buffer_shaders[index_];
+    return buffer.is_enabled && buffer.program.GetID() != 0 ? &buffer.program : nullptr;
+}
+
+uint64_t ShaderManager::GetBufferProgramGeneration(size_t index_) const noexcept
+{
+    return buffer_shaders[index_].generation;
+}
+
+std::string_view ShaderManager::GetBufferPath(size_t index_) const noexcept
+{
+    return BUFFER_PATHS[index_];
+}
+
+void ShaderManager::SetBufferEnabled(size_t index_, bool is_enabled_) noexcept
+{
+    auto& buffer = buffer_shaders[index_];
+    if (buffer.is_enabled == is_enabled_) { return; }
+
+    buffer.is_enabled = is_enabled_;
+
+    if (is_enabled_ && buffer.shader.GetCodeConst().empty())
+    {
+        const char letter = static_cast<char>('A' + index_);
+
+        buffer.shader.GetCode() = fmt::format(R"(#version 460 core
+
+// Read by the image or other buffers with "#pragma iChannel0 Buffer{0}"
+#pragma iChannel0 Buffer{0}  // Previous frame of this buffer
+
+in vec2 fragCoord;
+in vec2 iResolution;
+uniform float iTime;
+uniform sampler2D iChannel0;
+
+out vec4 fragColor;
+
+void main()
+{{
+    vec2 uv       = fragCoord / iResolution;
+    vec4 previous = texture(iChannel0, uv);
+
+    fragColor = mix(previous, vec4(uv, 0.5 + 0.5 * sin(iTime), 1.0), 0.05);
+}}
+)",
+                                              letter);
+    }
+
+    // The directory must exist to be watched before the first save
+    const auto full_path = std::filesystem::path(GetApplicationPath()) / BUFFER_PATHS[index_];
+
+    std::error_code error;
+    std::filesystem::create_directories(full_path.parent_path(), error);
+
+    UpdateWatchedFiles();
+}
+
+bool ShaderManager::IsBufferEnabled(size_t index_) const noexcept
+{
+    return buffer_shaders[index_].is_enabled;
+}
+
+void ShaderManager::SaveBufferShaders() noexcept
+{
+    for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+    {
+        const auto& buffer = buffer_shaders[i];
+        if (buffer.is_enabled) { file_writer.Write(BUFFER_PATHS[i], buffer.shader.GetCodeConst()); }
+    }
+}
+
+uint64_t ShaderManager::GetBufferLinkHash(size_t index_) const noexcept
+{
+    return HashCombine(vertex_shader.GetCodeHash(), buffer_shaders[index_].shader.GetCodeHash());
+}
+
+bool ShaderManager::LoadVertexShaderFromPath(std::string_view vertex_shader_path_)
+{
+    auto vertex_shader_source = ReadTextFromFile(vertex_shader_path_);
+
+    if (!vertex_shader_source.empty())
+    {
+        vertex_shader.GetCode() = std::move(vertex_shader_source);
+
+        if (vertex_shader_path != vertex_shader_path_)
+        {
+            vertex_shader_path = vertex_shader_path_;
+            UpdateWatchedFiles();
+        }
+
+        RebuildShaderProgram();
+
+        return vertex_shader.IsGood();
+    }
+
+    return false;
+}
+
+void ShaderManager::EnableHotReload() noexcept
+{
+    file_watcher = std::make_unique<ShaderFileWatcher>();
+    UpdateWatchedFiles();
+}
+
+void ShaderManager::OnFramePresented() noexcept
+{
+    if (!pending_reload) { return; }
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    const auto present_time = std::chrono::system_clock::now();
+
+    // The save time comes from the file system, clamped in case its clock is ahead of ours
+    const auto save_time = pending_reload->save_time;
+
+    last_reload_latency.detect_ms =
+        std::max(0.0, Milliseconds(pending_reload->detect_time - save_time).count());
+    last_reload_latency.compile_ms = pending_reload->compile_ms;
+    last_reload_latency.total_ms   = std::max(0.0, Milliseconds(present_time - save_time).count());
+
+    LOG_INFO("Hot reload of {}: {:.2f} ms from save to frame (detect {:.2f} ms, compile {:.2f} ms)",
+             pending_reload->path,
+             last_reload_latency.total_ms,
+             last_reload_latency.detect_ms,
+             last_reload_latency.compile_ms);
+
+    pending_reload.reset();
+}
+
+const HotReloadLatency& ShaderManager::GetLastHotReloadLatency() const noexcept
+{
+    return last_reload_latency;
+}
+
+void ShaderManager::ApplyFileChanges() noexcept
+{
+    for (const auto& change : file_watcher->TakeChanges())
+    {
+        const bool is_fragment = change.path == fragment_shader_path;
+        const bool is_vertex   = change.path == vertex_shader_path;
+
+        const auto buffer_path  = std::find(BUFFER_PATHS.begin(), BUFFER_PATHS.end(), change.path);
+        const auto buffer_index = static_cast<size_t>(buffer_path - BUFFER_PATHS.begin());
+        const bool is_buffer =
+            buffer_path != BUFFER_PATHS.end() && buffer_shaders[buffer_index].is_enabled;
+
+        const auto dependents = preprocessor.GetDependents(change.path);
+
+        if (is_fragment || is_vertex || is_buffer)
+        {
+            // Our own saves, also of code edited since, and editors which touch the file without
+            // changing it, reload nothing
+            const FileView   file(change.path);
+            std::string_view current_code = vertex_shader.GetCodeConst();
+            if (is_fragment) { current_code = fragment_shader.GetCodeConst(); }
+            if (is_buffer) { current_code = buffer_shaders[buffer_index].shader.GetCodeConst(); }
+
+            if (file.GetText().empty() || file.GetText() == current_code
+                || file_writer.IsLastWrite(change.path, file.GetText()))
+            {
+                continue;
+            }
+        }
+        else if (dependents.empty())  // Include which is not used anymore
+        {
+            continue;
+        }
+
+        std::error_code error;
+        const auto      write_time =
+            std::filesystem::last_write_time(GetApplicationPath() + "/" + change.path, error);
+
+        PendingHotReload reload;
+        reload.path        = change.path;
+        reload.detect_time = change.detect_time;
+        reload.save_time   = change.detect_time;
+
+        if (!error)
+        {
+            reload.save_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+                std::chrono::file_clock::to_sys(write_time));
+        }
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        if (is_fragment) { LoadFragmentShaderFromPath(change.path); }
+        else if (is_vertex) { LoadVertexShaderFromPath(change.path); }
+        else if (is_buffer)
+        {
+            buffer_shaders[buffer_index].shader.GetCode() = ReadTextFromFile(change.path);
+            RebuildBufferProgram(buffer_index);
+        }
+        else
+        {
+            // Only the shaders including the file are preprocessed and compiled again
+            preprocessor.Invalidate(change.path);
+
+            bool is_image_dependent = false;
+
+            for (const auto& dependent : dependents)
+            {
+                auto root = std::find(BUFFER_ROOT_IDS.begin(), BUFFER_ROOT_IDS.end(), dependent);
+                if (root != BUFFER_ROOT_IDS.end())
+                {
+                    const auto index = static_cast<size_t>(root - BUFFER_ROOT_IDS.begin());
+
+                    buffer_shaders[index].preprocessed.is_stale = true;
+                    if (buffer_shaders[index].is_enabled) { RebuildBufferProgram(index); }
+                    continue;
+                }
+
+                auto& preprocessed =
+                    dependent == VERTEX_ROOT_ID ? preprocessed_vertex : preprocessed_fragment;
+                preprocessed.is_stale = true;
+                is_image_dependent    = true;
+            }
+
+            if (is_image_dependent) { RebuildShaderProgram(); }
+        }
+
+        reload.compile_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time)
+                .count();
+
+        pending_reload = std::move(reload);
+    }
+}
+
+void ShaderManager::RecordHistory(std::string_view fragment_code_) noexcept
+{
+    // Scrubbing through the history must not append the old revisions again
+    if (HashText(fragment_code_) == history_loaded_hash) { return; }
+
+    history_loaded_hash = 0;
+    history.Append(fragment_code_);
+}
+
+void ShaderManager::UpdateWatchedFiles() noexcept
+{
+    if (!file_watcher) { return; }
+
+    std::vector<std::string> files { vertex_shader_path };
+    if (!fragment_shader_path.empty()) { files.push_back(fragment_shader_path); }
+
+    for (const auto* preprocessed : { &preprocessed_vertex, &preprocessed_fragment })
+    {
+        const auto& includes = preprocessed->result.includes;
+        files.insert(files.end(), includes.begin(), includes.end());
+    }
+
+    for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+    {
+        const auto& buffer = buffer_shaders[i];
+        if (!buffer.is_enabled) { continue; }
+
+        const auto& includes = buffer.preprocessed.result.includes;
+        files.emplace_back(BUFFER_PATHS[i]);
+        files.insert(files.end(), includes.begin(), includes.end());
+    }
+
+    file_watcher->SetFiles(files);
+}
+
+bool ShaderManager::EnableAsyncCompilation(GLFWwindow* window_) noexcept
+{
+    auto service = std::make_unique<CompileService>(window_, program_cache);
+
+    if (!service->IsRunning())
+    {
+        LOG_WARN("Background compilation is not available, compiling on the render thread");
+        return false;
+    }
+
+    compile_service = std::move(service);
+    return true;
+}
+
+void ShaderManager::SubmitCompileRequest() noexcept
+{
+    auto request             = std::make_unique<CompileRequest>();
+    request->revision        = ++submitted_revision;
+    request->vertex_source     = GetCompileSource(ShaderType::VERTEX);
+    request->fragment_source   = GetCompileSource(ShaderType::FRAGMENT);
+    request->vertex_line_map   = preprocessed_vertex.result.line_map;
+    request->fragment_line_map = preprocessed_fragment.result.line_map;
+
+    submitted_fragment_code.emplace(request->revision, fragment_shader.GetCodeConst());
+
+    compile_service->Submit(std::move(request));
+}
+
+bool ShaderManager::ApplyCompileResult(CompileResult& result_) noexcept
+{
+    // A synchronous build happened after this request was submitted
+    if (result_.revision < applied_revision) { return false; }
+
+    applied_revision = result_.revision;
+
+    // The code of this and the superseded requests is not needed anymore
+    auto        code_end = submitted_fragment_code.upper_bound(result_.revision);
+    std::string fragment_code;
+    if (code_end != submitted_fragment_code.begin()
+        && std::prev(code_end)->first == result_.revision)
+    {
+        fragment_code = std::move(std::prev(code_end)->second);
+    }
+    submitted_fragment_code.erase(submitted_fragment_code.begin(), code_end);
+
+    ++stats.rebuilds;
+    stats.last_rebuild_ms   = result_.compile_ms;
+    stats.total_rebuild_ms += result_.compile_ms;
+
+    if (result_.is_from_cache) { ++stats.cache_hits; }
+
+    // Shaders whose code was not changed keep their local objects
+    if (vertex_shader.GetCompiledHash() != result_.vertex_hash)
+    {
+        vertex_shader.SetCompilationResult(ShaderType::VERTEX,
+                                           result_.vertex_hash,
+                                           result_.is_vertex_good,
+                                           result_.vertex_error);
+    }
+
+    if (fragment_shader.GetCompiledHash() != result_.fragment_hash)
+    {
+        fragment_shader.SetCompilationResult(ShaderType::FRAGMENT,
+                                             result_.fragment_hash,
+                                             result_.is_fragment_good,
+                                             result_.fragment_error);
+    }
+
+    if (result_.shader_program.GetID() == 0) { return false; }
+
+    shader_program = std::move(result_.shader_program);
+    ++shader_program_generation;
+
+    if (!fragment_code.empty()) { RecordHistory(fragment_code); }
+
+    return true;
+}
+
+void ShaderManager::SetBuiltinBlockEnabled(bool is_enabled_) noexcept
+{
+    if (is_builtin_block_enabled == is_enabled_) { return; }
+
+    is_builtin_block_enabled = is_enabled_;
+
+    // The same code compiles to a different source now
+    linked_vertex_hash   = 0;
+    linked_fragment_hash = 0;
+
+    for (auto& buffer : buffer_shaders) { buffer.linked_hash = 0; }
+}
+
+bool ShaderManager::IsBuiltinBlockEnabled() const noexcept { return is_builtin_block_enabled; }
+
+std::string ShaderManager::GetCompileSource(ShaderType type_)
+{
+    if (type_ == ShaderType::VERTEX)
+    {
+        return GetCompileSource(vertex_shader,
+                                preprocessed_vertex,
+                                VERTEX_ROOT_ID,
+                                vertex_shader_path);
+    }
+
+    return GetCompileSource(fragment_shader,
+                            preprocessed_fragment,
+                            FRAGMENT_ROOT_ID,
+                            fragment_shader_path);
+}
+
+std::string ShaderManager::GetCompileSource(const Shader&       shader_,
+                                            PreprocessedShader& preprocessed_,
+                                            std::string_view    root_id_,
+                                            std::string_view    path_)
+{
+    // Includes are expanded again only when the code or one of the included files changed
+    const uint64_t code_hash = shader_.GetCodeHash();
+    if (preprocessed_.is_stale || preprocessed_.code_hash != code_hash)
+    {
+        auto result = preprocessor.Process(root_id_, path_, shader_.GetCodeConst());
+
+        const bool is_includes_changed = result.includes != preprocessed_.result.includes;
+
+        preprocessed_.result    = std::move(result);
+        preprocessed_.code_hash = code_hash;
+        preprocessed_.is_stale  = false;
+
+        if (is_includes_changed) { UpdateWatchedFiles(); }
+    }
+
+    const std::string& source = preprocessed_.result.source;
+
+    // The user compiles another language version than written, told once per shader
+    const int32_t version = GetGLSLVersion(source);
+    if (supported_glsl_version > 0 && version > supported_glsl_version
+        && !preprocessed_.is_version_logged)
+    {
+        LOG_WARN("{}: #version {} is not supported by the context, compiled as #version {}",
+                 path_.empty() ? root_id_ : path_,
+                 version,
+                 supported_glsl_version);
+        preprocessed_.is_version_logged = true;
+    }
+
+    if (!is_builtin_block_enabled) { return LimitGLSLVersion(source, supported_glsl_version); }
+
+    return LimitGLSLVersion(InjectBuiltinUniformBlock(source), supported_glsl_version);
+}
\ No newline at end of file
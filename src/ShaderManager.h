@@ -4,23 +4,395 @@
 
 #include "Shader.h"
 #include "ShaderProgram.h"
+#include "CompileService.h"
+#include "ProgramBinaryCache.h"
+#include "RecompileScheduler.h"
+#include "ShaderFileWatcher.h"
+#include "ShaderPreprocessor.h"
+#include "AsyncFileWriter.h"
+#include "ShaderHistory.h"
+#include "RenderGraph.h"
+
+/**
+ * @brief Counters of the shader program rebuilds, used to see how much work change detection saves
+ */
+struct ShaderProgramStats {
+    uint64_t rebuilds          = 0;   /**< Number of the shader program rebuilds */
+    uint64_t skipped_rebuilds  = 0;   /**< Number of the updates which found the code unchanged */
+    uint64_t deferred_rebuilds = 0;   /**< Number of the updates which waited for the debounce */
+    uint64_t cache_hits        = 0;   /**< Number of the rebuilds loaded from the program cache */
+    double   last_rebuild_ms   = 0.0; /**< Duration of the last rebuild in milliseconds */
+    double   total_rebuild_ms  = 0.0; /**< Total duration of all rebuilds in milliseconds */
+
+    /**
+     * @brief Returns the average duration of a rebuild in milliseconds
+     */
+    double GetAverageRebuildMs() const noexcept;
+
+    /**
+     * @brief Returns the estimated time saved by the skipped rebuilds in milliseconds
+     *
+     * @remark Deferred rebuilds are not counted, they only postpone a rebuild
+     */
+    double GetEstimatedSavedMs() const noexcept;
+};
+
+/**
+ * @brief Timing of a hot reload, from the save in the external editor to the first frame drawn
+ * with the new code
+ */
+struct HotReloadLatency {
+    double detect_ms  = 0.0; /**< From the write of the file to the watcher report */
+    double compile_ms = 0.0; /**< Reload and rebuild of the shader program */
+    double total_ms   = 0.0; /**< From the write of the file to the presented frame */
+};
+
+enum class ShaderManagerMode : uint8_t {
+    INTERACTIVE, /**< Restores the last session and records the history */
+    HEADLESS     /**< Starts empty and writes nothing of the user's session */
+};
 
 struct ShaderManager {
-    explicit ShaderManager() noexcept;
+    static constexpr std::chrono::milliseconds DEFAULT_RECOMPILE_DELAY { 150 };
+    static constexpr std::chrono::seconds      DEFAULT_AUTOSAVE_INTERVAL { 5 };
+    static constexpr std::string_view          AUTOSAVE_PATH = "shaders/latest_fragment.glsl";
+
+    /**
+     * @remark The interactive mode loads the last fragment shader, enables the saved buffers and
+     * builds them. The headless mode builds nothing until a fragment shader is loaded, restores
+     * no buffers and keeps no history, so a render depends only on its command line.
+     */
+    explicit ShaderManager(ShaderManagerMode mode_ = ShaderManagerMode::INTERACTIVE) noexcept;
     ~ShaderManager();
 
     Shader&        GetVertexShader() noexcept;
     Shader&        GetFragmentShader() noexcept;
     ShaderProgram& GetShaderProgram() noexcept;
 
+    /**
+     * @brief Returns the number which changes every time the shader program is replaced, used to
+     * know when the uniform handles must be resolved again
+     */
+    uint64_t GetShaderProgramGeneration() const noexcept;
+
+    const ShaderProgramStats& GetStats() const noexcept;
+
+    /**
+     * @brief Returns the counters of the recompile scheduling, including the background worker
+     */
+    RecompileStats GetRecompileStats() const noexcept;
+
+    /**
+     * @brief Sets the time without edits after which the edited code is compiled
+     */
+    void SetRecompileDelay(std::chrono::milliseconds delay_) noexcept;
+
+    std::chrono::milliseconds GetRecompileDelay() const noexcept;
+
+    /**
+     * @brief Enables the builtin uniform block (GLSLLiveBuiltins), which is injected into both
+     * shaders on the next rebuild, see InjectBuiltinUniformBlock()
+     *
+     * @remark With the block enabled the builtins are uploaded by BuiltinUniformBuffer instead of
+     * the loose uniforms
+     */
+    void SetBuiltinBlockEnabled(bool is_enabled_) noexcept;
+
+    bool IsBuiltinBlockEnabled() const noexcept;
+
+    /**
+     * @brief Rebuilds the shader program if the vertex or fragment code changed since the last
+     * link, otherwise keeps the current program
+     *
+     * @remark If the new code fails to compile or link, the last good program stays in use
+     *
+     * @return true if the shader program or a buffer program was replaced, false otherwise
+     */
+    bool UpdateShaderProgram() noexcept;
+
+    /**
+     * @brief Moves compilation of the edited code to a background worker, UpdateShaderProgram()
+     * then only submits snapshots and swaps in finished programs
+     *
+     * @param window_ Main window, the worker context shares objects with its context
+     *
+     * @return true if the worker was started, false if compilation stays synchronous
+     */
+    bool EnableAsyncCompilation(GLFWwindow* window_) noexcept;
+
+    /**
+     * @brief Watches the vertex and fragment shader files and their includes and reloads them when
+     * they are changed by another program, the changes are applied by UpdateShaderProgram()
+     */
+    void EnableHotReload() noexcept;
+
+    /**
+     * @brief Must be called after the frame is presented, finishes the latency measurement of a
+     * hot reload
+     */
+    void OnFramePresented() noexcept;
+
+    /**
+     * @brief Returns the latency of the last hot reload
+     */
+    const HotReloadLatency& GetLastHotReloadLatency() const noexcept;
 
+    /**
+     * @brief Saves the fragment code to the path every autosave interval, cheap to call every
+     * frame, unchanged code is not written again
+     */
+    void UpdateAutosave() noexcept;
+
+    /**
+     * @brief Sets the time between autosaves, zero disables autosaving
+     */
+    void SetAutosaveInterval(std::chrono::seconds interval_) noexcept;
+
+    std::chrono::seconds GetAutosaveInterval() const noexcept;
+
+    AsyncFileWriterStats GetSaveStats() const noexcept;
+
+    /**
+     * @brief Queues a snapshot of the fragment code to be saved in the background
+     *
+     * @return true if the save was queued, the write errors are only logged
+     */
     bool SaveFragmentShaderToPath(std::string_view fragment_shader_path_);
     bool LoadFragmentShaderFromPath(std::string_view fragment_shader_path_);
 
+    /**
+     * @brief Returns the history of the successfully compiled fragment code
+     */
+    ShaderHistory& GetHistory() noexcept;
+
+    /**
+     * @brief Replaces the fragment code with the revision from the history and builds it, from
+     * the program cache if the revision was linked before
+     *
+     * @remark Revisions loaded from the history are not recorded again until they are edited
+     */
+    bool LoadFragmentShaderFromHistory(size_t revision_);
+    bool LoadVertexShaderFromPath(std::string_view vertex_shader_path_);
+
+    /**
+     * @brief Returns the code of the buffer pass (Buffer A to D), edited like the fragment code
+     */
+    Shader& GetBufferShader(size_t index_) noexcept;
+
+    /**
+     * @brief Returns the program of the buffer pass, nullptr if it is disabled or not linked yet
+     */
+    ShaderProgram* GetBufferProgram(size_t index_) noexcept;
+
+    /**
+     * @brief Returns the number which changes every time the program of the buffer is replaced
+     */
+    uint64_t GetBufferProgramGeneration(size_t index_) const noexcept;
+
+    std::string_view GetBufferPath(size_t index_) const noexcept;
+
+    /**
+     * @brief Enables the buffer pass, a buffer without code starts from a template which reads
+     * its own previous frame
+     *
+     * @remark Buffers whose file exists are enabled on start, the programs are built by
+     * UpdateShaderProgram() on the render thread
+     */
+    void SetBufferEnabled(size_t index_, bool is_enabled_) noexcept;
+
+    /**
+     * @brief Enables the buffers whose file exists in shaders/buffers and builds their programs,
+     * done on construction in the interactive mode
+     */
+    void LoadSavedBuffers() noexcept;
+
+    bool IsBufferEnabled(size_t index_) const noexcept;
+
+    /**
+     * @brief Queues snapshots of the enabled buffer codes to be saved to their files
+     */
+    void SaveBufferShaders() noexcept;
+
 private:
 
+    /**
+     * @brief Compiles the dirty shaders and links them into a new shader program
+     *
+     * @return true if the shader program was replaced, false otherwise
+     */
+    bool RebuildShaderProgram() noexcept;
+
+    /**
+     * @brief Compiles the enabled buffers whose code or vertex code changed since the last link
+     *
+     * @return true if a buffer program was replaced, false otherwise
+     */
+    bool RebuildBufferPrograms() noexcept;
+
+    /**
+     * @brief Compiles the buffer and links it with the vertex shader into its program
+     *
+     * @return true if the program of the buffer was replaced, false otherwise
+     */
+    bool RebuildBufferProgram(size_t index_) noexcept;
+
+    /**
+     * @brief Links the sources into the program, or loads it from the program cache if they were
+     * linked before
+     *
+     * @remark The vertex shader is shared by the image and the buffers
+     *
+     * @return true if the program was replaced, false otherwise
+     */
+    bool LinkProgram(Shader&                   fragment_shader_,
+                     const PreprocessedSource& fragment_preprocessed_,
+                     const std::string&        vertex_source_,
+                     const std::string&        fragment_source_,
+                     ShaderProgram&            program_) noexcept;
+
+    /**
+     * @brief Returns the source which is really compiled from the code of the shader
+     *
+     * @remark The includes are expanded and the #version is lowered to the one of the context,
+     * see LimitGLSLVersion()
+     */
+    std::string GetCompileSource(ShaderType type_);
+
+    /**
+     * @brief Submits the snapshot of the current code to the background worker
+     */
+    void SubmitCompileRequest() noexcept;
+
+    /**
+     * @brief Applies the result of the background compilation
+     *
+     * @return true if the shader program was replaced, false otherwise
+     */
+    bool ApplyCompileResult(CompileResult& result_) noexcept;
+
+    /**
+     * @brief Reloads the shader files changed by another program
+     */
+    void ApplyFileChanges() noexcept;
+
+    /**
+     * @brief Passes the files of the current shaders to the file watcher
+     */
+    void UpdateWatchedFiles() noexcept;
+
+    /**
+     * @brief Appends the fragment code which was just built into a program to the history
+     */
+    void RecordHistory(std::string_view fragment_code_) noexcept;
+
+private:
+
+    static constexpr std::string_view VERTEX_ROOT_ID   = "vertex";
+    static constexpr std::string_view FRAGMENT_ROOT_ID = "fragment";
+
+    static constexpr std::array<std::string_view, BUFFER_PASS_COUNT> BUFFER_ROOT_IDS = {
+        "buffer_a", "buffer_b", "buffer_c", "buffer_d"
+    };
+
+    static constexpr std::array<std::string_view, BUFFER_PASS_COUNT> BUFFER_PATHS = {
+        "shaders/buffers/buffer_a.glsl",
+        "shaders/buffers/buffer_b.glsl",
+        "shaders/buffers/buffer_c.glsl",
+        "shaders/buffers/buffer_d.glsl"
+    };
+
+    /**
+     * @brief Code of a shader with the includes expanded, reused until the code or an include
+     * changes
+     */
+    struct PreprocessedShader {
+        uint64_t           code_hash         = 0;     /**< Hash of the preprocessed code */
+        bool               is_stale          = true;  /**< Flag indicating if an include changed */
+        bool               is_version_logged = false; /**< The lowered #version was logged */
+        PreprocessedSource result;
+    };
+
+    /**
+     * @brief Fragment shader of a buffer pass, linked with the shared vertex shader
+     */
+    struct BufferShader {
+        Shader             shader;
+        ShaderProgram      program;
+        PreprocessedShader preprocessed;
+        uint64_t           linked_hash = 0;     /**< Vertex and buffer code of the last link */
+        uint64_t           generation  = 0;     /**< Incremented when the program is replaced */
+        bool               is_enabled  = false;
+    };
+
+    /**
+     * @brief Returns the source which is really compiled from the code of the shader
+     */
+    std::string GetCompileSource(const Shader&       shader_,
+                                 PreprocessedShader& preprocessed_,
+                                 std::string_view    root_id_,
+                                 std::string_view    path_);
+
+    /**
+     * @brief Returns the hash the buffer is linked for, changes with the vertex and buffer code
+     */
+    uint64_t GetBufferLinkHash(size_t index_) const noexcept;
+
+    /**
+     * @brief Hot reload whose first frame was not presented yet
+     */
+    struct PendingHotReload {
+        std::string                           path;
+        std::chrono::system_clock::time_point save_time;
+        std::chrono::system_clock::time_point detect_time;
+        double                                compile_ms = 0.0;
+    };
+
     Shader vertex_shader;
     Shader fragment_shader;
 
     ShaderProgram shader_program;
+    uint64_t      shader_program_generation = 0; /**< Incremented when the program is replaced */
+
+    ProgramBinaryCache program_cache; /**< Linked programs of the previous runs and edits */
+
+    uint64_t linked_vertex_hash   = 0; /**< Vertex code hash used for the last link attempt */
+    uint64_t linked_fragment_hash = 0; /**< Fragment code hash used for the last link attempt */
+
+    std::unique_ptr<CompileService> compile_service; /**< Background compiler, null if sync */
+    uint64_t submitted_revision = 0; /**< Revision of the last submitted or synchronous build */
+    uint64_t applied_revision   = 0; /**< Older results than this are outdated and dropped */
+
+    RecompileScheduler recompile_scheduler; /**< Debounces the compiles while the user types */
+
+    bool is_builtin_block_enabled = false; /**< Flag indicating if the builtins come from a block */
+
+    int32_t supported_glsl_version; /**< Newer #version directives are lowered to this one */
+
+    ShaderPreprocessor preprocessor;          /**< Expands #include "..." relative to shaders/ */
+    PreprocessedShader preprocessed_vertex;   /**< Vertex code with the includes expanded */
+    PreprocessedShader preprocessed_fragment; /**< Fragment code with the includes expanded */
+
+    std::array<BufferShader, BUFFER_PASS_COUNT> buffer_shaders; /**< Buffer A to D passes */
+
+    std::string vertex_shader_path;   /**< File of the vertex shader, relative to the application */
+    std::string fragment_shader_path; /**< File of the fragment shader, empty if unknown */
+
+    std::unique_ptr<ShaderFileWatcher> file_watcher;        /**< Null if hot reload is disabled */
+    std::optional<PendingHotReload>    pending_reload;      /**< Reload waiting for its frame */
+    HotReloadLatency                   last_reload_latency; /**< Latency of the last hot reload */
+
+    AsyncFileWriter                       file_writer;       /**< Saves off the render thread */
+    std::chrono::seconds                  autosave_interval; /**< Zero if autosave is disabled */
+    std::chrono::steady_clock::time_point last_autosave_time;
+
+    ShaderHistory history;             /**< Compiled revisions of the fragment code */
+    uint64_t      history_loaded_hash; /**< Hash of the revision loaded from the history */
+
+    /**
+     * @brief Fragment code of the background builds in flight by revision, recorded in the
+     * history if the build succeeds
+     */
+    std::map<uint64_t, std::string> submitted_fragment_code;
+
+    ShaderProgramStats stats;
 };
\ No newline at end of file
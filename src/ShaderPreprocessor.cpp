@@ -0,0 +1,344 @@
+#include "ShaderPreprocessor.h"
+#include "Utils.h"
+
+namespace {
+
+/**
+ * @brief Returns the directive of the line (e.g. "include") and the rest of the line after it
+ */
+std::pair<std::string_view, std::string_view> GetDirective(std::string_view line_)
+{
+    const size_t hash = line_.find_first_not_of(" \t");
+    if (hash == std::string_view::npos || line_[hash] != '#') { return {}; }
+
+    const size_t name_start = line_.find_first_not_of(" \t", hash + 1);
+    if (name_start == std::string_view::npos) { return {}; }
+
+    size_t name_end = name_start;
+    while (name_end < line_.size() && std::isalpha(static_cast<unsigned char>(line_[name_end])))
+    {
+        ++name_end;
+    }
+
+    return { line_.substr(name_start, name_end - name_start), line_.substr(name_end) };
+}
+
+/**
+ * @brief Returns the path of an #include "path" directive or an empty view
+ */
+std::string_view GetIncludePath(std::string_view arguments_)
+{
+    const size_t open = arguments_.find_first_not_of(" \t");
+    if (open == std::string_view::npos || arguments_[open] != '"') { return {}; }
+
+    const size_t close = arguments_.find('"', open + 1);
+    if (close == std::string_view::npos) { return {}; }
+
+    return arguments_.substr(open + 1, close - open - 1);
+}
+
+bool IsPragmaOnce(std::string_view arguments_)
+{
+    const size_t start = arguments_.find_first_not_of(" \t");
+    if (start == std::string_view::npos || arguments_.compare(start, 4, "once") != 0)
+    {
+        return false;
+    }
+
+    const size_t end = arguments_.find_first_not_of(" \t\r\n", start + 4);
+    return end == std::string_view::npos || arguments_.compare(end, 2, "//") == 0;
+}
+
+}  // namespace
+
+std::string SourceLineMap::Remap(std::string_view log_) const
+{
+    std::string result;
+    result.reserve(log_.size() + 256);
+
+    for (size_t start = 0; start < log_.size();)
+    {
+        const size_t     end  = std::min(log_.find('\n', start), log_.size());
+        std::string_view line = log_.substr(start, end - start);
+        start                 = end + 1;
+
+        // Mesa "0:12(5): error", NVIDIA "0(12) : error", AMD and Intel "ERROR: 0:12: ..."
+        size_t location = 0;
+        for (std::string_view prefix : { "ERROR: ", "WARNING: " })
+        {
+            if (line.substr(0, prefix.size()) == prefix) { location = prefix.size(); }
+        }
+
+        const bool   is_paren     = line.substr(location, 2) == "0(";
+        const size_t number_start = location + 2;
+        size_t       number_end   = number_start;
+        while (number_end < line.size()
+               && std::isdigit(static_cast<unsigned char>(line[number_end])))
+        {
+            ++number_end;
+        }
+
+        const bool is_closed   = number_end < line.size() && line[number_end] == ')';
+        const bool is_location = (is_paren ? is_closed : line.substr(location, 2) == "0:")
+                              && number_end > number_start;
+
+        uint32_t output_line = 0;
+        if (is_location)
+        {
+            std::from_chars(line.data() + number_start, line.data() + number_end, output_line);
+        }
+
+        if (!is_location || output_line == 0 || output_line > lines.size())
+        {
+            result.append(line);
+        }
+        else
+        {
+            const auto& origin = lines[output_line - 1];
+
+            result.append(line.substr(0, location));
+            result.append(fmt::format("{}:{}", files[origin.file], origin.line));
+            result.append(line.substr(number_end + (is_paren ? 1 : 0)));
+        }
+
+        if (end < log_.size()) { result.push_back('\n'); }
+    }
+
+    return result;
+}
+
+ShaderPreprocessor::ShaderPreprocessor(std::string_view include_directory_) noexcept :
+    include_directory(include_directory_),
+    application_path(GetApplicationPath())
+{
+}
+
+PreprocessedSource ShaderPreprocessor::Process(std::string_view root_id_,
+                                               std::string_view root_name_,
+                                               std::string_view code_)
+{
+    ExpandContext context;
+    context.source.reserve(code_.size());
+    context.line_map.files.emplace_back(root_name_);
+
+    const ParsedFile root = Parse(std::string(code_));
+    Expand(root, 0, context);
+
+    // Dependency graph, the edges of the previous run of this shader are replaced
+    const std::string root_id(root_id_);
+
+    for (const auto& file_path : root_includes[root_id]) { dependents[file_path].erase(root_id); }
+    for (const auto& file_path : context.includes) { dependents[file_path].insert(root_id); }
+
+    root_includes[root_id] = context.includes;
+
+    PreprocessedSource result;
+    result.source   = std::move(context.source);
+    result.line_map = std::make_shared<const SourceLineMap>(std::move(context.line_map));
+    result.includes = std::move(context.includes);
+    result.is_good  = context.is_good;
+
+    return result;
+}
+
+std::vector<std::string> ShaderPreprocessor::GetDependents(std::string_view file_path_) const
+{
+    auto it = dependents.find(std::string(file_path_));
+    if (it == dependents.end()) { return {}; }
+
+    return std::vector<std::string>(it->second.begin(), it->second.end());
+}
+
+std::vector<std::string> ShaderPreprocessor::GetIncludes(std::string_view root_id_) const
+{
+    auto it = root_includes.find(std::string(root_id_));
+    if (it == root_includes.end()) { return {}; }
+
+    return it->second;
+}
+
+void ShaderPreprocessor::Invalidate(std::string_view file_path_) noexcept
+{
+    cache.erase(std::string(file_path_));
+}
+
+ShaderPreprocessor::ParsedFile ShaderPreprocessor::Parse(std::string text_)
+{
+    ParsedFile file;
+    file.text = std::move(text_);
+
+    const std::string_view text = file.text;
+
+    uint32_t line_number = 1;
+
+    for (size_t start = 0; start < text.size(); ++line_number)
+    {
+        const size_t line_break = text.find('\n', start);
+        const size_t end = line_break == std::string_view::npos ? text.size() : line_break + 1;
+
+        const auto [directive, arguments] = GetDirective(text.substr(start, end - start));
+
+        Chunk chunk;
+        chunk.begin      = start;
+        chunk.end        = end;
+        chunk.first_line = line_number;
+        chunk.line_count = 1;
+
+        if (directive == "include" && !GetIncludePath(arguments).empty())
+        {
+            chunk.kind    = Chunk::Kind::INCLUDE;
+            chunk.include = GetIncludePath(arguments);
+        }
+        else if (directive == "pragma" && IsPragmaOnce(arguments))
+        {
+            chunk.kind          = Chunk::Kind::BLANK;
+            file.is_pragma_once = true;
+        }
+
+        // Consecutive lines without directives are copied as one chunk
+        if (chunk.kind == Chunk::Kind::TEXT && !file.chunks.empty()
+            && file.chunks.back().kind == Chunk::Kind::TEXT)
+        {
+            file.chunks.back().end = end;
+            ++file.chunks.back().line_count;
+        }
+        else
+        {
+            file.chunks.push_back(std::move(chunk));
+        }
+
+        start = end;
+    }
+
+    return file;
+}
+
+const ShaderPreprocessor::ParsedFile* ShaderPreprocessor::Load(const std::string& file_path_)
+{
+    const auto full_path = application_path + "/" + file_path_;
+
+    std::error_code error;
+    const auto      write_time = std::filesystem::last_write_time(full_path, error);
+    const auto      size       = error ? 0 : std::filesystem::file_size(full_path, error);
+
+    if (error)
+    {
+        cache.erase(file_path_);
+        return nullptr;
+    }
+
+    auto it = cache.find(file_path_);
+    if (it != cache.end() && it->second.write_time == write_time && it->second.size == size)
+    {
+        return &it->second;
+    }
+
+    const FileView file(file_path_);
+    if (!file.IsOpen()) { return nullptr; }
+
+    auto parsed       = Parse(std::string(file.GetText()));
+    parsed.write_time = write_time;
+    parsed.size       = size;
+
+    // References to the other entries stay valid, the map never moves its elements
+    return &(cache[file_path_] = std::move(parsed));
+}
+
+void ShaderPreprocessor::Expand(const ParsedFile& file_,
+                                uint32_t          file_index_,
+                                ExpandContext&    context_)
+{
+    const std::string_view text = file_.text;
+
+    for (const auto& chunk : file_.chunks)
+    {
+        if (chunk.kind == Chunk::Kind::TEXT)
+        {
+            context_.source.append(text.substr(chunk.begin, chunk.end - chunk.begin));
+            if (context_.source.back() != '\n') { context_.source.push_back('\n'); }
+
+            for (uint32_t i = 0; i < chunk.line_count; ++i)
+            {
+                context_.line_map.lines.push_back({ file_index_, chunk.first_line + i });
+            }
+            continue;
+        }
+
+        if (chunk.kind == Chunk::Kind::BLANK)
+        {
+            context_.source.push_back('\n');
+            context_.line_map.lines.push_back({ file_index_, chunk.first_line });
+            continue;
+        }
+
+        const auto include_path =
+            (std::filesystem::path(include_directory) / chunk.include).lexically_normal();
+        const auto file_path = include_path.generic_string();
+
+        if (context_.stack.size() >= MAX_INCLUDE_DEPTH)
+        {
+            AppendError(context_, file_index_, chunk.first_line, "includes are nested too deep");
+            continue;
+        }
+
+        if (std::find(context_.stack.begin(), context_.stack.end(), file_path)
+            != context_.stack.end())
+        {
+            AppendError(context_,
+                        file_index_,
+                        chunk.first_line,
+                        fmt::format("include cycle at \"{}\"", chunk.include));
+            continue;
+        }
+
+        if (context_.expanded.contains(file_path))  // #pragma once
+        {
+            context_.source.push_back('\n');
+            context_.line_map.lines.push_back({ file_index_, chunk.first_line });
+            continue;
+        }
+
+        const ParsedFile* included = Load(file_path);
+        if (!included)
+        {
+            AppendError(context_,
+                        file_index_,
+                        chunk.first_line,
+                        fmt::format("can not open include \"{}\"", file_path));
+            continue;
+        }
+
+        if (std::find(context_.includes.begin(), context_.includes.end(), file_path)
+            == context_.includes.end())
+        {
+            context_.includes.push_back(file_path);
+        }
+
+        if (included->is_pragma_once) { context_.expanded.insert(file_path); }
+
+        // An empty file still takes the place of the include line
+        if (included->chunks.empty())
+        {
+            context_.source.push_back('\n');
+            context_.line_map.lines.push_back({ file_index_, chunk.first_line });
+            continue;
+        }
+
+        const auto included_index = static_cast<uint32_t>(context_.line_map.files.size());
+        context_.line_map.files.push_back(file_path);
+
+        context_.stack.push_back(file_path);
+        Expand(*included, included_index, context_);
+        context_.stack.pop_back();
+    }
+}
+
+void ShaderPreprocessor::AppendError(ExpandContext&     context_,
+                                     uint32_t           file_index_,
+                                     uint32_t           line_,
+                                     const std::string& message_)
+{
+    context_.source.append(fmt::format("#error {}\n", message_));
+    context_.line_map.lines.push_back({ file_index_, line_ });
+    context_.is_good = false;
+}
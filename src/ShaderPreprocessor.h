@@ -0,0 +1,150 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Origin of every line of a preprocessed shader, used to point compilation errors at the
+ * file and line the user wrote
+ */
+struct SourceLineMap {
+    struct Origin {
+        uint32_t file = 0; /**< Index into files */
+        uint32_t line = 0; /**< Line in the file, starting from 1 */
+    };
+
+    std::vector<std::string> files; /**< Names of the files, the shader itself is the first one */
+    std::vector<Origin>      lines; /**< Origin of the output line N at index N - 1 */
+
+    /**
+     * @brief Replaces the "0:LINE" and "0(LINE)" locations of a driver log with "FILE:LINE"
+     *
+     * @param log_ Compilation log of the preprocessed source
+     *
+     * @return Log with the original locations, lines which can not be mapped are unchanged
+     */
+    std::string Remap(std::string_view log_) const;
+};
+
+/**
+ * @brief Shader code with the includes expanded
+ */
+struct PreprocessedSource {
+    std::string                          source;         /**< Code which should be compiled */
+    std::shared_ptr<const SourceLineMap> line_map;       /**< Origins of the source lines */
+    std::vector<std::string>             includes;       /**< Included files, relative to app */
+    bool                                 is_good = true; /**< false if an include failed */
+};
+
+/**
+ * @brief Expands #include "..." directives in shader code, so shaders can share libraries
+ *
+ * @remark Includes are resolved relative to the include directory. Every file is parsed into
+ * chunks once and cached by its path, modification time and size. Files with #pragma once are
+ * expanded only once per shader, include cycles and missing files are turned into #error
+ * directives at the include line, so the driver reports them like any other compilation error.
+ */
+struct ShaderPreprocessor {
+    static constexpr size_t MAX_INCLUDE_DEPTH = 32;
+
+    /**
+     * @param include_directory_ Directory of the included files, relative to the application
+     */
+    explicit ShaderPreprocessor(std::string_view include_directory_) noexcept;
+
+    ShaderPreprocessor(const ShaderPreprocessor&)             = delete;
+    ShaderPreprocessor& operator= (const ShaderPreprocessor&) = delete;
+
+    /**
+     * @brief Expands the includes of the code and records them in the dependency graph
+     *
+     * @param root_id_ Stable name of the shader in the dependency graph, e.g. "fragment"
+     * @param root_name_ Name of the shader shown in the compilation errors, e.g. its file path
+     * @param code_ Code of the shader
+     */
+    PreprocessedSource Process(std::string_view root_id_,
+                               std::string_view root_name_,
+                               std::string_view code_);
+
+    /**
+     * @brief Returns the shaders which included the file the last time they were processed
+     *
+     * @param file_path_ Path relative to the application directory
+     */
+    std::vector<std::string> GetDependents(std::string_view file_path_) const;
+
+    /**
+     * @brief Returns the files the shader included the last time it was processed
+     */
+    std::vector<std::string> GetIncludes(std::string_view root_id_) const;
+
+    /**
+     * @brief Drops the cached chunks of the file, so it is read again on the next use
+     */
+    void Invalidate(std::string_view file_path_) noexcept;
+
+private:
+
+    /**
+     * @brief Part of a file, either lines copied as they are or a directive
+     */
+    struct Chunk {
+        enum class Kind {
+            TEXT,    /**< Lines without directives, copied as they are */
+            INCLUDE, /**< #include "...", replaced by the included file */
+            BLANK    /**< #pragma once, replaced by an empty line */
+        };
+
+        Kind        kind       = Kind::TEXT;
+        size_t      begin      = 0; /**< Offset of the first character in the text */
+        size_t      end        = 0; /**< Offset past the last line break */
+        uint32_t    first_line = 1; /**< Line of the first character, starting from 1 */
+        uint32_t    line_count = 0;
+        std::string include;        /**< Included path as written, only for INCLUDE */
+    };
+
+    struct ParsedFile {
+        std::string                     text;
+        std::vector<Chunk>              chunks;
+        bool                            is_pragma_once = false;
+        std::filesystem::file_time_type write_time;
+        uintmax_t                       size = 0;
+    };
+
+    struct ExpandContext {
+        std::string                     source;
+        SourceLineMap                   line_map;
+        std::vector<std::string>        stack;    /**< Files being expanded, for cycle checks */
+        std::unordered_set<std::string> expanded; /**< Files with #pragma once already expanded */
+        std::vector<std::string>        includes;
+        bool                            is_good = true;
+    };
+
+    static ParsedFile Parse(std::string text_);
+
+    /**
+     * @brief Returns the parsed file from the cache, reads it again if it changed on disk
+     *
+     * @return The file or nullptr if it can not be read
+     */
+    const ParsedFile* Load(const std::string& file_path_);
+
+    void Expand(const ParsedFile& file_, uint32_t file_index_, ExpandContext& context_);
+
+    /**
+     * @brief Appends an #error directive in place of the include line
+     */
+    static void AppendError(ExpandContext&     context_,
+                            uint32_t           file_index_,
+                            uint32_t           line_,
+                            const std::string& message_);
+
+private:
+    std::string include_directory; /**< Directory of the includes, relative to the application */
+    std::string application_path;
+
+    std::unordered_map<std::string, ParsedFile> cache; /**< Parsed files by relative path */
+
+    // Dependency graph, shader to the files it includes and file to the shaders including it
+    std::unordered_map<std::string, std::vector<std::string>> root_includes;
+    std::unordered_map<std::string, std::set<std::string>>    dependents;
+};
@@ -1,5 +1,7 @@
 #include "ShaderProgram.h"
 
+#include "Utils.h"
+
 ShaderProgram::ShaderProgram() noexcept : id(0) {}
 
 ShaderProgram::ShaderProgram(Shader& vertex_, Shader& fragment_) noexcept : id(0)
@@ -8,6 +10,9 @@ ShaderProgram::ShaderProgram(Shader& vertex_, Shader& fragment_) noexcept : id(0
 
     if (id != 0)
     {
+        // Allows to cache the binary of the linked program
+        glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
         AttachShader(vertex_);
         AttachShader(fragment_);
 
@@ -19,10 +24,31 @@ ShaderProgram::ShaderProgram(Shader& vertex_, Shader& fragment_) noexcept : id(0
     }
 }
 
+ShaderProgram::ShaderProgram(GLenum binary_format_, const void* binary_, GLsizei length_) noexcept :
+    id(0)
+{
+    id = glCreateProgram();
+
+    if (id != 0)
+    {
+        glProgramBinary(id, binary_format_, binary_, length_);
+
+        GLint success;
+        glGetProgramiv(id, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(id);
+            id = 0;
+        }
+        else { IntrospectUniforms(); }
+    }
+}
+
 ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept
 {
     id               = other.id;
     attached_shaders = std::move(other.attached_shaders);
+    uniforms         = std::move(other.uniforms);
     other.id         = 0;
 }
 
@@ -34,6 +60,7 @@ ShaderProgram& ShaderProgram::operator= (ShaderProgram&& other) noexcept
 
         id               = other.id;
         attached_shaders = std::move(other.attached_shaders);
+        uniforms         = std::move(other.uniforms);
         other.id         = 0;
     }
     return *this;
@@ -64,9 +91,55 @@ bool ShaderProgram::Link() noexcept
         LOG_WARN("Shader program {} linking error: {}", id, info_log);
         return false;
     }
+
+    IntrospectUniforms();
     return true;
 }
 
+void ShaderProgram::IntrospectUniforms() noexcept
+{
+    uniforms.clear();
+
+    GLint uniforms_count  = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniforms_count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    std::string name(static_cast<size_t>(std::max(max_name_length, 1)), '\0');
+
+    for (GLint i = 0; i < uniforms_count; ++i)
+    {
+        GLsizei name_length = 0;
+        GLint   size        = 0;
+        GLenum  type        = 0;
+        glGetActiveUniform(id,
+                           static_cast<GLuint>(i),
+                           static_cast<GLsizei>(name.size()),
+                           &name_length,
+                           &size,
+                           &type,
+                           name.data());
+
+        std::string uniform_name(name.data(), static_cast<size_t>(name_length));
+
+        const GLint location = glGetUniformLocation(id, uniform_name.c_str());
+
+        if (location < 0) { continue; }  // Member of a uniform block, not set by location
+
+        // Arrays are reported as "name[0]", but are set by the base name
+        const bool is_array = uniform_name.ends_with("[0]");
+        if (is_array) { uniform_name.resize(uniform_name.size() - 3); }
+
+        const uint64_t name_hash = HashText(uniform_name);
+        uniforms.push_back(
+            UniformInfo { name_hash, std::move(uniform_name), location, type, size, is_array });
+    }
+
+    std::sort(uniforms.begin(),
+              uniforms.end(),
+              [](const UniformInfo& a, const UniformInfo& b) { return a.name_hash < b.name_hash; });
+}
+
 void ShaderProgram::DeleteProgram() noexcept
 {
     if (id) { glDeleteProgram(id); }
@@ -75,102 +148,228 @@ void ShaderProgram::DeleteProgram() noexcept
     {
         glDetachShader(id, shader_id);  // Detach shaders if needed
     }
+
+    uniforms.clear();
 }
 
 GLuint ShaderProgram::GetID() const noexcept { return id; }
 
+bool ShaderProgram::GetBinary(GLenum& binary_format_, std::vector<char>& binary_) const noexcept
+{
+    if (id == 0) { return false; }
+
+    GLint length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0) { return false; }
+
+    binary_.resize(static_cast<size_t>(length));
+
+    GLsizei written = 0;
+    glGetProgramBinary(id, length, &written, &binary_format_, binary_.data());
+    binary_.resize(static_cast<size_t>(written));
+
+    return written > 0;
+}
+
+UniformHandle ShaderProgram::GetUniformHandle(std::string_view name_) const noexcept
+{
+    const UniformInfo* uniform = FindUniform(name_);
+    if (uniform) { return UniformHandle { uniform->location }; }
+
+    // "name[i]" of an array, the elements follow the location of the array
+    const size_t bracket = name_.rfind('[');
+    if (bracket == std::string_view::npos || !name_.ends_with(']')) { return UniformHandle { -1 }; }
+
+    const auto index_text = name_.substr(bracket + 1, name_.size() - bracket - 2);
+
+    GLint index = 0;
+    const auto [end, error] =
+        std::from_chars(index_text.data(), index_text.data() + index_text.size(), index);
+    if (error != std::errc() || end != index_text.data() + index_text.size() || index < 0)
+    {
+        return UniformHandle { -1 };
+    }
+
+    const UniformInfo* array = FindUniform(name_.substr(0, bracket));
+    if (!array || !array->is_array || index >= array->size) { return UniformHandle { -1 }; }
+
+    return UniformHandle { array->location + index };
+}
+
+const UniformInfo* ShaderProgram::FindUniform(std::string_view name_) const noexcept
+{
+    const uint64_t name_hash = HashText(name_);
+
+    auto it = std::lower_bound(uniforms.begin(),
+                               uniforms.end(),
+                               name_hash,
+                               [](const UniformInfo& uniform, uint64_t hash)
+                               { return uniform.name_hash < hash; });
+
+    for (; it != uniforms.end() && it->name_hash == name_hash; ++it)
+    {
+        if (it->name == name_) { return &*it; }
+    }
+
+    return nullptr;
+}
+
+const std::vector<UniformInfo>& ShaderProgram::GetUniforms() const noexcept { return uniforms; }
+
 void ShaderProgram::SetUniform(std::string_view name, const bool& value) const
 {
-    glUniform1i(glGetUniformLocation(id, name.data()), (int)value);
+    SetUniform(GetUniformHandle(name), value);
 }
 
 void ShaderProgram::SetUniform(std::string_view name, const int& value) const
 {
-    glUniform1i(glGetUniformLocation(id, name.data()), value);
+    SetUniform(GetUniformHandle(name), value);
 }
 
 void ShaderProgram::SetUniform(std::string_view name, const float& value) const
 {
-    glUniform1f(glGetUniformLocation(id, name.data()), value);
-
-    // TODO Correct way? should i use it? maybe not cause we know what name we are looking for
-    // GLint location = glGetUniformLocation(program_id, name.data());
-    // if (location != -1) { glUniform1f(location, value); }
+    SetUniform(GetUniformHandle(name), value);
 }
 
 void ShaderProgram::SetUniform(std::string_view name, const glm::vec2& value) const
 {
-    glUniform2fv(glGetUniformLocation(id, name.data()), 1, glm::value_ptr(value));
+    SetUniform(GetUniformHandle(name), value);
 }
 
 void ShaderProgram::SetUniform(std::string_view name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(id, name.data()), 1, glm::value_ptr(value));
+    SetUniform(GetUniformHandle(name), value);
 }
 
 void ShaderProgram::SetUniform(std::string_view name, const glm::vec4& value) const
 {
-    glUniform4fv(glGetUniformLocation(id, name.data()), 1, glm::value_ptr(value));
+    SetUniform(GetUniformHandle(name), value);
 }
 
 void ShaderProgram::SetUniform(std::string_view name_, const glm::mat2& value_) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(id, name_.data()), 1, GL_FALSE, &value_[0][0]);
+    SetUniform(GetUniformHandle(name_), value_);
 }
 
 void ShaderProgram::SetUniform(std::string_view name_, const glm::mat3& value_) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(id, name_.data()), 1, GL_FALSE, &value_[0][0]);
+    SetUniform(GetUniformHandle(name_), value_);
 }
 
 void ShaderProgram::SetUniform(std::string_view name_, const glm::mat4& value_) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(id, name_.data()), 1, GL_FALSE, &value_[0][0]);
+    SetUniform(GetUniformHandle(name_), value_);
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const bool& value) const
+{
+    if (handle_.IsValid()) { glProgramUniform1i(id, handle_.location, (int)value); }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const int& value) const
+{
+    if (handle_.IsValid()) { glProgramUniform1i(id, handle_.location, value); }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const float& value) const
+{
+    if (handle_.IsValid()) { glProgramUniform1f(id, handle_.location, value); }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const glm::vec2& value) const
+{
+    if (handle_.IsValid()) { glProgramUniform2fv(id, handle_.location, 1, glm::value_ptr(value)); }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const glm::vec3& value) const
+{
+    if (handle_.IsValid()) { glProgramUniform3fv(id, handle_.location, 1, glm::value_ptr(value)); }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const glm::vec4& value) const
+{
+    if (handle_.IsValid()) { glProgramUniform4fv(id, handle_.location, 1, glm::value_ptr(value)); }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const glm::mat2& value_) const
+{
+    if (handle_.IsValid())
+    {
+        glProgramUniformMatrix2fv(id, handle_.location, 1, GL_FALSE, &value_[0][0]);
+    }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const glm::mat3& value_) const
+{
+    if (handle_.IsValid())
+    {
+        glProgramUniformMatrix3fv(id, handle_.location, 1, GL_FALSE, &value_[0][0]);
+    }
+}
+
+void ShaderProgram::SetUniform(UniformHandle handle_, const glm::mat4& value_) const
+{
+    if (handle_.IsValid())
+    {
+        glProgramUniformMatrix4fv(id, handle_.location, 1, GL_FALSE, &value_[0][0]);
+    }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, bool& storage_) const
 {
+    const UniformHandle handle = GetUniformHandle(name);
+    if (!handle.IsValid()) { return; }
+
     int value;
-    glGetUniformiv(id, glGetUniformLocation(id, name.data()), &value);
+    glGetUniformiv(id, handle.location, &value);
     storage_ = value;
 }
 
 void ShaderProgram::GetUniform(std::string_view name, int& storage_) const
 {
-    glGetUniformiv(id, glGetUniformLocation(id, name.data()), &storage_);
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformiv(id, handle.location, &storage_); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, float& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), &storage_);
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, &storage_); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, glm::vec2& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), glm::value_ptr(storage_));
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, glm::value_ptr(storage_)); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, glm::vec3& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), glm::value_ptr(storage_));
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, glm::value_ptr(storage_)); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, glm::vec4& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), glm::value_ptr(storage_));
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, glm::value_ptr(storage_)); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, glm::mat2& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), &storage_[0][0]);
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, &storage_[0][0]); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, glm::mat3& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), &storage_[0][0]);
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, &storage_[0][0]); }
 }
 
 void ShaderProgram::GetUniform(std::string_view name, glm::mat4& storage_) const
 {
-    glGetUniformfv(id, glGetUniformLocation(id, name.data()), &storage_[0][0]);
+    const UniformHandle handle = GetUniformHandle(name);
+    if (handle.IsValid()) { glGetUniformfv(id, handle.location, &storage_[0][0]); }
 }
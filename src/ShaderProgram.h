@@ -10,10 +10,40 @@ concept AllowedUniformType =
     || std::is_same_v<T, glm::mat2> || std::is_same_v<T, glm::mat3> || std::is_same_v<T, glm::mat4>
     || std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, bool>;
 
+/**
+ * @brief Pre-resolved location of a uniform, avoids the name lookup in hot paths
+ *
+ * @remark Handles are valid only for the program which returned them
+ */
+struct UniformHandle {
+    GLint location = -1; /**< Location of the uniform, -1 if the program does not use it */
+
+    bool IsValid() const noexcept { return location >= 0; }
+};
+
+/**
+ * @brief Active uniform of the linked program
+ */
+struct UniformInfo {
+    uint64_t    name_hash; /**< Hash of the name, the table is sorted by it */
+    std::string name;      /**< Name without the "[0]" suffix of arrays */
+    GLint       location;  /**< Location of the uniform */
+    GLenum      type;      /**< GL type of the uniform (e.g. GL_FLOAT_VEC2) */
+    GLint       size;      /**< Number of the array elements, 1 for non-arrays */
+    bool        is_array;  /**< Flag indicating if the elements can be set as "name[i]" */
+};
+
 struct ShaderProgram {
     explicit ShaderProgram() noexcept;
     explicit ShaderProgram(Shader& vertex_, Shader& fragment_) noexcept;
 
+    /**
+     * @brief Creates the program from a binary previously returned by GetBinary()
+     *
+     * @remark ID is 0 if the driver rejected the binary (e.g. after a driver update)
+     */
+    explicit ShaderProgram(GLenum binary_format_, const void* binary_, GLsizei length_) noexcept;
+
     explicit ShaderProgram(const ShaderProgram&)    = delete;
     ShaderProgram& operator= (const ShaderProgram&) = delete;
 
@@ -26,6 +56,42 @@ struct ShaderProgram {
 
     GLuint GetID() const noexcept;
 
+    /**
+     * @brief Retrieves the linked program binary, so it can be cached and loaded later
+     *
+     * @param binary_format_ Driver specific format of the binary
+     * @param binary_ Storage for the binary
+     *
+     * @return true if the binary was retrieved, false otherwise
+     */
+    bool GetBinary(GLenum& binary_format_, std::vector<char>& binary_) const noexcept;
+
+    /**
+     * @brief Resolves the location of the uniform once, so it can be set without a lookup
+     *
+     * @remark An array element "name[i]" is found as the location of the array plus i, the
+     * elements of an array have consecutive locations
+     *
+     * @return Handle of the uniform, invalid if the program does not use it
+     */
+    UniformHandle GetUniformHandle(std::string_view name_) const noexcept;
+
+    /**
+     * @brief Returns the info of the active uniform or nullptr if the program does not use it
+     */
+    const UniformInfo* FindUniform(std::string_view name_) const noexcept;
+
+    /**
+     * @brief Returns all active uniforms of the program sorted by the name hash, an array is
+     * listed once by its base name
+     */
+    const std::vector<UniformInfo>& GetUniforms() const noexcept;
+
+    /**
+     * @brief Template function which sets the uniform value of the shader program.
+     *
+     * @remark Setting a uniform which the program does not use is a cheap no-op
+     */
     template<AllowedUniformType T>
     void SetUniform(std::string_view name, const T& value) const;
     // Specializations for basic types
@@ -40,6 +106,16 @@ struct ShaderProgram {
     void SetUniform(std::string_view name, const glm::mat2& value) const;
     void SetUniform(std::string_view name, const glm::mat3& value) const;
     void SetUniform(std::string_view name, const glm::mat4& value) const;
+    // Overloads for the pre-resolved handles
+    void SetUniform(UniformHandle handle_, const bool& value) const;
+    void SetUniform(UniformHandle handle_, const int& value) const;
+    void SetUniform(UniformHandle handle_, const float& value) const;
+    void SetUniform(UniformHandle handle_, const glm::vec2& value) const;
+    void SetUniform(UniformHandle handle_, const glm::vec3& value) const;
+    void SetUniform(UniformHandle handle_, const glm::vec4& value) const;
+    void SetUniform(UniformHandle handle_, const glm::mat2& value) const;
+    void SetUniform(UniformHandle handle_, const glm::mat3& value) const;
+    void SetUniform(UniformHandle handle_, const glm::mat4& value) const;
 
     /**
      * @brief Template function which gets the uniform value from the shader program.
@@ -69,9 +145,15 @@ private:
 
     bool Link() noexcept;
 
+    /**
+     * @brief Fills the uniform table of the linked program
+     */
+    void IntrospectUniforms() noexcept;
+
     void DeleteProgram() noexcept;
 
 private:
-    GLuint              id;               /**< The ID of the shader program. */
-    std::vector<GLuint> attached_shaders; /**< The list of attached shaders. */
+    GLuint                   id;               /**< The ID of the shader program. */
+    std::vector<GLuint>      attached_shaders; /**< The list of attached shaders. */
+    std::vector<UniformInfo> uniforms;         /**< Active uniforms, sorted by the name hash. */
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Lock-free bounded queue for handing values from one producer thread to one consumer
+ * thread
+ *
+ * @remark The head is written only by the consumer and the tail only by the producer, each on
+ * its own cache line. Both sides keep a cached copy of the other index and read the shared one
+ * only when the cached one says the queue is full or empty, so a push or a pop is usually a
+ * copy and one release store.
+ */
+template<typename T, size_t CAPACITY>
+struct SpscQueue {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "The capacity must be a power of two");
+
+    explicit SpscQueue() noexcept = default;
+
+    SpscQueue(const SpscQueue&)             = delete;
+    SpscQueue& operator= (const SpscQueue&) = delete;
+
+    /**
+     * @brief Appends the value, called only by the producer
+     *
+     * @return false if the queue is full and the value was not added, true otherwise
+     */
+    bool Push(const T& value_) noexcept
+    {
+        const size_t tail_index = tail.load(std::memory_order_relaxed);
+
+        if (tail_index - cached_head >= CAPACITY)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if (tail_index - cached_head >= CAPACITY) { return false; }
+        }
+
+        items[tail_index & (CAPACITY - 1)] = value_;
+        tail.store(tail_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest value, called only by the consumer
+     *
+     * @return false if the queue is empty, true otherwise
+     */
+    bool Pop(T& value_) noexcept
+    {
+        const size_t head_index = head.load(std::memory_order_relaxed);
+
+        if (head_index == cached_tail)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (head_index == cached_tail) { return false; }
+        }
+
+        value_ = items[head_index & (CAPACITY - 1)];
+        head.store(head_index + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head { 0 }; /**< Next value to pop */
+    size_t cached_tail = 0;                                  /**< Consumer copy of the tail */
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail { 0 }; /**< Next free item */
+    size_t cached_head = 0;                                  /**< Producer copy of the head */
+
+    alignas(CACHE_LINE_SIZE) std::array<T, CAPACITY> items {};
+};
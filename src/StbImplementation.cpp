@@ -0,0 +1,8 @@
+#include "PCH.h"
+
+// The declarations come from PCH.h, the second include compiles the implementation
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
@@ -0,0 +1,432 @@
+#include "TextureManager.h"
+
+#include "Utils.h"
+
+namespace {
+
+/**
+ * @brief Suffixes of the cubemap faces, in the order of the GL layers (+X, -X, +Y, -Y, +Z, -Z)
+ */
+constexpr std::array<std::string_view, 6> CUBEMAP_FACE_SUFFIXES = {
+    "_px", "_nx", "_py", "_ny", "_pz", "_nz"
+};
+
+constexpr size_t PIXEL_SIZE_LDR = 4;                 // RGBA8
+constexpr size_t PIXEL_SIZE_HDR = 4 * sizeof(float); // RGBA32F
+
+std::string GetTextureKey(std::string_view path_, ChannelTextureKind kind_)
+{
+    return fmt::format("{}:{}", kind_ == ChannelTextureKind::CUBEMAP ? "cube" : "2d", path_);
+}
+
+/**
+ * @brief Returns the path of the cubemap face, "sky.png" becomes "sky_px.png"
+ */
+std::string GetFacePath(std::string_view path_, size_t face_)
+{
+    const auto extension = std::filesystem::path(path_).extension().string();
+    const auto stem      = path_.substr(0, path_.size() - extension.size());
+
+    return fmt::format("{}{}{}", stem, CUBEMAP_FACE_SUFFIXES[face_], extension);
+}
+
+int32_t GetMipLevelCount(int32_t width_, int32_t height_)
+{
+    return static_cast<int32_t>(std::bit_width(static_cast<uint32_t>(std::max(width_, height_))));
+}
+
+}  // namespace
+
+size_t TextureManager::DecodedImage::GetFaceSize() const noexcept
+{
+    return static_cast<size_t>(width) * static_cast<size_t>(height)
+         * (is_hdr ? PIXEL_SIZE_HDR : PIXEL_SIZE_LDR);
+}
+
+TextureManager::TextureManager(std::string_view directory_) noexcept :
+    directory(directory_),
+    workers(ThreadPool::GetDefaultThreadCount())
+{
+    // Cubemaps are filtered across the face edges, like on ShaderToy
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+TextureManager::~TextureManager()
+{
+    // The copies write into the mapped buffers, they must be finished before the buffers go
+    workers.Wait();
+
+    for (auto& upload : uploads)
+    {
+        glUnmapNamedBuffer(upload->buffer);
+        glDeleteBuffers(1, &upload->buffer);
+    }
+
+    for (auto& [key, texture] : textures)
+    {
+        if (texture->texture) { glDeleteTextures(1, &texture->texture); }
+    }
+
+    for (auto& [key, texture] : pool) { glDeleteTextures(1, &texture); }
+}
+
+std::shared_ptr<const ChannelTexture> TextureManager::Acquire(std::string_view   path_,
+                                                              ChannelTextureKind kind_) noexcept
+{
+    auto key = GetTextureKey(path_, kind_);
+
+    auto& texture = textures[key];
+    if (texture && !texture->is_failed) { return texture; }
+
+    if (!texture)
+    {
+        texture       = std::make_shared<ChannelTexture>();
+        texture->path = path_;
+        texture->kind = kind_;
+    }
+
+    texture->is_failed = false;
+
+    {
+        std::lock_guard lock(mutex);
+        ++decoding_count;
+    }
+
+    workers.Submit(
+        [this, key = std::move(key), path = std::string(path_), kind_]() mutable
+        {
+            auto image = Decode(std::move(key), std::move(path), kind_);
+
+            std::lock_guard lock(mutex);
+            decoded_images.push_back(std::move(image));
+            --decoding_count;
+        });
+
+    return texture;
+}
+
+void TextureManager::Update() noexcept
+{
+    // Textures which no shader reads anymore go to the pool
+    for (auto it = textures.begin(); it != textures.end();)
+    {
+        if (it->second.use_count() > 1)
+        {
+            ++it;
+            continue;
+        }
+
+        if (it->second->texture)
+        {
+            RecycleTexture(texture_shapes[it->first], it->second->texture);
+            texture_shapes.erase(it->first);
+        }
+
+        it = textures.erase(it);
+    }
+
+    // Uploads whose pixels were copied by a worker are issued, the GL reads from the buffer
+    for (auto it = uploads.begin(); it != uploads.end();)
+    {
+        if (!(*it)->is_copied.load(std::memory_order_acquire))
+        {
+            ++it;
+            continue;
+        }
+
+        FinishUpload(**it);
+        it = uploads.erase(it);
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        for (auto& image : decoded_images) { waiting_images.push_back(std::move(image)); }
+        decoded_images.clear();
+    }
+
+    // Big batches are spread over frames, so a whole texture pack does not spike one frame
+    uint64_t started_bytes = 0;
+    while (!waiting_images.empty() && started_bytes < UPLOAD_BUDGET_BYTES)
+    {
+        auto image = std::move(waiting_images.front());
+        waiting_images.pop_front();
+
+        started_bytes += image->GetFaceSize() * image->faces.size();
+        StartUpload(std::move(image));
+    }
+
+    stats.resident_textures = static_cast<uint32_t>(textures.size());
+    stats.pooled_textures   = static_cast<uint32_t>(pool.size());
+}
+
+void TextureManager::Finish() noexcept
+{
+    while (true)
+    {
+        workers.Wait();
+        Update();
+
+        bool is_decoding = false;
+        {
+            std::lock_guard lock(mutex);
+            is_decoding = decoding_count > 0 || !decoded_images.empty();
+        }
+
+        if (!is_decoding && waiting_images.empty() && uploads.empty()) { break; }
+    }
+}
+
+TextureManagerStats TextureManager::GetStats() const noexcept { return stats; }
+
+std::unique_ptr<TextureManager::DecodedImage> TextureManager::Decode(
+    std::string        key_,
+    std::string        path_,
+    ChannelTextureKind kind_) const noexcept
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    auto image = std::make_unique<DecodedImage>();
+    image->key = std::move(key_);
+
+    const size_t face_count = kind_ == ChannelTextureKind::CUBEMAP ? 6 : 1;
+
+    for (size_t face = 0; face < face_count; ++face)
+    {
+        const auto face_path = kind_ == ChannelTextureKind::CUBEMAP ? GetFacePath(path_, face)
+                                                                    : path_;
+
+        const FileView file(directory + "/" + face_path);
+        const auto     data = file.GetText();
+        if (data.empty())
+        {
+            LOG_ERROR("Failed to read the texture {}/{}", directory, face_path);
+            image->is_failed = true;
+            break;
+        }
+
+        const auto* bytes  = reinterpret_cast<const stbi_uc*>(data.data());
+        const int   length = static_cast<int>(data.size());
+        const bool  is_hdr = stbi_is_hdr_from_memory(bytes, length) != 0;
+
+        int   width  = 0;
+        int   height = 0;
+        int   comp   = 0;
+        void* pixels = nullptr;
+        if (is_hdr) { pixels = stbi_loadf_from_memory(bytes, length, &width, &height, &comp, 4); }
+        else { pixels = stbi_load_from_memory(bytes, length, &width, &height, &comp, 4); }
+
+        if (!pixels)
+        {
+            LOG_ERROR("Failed to decode the texture {}: {}", face_path, stbi_failure_reason());
+            image->is_failed = true;
+            break;
+        }
+
+        if (face == 0)
+        {
+            image->width  = width;
+            image->height = height;
+            image->is_hdr = is_hdr;
+        }
+
+        if (width != image->width || height != image->height || is_hdr != image->is_hdr)
+        {
+            LOG_ERROR("The cubemap face {} differs in size or format from the first face",
+                      face_path);
+            stbi_image_free(pixels);
+            image->is_failed = true;
+            break;
+        }
+
+        const auto* begin = static_cast<const uint8_t*>(pixels);
+        image->faces.emplace_back(begin, begin + image->GetFaceSize());
+        stbi_image_free(pixels);
+    }
+
+    image->decode_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return image;
+}
+
+void TextureManager::StartUpload(std::unique_ptr<DecodedImage> image_) noexcept
+{
+    auto entry = textures.find(image_->key);
+    if (entry == textures.end()) { return; }  // Released while it was decoded
+
+    ++stats.decoded;
+    stats.last_decode_ms = image_->decode_ms;
+
+    if (image_->is_failed)
+    {
+        ++stats.failures;
+        entry->second->is_failed = true;
+        return;
+    }
+
+    auto upload     = std::make_unique<PendingUpload>();
+    upload->texture = entry->second;
+    upload->image   = std::move(image_);
+
+    const auto& image       = *upload->image;
+    const auto  buffer_size = static_cast<GLsizeiptr>(image.GetFaceSize() * image.faces.size());
+
+    // A new buffer is never in use by the GPU, mapping it does not wait
+    glCreateBuffers(1, &upload->buffer);
+    glNamedBufferStorage(upload->buffer, buffer_size, nullptr, GL_MAP_WRITE_BIT);
+    auto* mapped = static_cast<uint8_t*>(glMapNamedBufferRange(
+        upload->buffer, 0, buffer_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+    if (!mapped)
+    {
+        LOG_ERROR("Failed to map the pixel buffer of the texture {}", image.key);
+        glDeleteBuffers(1, &upload->buffer);
+        upload->texture->is_failed = true;
+        ++stats.failures;
+        return;
+    }
+
+    // 2D textures start with the bottom row in GL, cubemap faces with the top row
+    const bool is_flipped = upload->texture->kind == ChannelTextureKind::TEXTURE_2D;
+
+    workers.Submit(
+        [upload = upload.get(), mapped, is_flipped]
+        {
+            const auto&  image     = *upload->image;
+            const size_t face_size = image.GetFaceSize();
+            const size_t row_size  = face_size / static_cast<size_t>(image.height);
+
+            for (size_t face = 0; face < image.faces.size(); ++face)
+            {
+                uint8_t*       target = mapped + face * face_size;
+                const uint8_t* source = image.faces[face].data();
+
+                if (!is_flipped)
+                {
+                    std::memcpy(target, source, face_size);
+                    continue;
+                }
+
+                for (size_t row = 0; row < static_cast<size_t>(image.height); ++row)
+                {
+                    std::memcpy(target + row * row_size,
+                                source + (static_cast<size_t>(image.height) - 1 - row) * row_size,
+                                row_size);
+                }
+            }
+
+            upload->is_copied.store(true, std::memory_order_release);
+        });
+
+    uploads.push_back(std::move(upload));
+}
+
+void TextureManager::FinishUpload(PendingUpload& upload_) noexcept
+{
+    glUnmapNamedBuffer(upload_.buffer);
+
+    auto&       texture = *upload_.texture;
+    const auto& image   = *upload_.image;
+    const auto  key     = GetPoolKey(image, texture.kind);
+
+    // A reload of the same file replaces the old texture
+    if (texture.texture) { RecycleTexture(texture_shapes[image.key], texture.texture); }
+
+    const GLuint target = TakeTexture(key);
+    const GLenum type   = image.is_hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_.buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (texture.kind == ChannelTextureKind::CUBEMAP)
+    {
+        glTextureSubImage3D(target,
+                            0,
+                            0,
+                            0,
+                            0,
+                            image.width,
+                            image.height,
+                            static_cast<GLsizei>(image.faces.size()),
+                            GL_RGBA,
+                            type,
+                            nullptr);
+    }
+    else
+    {
+        glTextureSubImage2D(target, 0, 0, 0, image.width, image.height, GL_RGBA, type, nullptr);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glGenerateTextureMipmap(target);
+
+    // Deleting the buffer is deferred by the driver until the upload has read it
+    glDeleteBuffers(1, &upload_.buffer);
+
+    texture.texture    = target;
+    texture.resolution = glm::vec3(image.width, image.height, 1.0f);
+    texture.is_failed  = false;
+
+    texture_shapes[image.key] = key;
+    ++stats.uploads;
+}
+
+TextureManager::PoolKey TextureManager::GetPoolKey(const DecodedImage& image_,
+                                                   ChannelTextureKind  kind_) noexcept
+{
+    PoolKey key;
+    key.target = kind_ == ChannelTextureKind::CUBEMAP ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    key.width  = image_.width;
+    key.height = image_.height;
+    key.format = image_.is_hdr ? GL_RGBA16F : GL_RGBA8;
+
+    return key;
+}
+
+GLuint TextureManager::TakeTexture(const PoolKey& key_) noexcept
+{
+    if (auto it = pool.find(key_); it != pool.end())
+    {
+        const GLuint texture = it->second;
+        pool.erase(it);
+        pool_order.erase(std::find(pool_order.begin(), pool_order.end(), key_));
+
+        ++stats.pool_reuses;
+        return texture;
+    }
+
+    GLuint texture = 0;
+    glCreateTextures(key_.target, 1, &texture);
+    glTextureStorage2D(texture,
+                       GetMipLevelCount(key_.width, key_.height),
+                       key_.format,
+                       key_.width,
+                       key_.height);
+
+    // ShaderToy defaults, mipmapped and repeated, cubemaps are clamped to their faces
+    const GLint wrap = key_.target == GL_TEXTURE_CUBE_MAP ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, wrap);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, wrap);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_R, wrap);
+
+    return texture;
+}
+
+void TextureManager::RecycleTexture(const PoolKey& key_, GLuint texture_) noexcept
+{
+    pool.emplace(key_, texture_);
+    pool_order.push_back(key_);
+
+    while (pool.size() > MAX_POOLED_TEXTURES)
+    {
+        auto oldest = pool.find(pool_order.front());
+        pool_order.pop_front();
+
+        glDeleteTextures(1, &oldest->second);
+        pool.erase(oldest);
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "PCH.h"
+
+#include "ThreadPool.h"
+
+enum class ChannelTextureKind : uint8_t {
+    TEXTURE_2D, /**< One image, flipped so the first row is at the top like on ShaderToy */
+    CUBEMAP     /**< Six images named <name>_px, _nx, _py, _ny, _pz and _nz */
+};
+
+/**
+ * @brief Image file bound to a channel, shared by all passes which read it
+ */
+struct ChannelTexture {
+    std::string        path;                          /**< Relative to the texture directory */
+    ChannelTextureKind kind       = ChannelTextureKind::TEXTURE_2D;
+    GLuint             texture    = 0;                /**< 0 until the upload is finished */
+    glm::vec3          resolution = glm::vec3(0.0f);  /**< iChannelResolution, 0 until loaded */
+    bool               is_failed  = false;            /**< Flag indicating if it can not be read */
+};
+
+/**
+ * @brief Counters of the texture loading
+ */
+struct TextureManagerStats {
+    uint64_t decoded           = 0;   /**< Images decoded by the workers */
+    uint64_t uploads           = 0;   /**< Textures uploaded through pixel buffers */
+    uint64_t failures          = 0;   /**< Files which could not be read or decoded */
+    uint64_t pool_reuses       = 0;   /**< Uploads into a pooled texture instead of a new one */
+    uint32_t resident_textures = 0;   /**< Textures used by the shaders */
+    uint32_t pooled_textures   = 0;   /**< Textures kept for reuse */
+    double   last_decode_ms    = 0.0; /**< Decode time of the last image on its worker */
+};
+
+/**
+ * @brief Loads the channel textures without stalling the render thread
+ *
+ * @remark Files are decoded on a thread pool. The render thread maps a pixel buffer for each
+ * decoded image, a worker copies the pixels into it and the render thread then uploads from the
+ * buffer and generates the mipmaps, so it never copies pixels or waits for the driver. Textures
+ * nobody uses anymore go to a pool keyed by target, size and format, and are reused by the next
+ * image of the same shape.
+ */
+struct TextureManager {
+    static constexpr size_t   MAX_POOLED_TEXTURES = 16;
+    static constexpr uint64_t UPLOAD_BUDGET_BYTES = 64ull * 1024 * 1024; /**< Per Update() */
+
+    /**
+     * @param directory_ Directory the texture paths are relative to, relative to the application
+     *
+     * @remark Must be created with a current GL context
+     */
+    explicit TextureManager(std::string_view directory_) noexcept;
+
+    TextureManager(const TextureManager&)             = delete;
+    TextureManager& operator= (const TextureManager&) = delete;
+
+    ~TextureManager();
+
+    /**
+     * @brief Returns the texture of the file, starting to load it on the first request
+     *
+     * @remark The texture is released when the last returned pointer is dropped. A texture which
+     * failed to load is tried again.
+     */
+    std::shared_ptr<const ChannelTexture> Acquire(std::string_view   path_,
+                                                  ChannelTextureKind kind_) noexcept;
+
+    /**
+     * @brief Advances the loading, must be called once per frame on the render thread
+     */
+    void Update() noexcept;
+
+    /**
+     * @brief Blocks until every requested texture is uploaded or failed, used when the frames
+     * must not depend on the loading time (e.g. headless rendering)
+     */
+    void Finish() noexcept;
+
+    TextureManagerStats GetStats() const noexcept;
+
+private:
+
+    /**
+     * @brief Pixels of all faces decoded by a worker, RGBA8 or RGBA32F
+     */
+    struct DecodedImage {
+        std::string                       key;
+        int32_t                           width     = 0;
+        int32_t                           height    = 0;
+        bool                              is_hdr    = false;
+        bool                              is_failed = false;
+        std::vector<std::vector<uint8_t>> faces;
+        double                            decode_ms = 0.0;
+
+        size_t GetFaceSize() const noexcept;
+    };
+
+    /**
+     * @brief Decoded image being copied into its pixel buffer by a worker
+     */
+    struct PendingUpload {
+        std::shared_ptr<ChannelTexture> texture;
+        std::unique_ptr<DecodedImage>   image;
+        GLuint                          buffer    = 0;
+        std::atomic<bool>               is_copied = false;
+    };
+
+    /**
+     * @brief Shape of a texture, only textures of the same shape can be reused
+     */
+    struct PoolKey {
+        GLenum  target = GL_TEXTURE_2D;
+        int32_t width  = 0;
+        int32_t height = 0;
+        GLenum  format = GL_RGBA8;
+
+        auto operator<=> (const PoolKey&) const = default;
+    };
+
+    /**
+     * @brief Runs on a worker, reads and decodes all faces of the texture
+     */
+    std::unique_ptr<DecodedImage> Decode(std::string        key_,
+                                         std::string        path_,
+                                         ChannelTextureKind kind_) const noexcept;
+
+    void StartUpload(std::unique_ptr<DecodedImage> image_) noexcept;
+    void FinishUpload(PendingUpload& upload_) noexcept;
+
+    static PoolKey GetPoolKey(const DecodedImage& image_, ChannelTextureKind kind_) noexcept;
+
+    /**
+     * @brief Returns a pooled texture of the shape or creates one with a full mipmap chain
+     */
+    GLuint TakeTexture(const PoolKey& key_) noexcept;
+    void   RecycleTexture(const PoolKey& key_, GLuint texture_) noexcept;
+
+private:
+    std::string directory; /**< Relative to the application directory */
+
+    std::map<std::string, std::shared_ptr<ChannelTexture>> textures;       /**< By kind and path */
+    std::map<std::string, PoolKey>                         texture_shapes; /**< Of the uploads */
+    std::multimap<PoolKey, GLuint>                         pool;           /**< Unused textures */
+    std::deque<PoolKey>                                    pool_order;     /**< Oldest first */
+
+    std::mutex                                 mutex;
+    std::vector<std::unique_ptr<DecodedImage>> decoded_images;     /**< Written by the workers */
+    size_t                                     decoding_count = 0; /**< Decodes not finished */
+
+    std::deque<std::unique_ptr<DecodedImage>>   waiting_images; /**< Over the upload budget */
+    std::vector<std::unique_ptr<PendingUpload>> uploads;        /**< Copies in flight */
+
+    TextureManagerStats stats;
+
+    ThreadPool workers; /**< Declared last, finishes the jobs before the other members go */
+};
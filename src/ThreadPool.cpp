@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t thread_count_) noexcept
+{
+    thread_count_ = std::max<size_t>(thread_count_, 1);
+
+    workers.reserve(thread_count_);
+    for (size_t i = 0; i < thread_count_; ++i)
+    {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        is_stopping = true;
+    }
+    wake_condition.notify_all();
+
+    // The workers drain the queue before they stop
+    for (auto& worker : workers)
+    {
+        if (worker.joinable()) { worker.join(); }
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job_) noexcept
+{
+    {
+        std::lock_guard lock(mutex);
+        jobs.push_back(std::move(job_));
+        ++pending_count;
+    }
+
+    wake_condition.notify_one();
+}
+
+void ThreadPool::Wait() noexcept
+{
+    std::unique_lock lock(mutex);
+    idle_condition.wait(lock, [this] { return pending_count == 0; });
+}
+
+size_t ThreadPool::GetThreadCount() const noexcept { return workers.size(); }
+
+size_t ThreadPool::GetPendingCount() const noexcept
+{
+    std::lock_guard lock(mutex);
+    return pending_count;
+}
+
+size_t ThreadPool::GetDefaultThreadCount() noexcept
+{
+    // One core is left to the render thread, the driver has threads of its own
+    const size_t hardware_threads = std::thread::hardware_concurrency();
+    return std::clamp<size_t>(hardware_threads > 1 ? hardware_threads - 1 : 1, 1, 4);
+}
+
+void ThreadPool::WorkerLoop() noexcept
+{
+    std::unique_lock lock(mutex);
+
+    while (true)
+    {
+        wake_condition.wait(lock, [this] { return is_stopping || !jobs.empty(); });
+
+        if (jobs.empty())  // Stopping with nothing left to run
+        {
+            break;
+        }
+
+        auto job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        job();
+
+        lock.lock();
+        if (--pending_count == 0) { idle_condition.notify_all(); }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * @brief Fixed set of worker threads which run queued jobs in submission order
+ *
+ * @remark Jobs must not touch the GL context, they run on threads without one
+ */
+struct ThreadPool {
+    /**
+     * @param thread_count_ Number of the workers, at least one is started
+     */
+    explicit ThreadPool(size_t thread_count_) noexcept;
+
+    ThreadPool(const ThreadPool&)             = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    /**
+     * @brief Finishes the queued jobs and stops the workers
+     */
+    ~ThreadPool();
+
+    void Submit(std::function<void()> job_) noexcept;
+
+    /**
+     * @brief Blocks until all submitted jobs are finished
+     */
+    void Wait() noexcept;
+
+    size_t GetThreadCount() const noexcept;
+
+    /**
+     * @brief Returns the number of the jobs which are queued or running
+     */
+    size_t GetPendingCount() const noexcept;
+
+    /**
+     * @brief Returns the number of the workers worth starting next to the render thread
+     */
+    static size_t GetDefaultThreadCount() noexcept;
+
+private:
+    void WorkerLoop() noexcept;
+
+private:
+    mutable std::mutex      mutex;
+    std::condition_variable wake_condition; /**< Signaled when a job is queued or on stop */
+    std::condition_variable idle_condition; /**< Signaled when the last pending job finishes */
+
+    std::deque<std::function<void()>> jobs;
+    size_t                            pending_count = 0; /**< Queued and running jobs */
+    bool                              is_stopping   = false;
+
+    std::vector<std::thread> workers; /**< Declared last, start after the other members */
+};
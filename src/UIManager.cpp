@@ -3,9 +3,27 @@
 
 bool UIManager::is_ui_visible = true;
 
-UIManager::UIManager(GLFWwindow* window_, ShaderManager& shader_manager_) noexcept :
+UIManager::UIManager(GLFWwindow*          window_,
+                     ShaderManager&       shader_manager_,
+                     RenderGraph&         render_graph_,
+                     ResolutionScaler&    resolution_scaler_,
+                     ProgressiveRenderer& progressive_renderer_,
+                     FrameExporter&       frame_exporter_,
+                     FramePacer&          frame_pacer_,
+                     LatencyTracker&      latency_tracker_,
+                     const FrameStats&    frame_stats_,
+                     FrameProfiler&       frame_profiler_) noexcept :
     window(window_),
-    shader_manager(shader_manager_)
+    shader_manager(shader_manager_),
+    render_graph(render_graph_),
+    resolution_scaler(resolution_scaler_),
+    progressive_renderer(progressive_renderer_),
+    frame_exporter(frame_exporter_),
+    frame_pacer(frame_pacer_),
+    latency_tracker(latency_tracker_),
+    frame_stats(frame_stats_),
+    frame_profiler(frame_profiler_),
+    saved_shaders("shaders/saved", ".glsl")
 {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -78,6 +96,7 @@ void UIManager::RenderFrame() noexcept
             if (ImGui::MenuItem("Quit", "Ctrl+Q"))
             {
                 shader_manager.SaveFragmentShaderToPath("shaders/latest_fragment.glsl");
+                shader_manager.SaveBufferShaders();
                 glfwSetWindowShouldClose(window, GLFW_TRUE);
             }
 
@@ -87,6 +106,12 @@ void UIManager::RenderFrame() noexcept
         if (ImGui::BeginMenu("View"))
         {
             if (ImGui::MenuItem("Show UI", "Ctrl+H", &is_ui_visible)) {}
+
+            bool is_overlay_visible = frame_profiler.IsEnabled();
+            if (ImGui::MenuItem("Frame Timing Overlay", nullptr, &is_overlay_visible))
+            {
+                frame_profiler.SetEnabled(is_overlay_visible);  // Hidden overlay costs nothing
+            }
             ImGui::EndMenu();
         }
 
@@ -114,6 +139,13 @@ void UIManager::RenderFrame() noexcept
                 ImGui::EndTabItem();
             }
 
+            if (ImGui::BeginTabItem("Buffers"))
+            {
+                DrawBuffers();
+
+                ImGui::EndTabItem();
+            }
+
             if (ImGui::BeginTabItem("Vertex Shader"))
             {
                 ImGui::Text(vertex_shader_source.data());
@@ -131,31 +163,86 @@ void UIManager::RenderFrame() noexcept
                                        fragment_shader.GetCompilationError().data());
                 }
 
+                for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+                {
+                    const auto& buffer_shader = shader_manager.GetBufferShader(i);
+                    if (!shader_manager.IsBufferEnabled(i) || buffer_shader.IsGood()) { continue; }
+
+                    ImGui::Text("Buffer %c:", static_cast<char>('A' + i));
+                    ImGui::TextColored(ImVec4(1, 0, 0, 1),
+                                       "%s",
+                                       buffer_shader.GetCompilationError().data());
+                }
+
                 ImGui::EndTabItem();
             }
             if (ImGui::BeginTabItem("Editor Settings"))
             {
                 if (ImGui::ColorEdit3("Text Color", (float*)&text_color)) {}
 
+                int recompile_delay_ms =
+                    static_cast<int>(shader_manager.GetRecompileDelay().count());
+                if (ImGui::SliderInt("Recompile Delay (ms)", &recompile_delay_ms, 0, 1000))
+                {
+                    shader_manager.SetRecompileDelay(std::chrono::milliseconds(recompile_delay_ms));
+                }
+
+                bool is_builtin_block_enabled = shader_manager.IsBuiltinBlockEnabled();
+                if (ImGui::Checkbox("Builtin Uniform Block", &is_builtin_block_enabled))
+                {
+                    shader_manager.SetBuiltinBlockEnabled(is_builtin_block_enabled);
+                }
+
+                const auto recompile_stats = shader_manager.GetRecompileStats();
+                ImGui::Text("Edits: %llu", (unsigned long long)recompile_stats.edits);
+                ImGui::Text("Compile requests issued: %llu",
+                            (unsigned long long)recompile_stats.requests_issued);
+                ImGui::Text("Compiles skipped: %llu",
+                            (unsigned long long)recompile_stats.GetCompilesSkipped());
+
+                ImGui::EndTabItem();
+            }
+
+            if (ImGui::BeginTabItem("Performance"))
+            {
+                DrawFrameStats();
+                DrawFramePacing();
+                DrawInputLatency();
+                DrawResolutionScale();
+                DrawProgressive();
+
+                ImGui::EndTabItem();
+            }
+
+            if (ImGui::BeginTabItem("Export"))
+            {
+                DrawExport();
+
                 ImGui::EndTabItem();
             }
 
             if (ImGui::BeginTabItem("Saved Shaders"))
             {
-                auto files = GetFilesInDirectory("shaders/saved", ".glsl");
+                // Snapshot keeps the listing alive even if the watcher publishes a new one
+                const auto snapshot = saved_shaders.GetSnapshot();
 
-                for (const auto& file : files)
+                for (const auto& entry : *snapshot)
                 {  // here we wanna on click load the shader
-                    if (ImGui::Button(file.c_str()))
+                    if (ImGui::Button(entry.name.c_str()))
                     {
-                        auto path = "shaders/saved/" + file + ".glsl";
-                        shader_manager.LoadFragmentShaderFromPath(path);
+                        shader_manager.LoadFragmentShaderFromPath(entry.path);
                     }
                 }
 
                 ImGui::EndTabItem();
             }
 
+            if (ImGui::BeginTabItem("History"))
+            {
+                DrawHistory();
+
+                ImGui::EndTabItem();
+            }
 
             ImGui::EndTabBar();
         }
@@ -163,6 +250,8 @@ void UIManager::RenderFrame() noexcept
 
     if (show_save_popup) { DrawSavePopup(); }
 
+    if (frame_profiler.IsEnabled()) { DrawFrameTimingOverlay(); }
+
 
     ImGui::PopStyleColor();  // Pop the style change to revert text colorq}
 
@@ -191,6 +280,515 @@ void UIManager::Shutdown() noexcept
     ImGui::DestroyContext();
 }
 
+void UIManager::DrawFrameStats() noexcept
+{
+    const auto draw_snapshot = [](const char* label, const FrameStatsSnapshot& snapshot)
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", label);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", snapshot.GetAverageFPS());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", snapshot.avg_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", snapshot.p50_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", snapshot.p99_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", snapshot.p999_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", snapshot.max_ms);
+    };
+
+    if (ImGui::BeginTable("FrameStats", 7, ImGuiTableFlags_Borders))
+    {
+        for (const char* header : { "", "FPS", "avg ms", "p50", "p99", "p99.9", "max" })
+        {
+            ImGui::TableSetupColumn(header);
+        }
+        ImGui::TableHeadersRow();
+
+        draw_snapshot("Last second", frame_stats.GetInterval());
+        draw_snapshot("Last 10 seconds", frame_stats.GetWindow());
+        draw_snapshot("Total", frame_stats.GetTotal());
+
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Export JSON"))
+    {
+        if (frame_stats.Export("logs/frame_stats.json"))
+        {
+            LOG_INFO("Frame stats exported to logs/frame_stats.json");
+        }
+    }
+}
+
+void UIManager::DrawFramePacing() noexcept
+{
+    ImGui::Separator();
+    ImGui::Text("Frame Pacing");
+
+    int mode = static_cast<int>(frame_pacer.GetMode());
+    for (int i = 0; i < static_cast<int>(FramePacingMode::COUNT); ++i)
+    {
+        const auto item_mode = static_cast<FramePacingMode>(i);
+        if (item_mode == FramePacingMode::ADAPTIVE_VSYNC && !frame_pacer.IsAdaptiveVsyncSupported())
+        {
+            continue;
+        }
+
+        if (i > 0) { ImGui::SameLine(); }
+        if (ImGui::RadioButton(FramePacer::GetModeName(item_mode), &mode, i))
+        {
+            frame_pacer.SetMode(item_mode);
+        }
+    }
+
+    if (frame_pacer.GetMode() == FramePacingMode::LIMITED)
+    {
+        float target_fps = frame_pacer.GetTargetFps();
+        if (ImGui::SliderFloat("Target FPS",
+                               &target_fps,
+                               FramePacer::MIN_TARGET_FPS,
+                               FramePacer::MAX_TARGET_FPS,
+                               "%.0f",
+                               ImGuiSliderFlags_Logarithmic))
+        {
+            frame_pacer.SetTargetFps(target_fps);
+        }
+    }
+
+    if (ImGui::BeginTable("FramePacing", 6, ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("Mode");
+        ImGui::TableSetupColumn("Frames");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Std dev ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableSetupColumn("Input latency ms (avg / p99)");
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < static_cast<int>(FramePacingMode::COUNT); ++i)
+        {
+            const auto  item_mode = static_cast<FramePacingMode>(i);
+            const auto& stats     = frame_pacer.GetStats(item_mode);
+            if (stats.frame_times.GetCount() == 0) { continue; }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", FramePacer::GetModeName(item_mode));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.frame_times.GetCount());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.frame_times.GetAverage());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.GetFrameStdDevMs());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.frame_times.GetQuantile(0.99));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f / %.3f",
+                        stats.input_latencies.GetAverage(),
+                        stats.input_latencies.GetQuantile(0.99));
+        }
+
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Reset Pacing Stats")) { frame_pacer.ResetStats(); }
+}
+
+void UIManager::DrawInputLatency() noexcept
+{
+    ImGui::Separator();
+    ImGui::Text("Input Latency");
+
+    bool is_enabled = latency_tracker.IsEnabled();
+    if (ImGui::Checkbox("Measure Input to Photon", &is_enabled))
+    {
+        latency_tracker.SetEnabled(is_enabled);
+    }
+
+    if (!is_enabled) { return; }
+
+    const auto& stats = latency_tracker.GetStats();
+    ImGui::Text("%llu events, %llu frames read input, %llu measured on the GPU",
+                (unsigned long long)stats.events,
+                (unsigned long long)stats.consumed_frames,
+                (unsigned long long)stats.measured_frames);
+
+    const auto draw_histogram = [](const char* label, const FrameTimeHistogram& histogram)
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", label);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", histogram.GetQuantile(0.5));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", histogram.GetQuantile(0.9));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", histogram.GetQuantile(0.99));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", histogram.GetQuantile(0.999));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", histogram.GetMax());
+    };
+
+    if (ImGui::BeginTable("InputLatency", 6, ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("From input to");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p90 ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableSetupColumn("p99.9 ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+
+        draw_histogram("Frame", stats.to_consume);
+        draw_histogram("Swap", stats.to_swap);
+        draw_histogram("GPU complete", stats.to_complete);
+
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Reset Latency Stats")) { latency_tracker.ResetStats(); }
+}
+
+void UIManager::DrawResolutionScale() noexcept
+{
+    ImGui::Separator();
+    ImGui::Text("Resolution Scale");
+
+    bool is_adaptive = resolution_scaler.GetMode() == ResolutionScaleMode::ADAPTIVE;
+    if (ImGui::Checkbox("Adaptive", &is_adaptive))
+    {
+        resolution_scaler.SetMode(is_adaptive ? ResolutionScaleMode::ADAPTIVE
+                                              : ResolutionScaleMode::FIXED);
+    }
+
+    float scale = resolution_scaler.GetScale();
+    if (ImGui::SliderFloat(is_adaptive ? "Max Scale" : "Scale",
+                           &scale,
+                           ResolutionScaler::MIN_SCALE,
+                           ResolutionScaler::MAX_SCALE,
+                           "%.3fx"))
+    {
+        resolution_scaler.SetScale(scale);
+    }
+
+    if (is_adaptive)
+    {
+        float target_frame_ms = resolution_scaler.GetTargetFrameMs();
+        if (ImGui::SliderFloat("Target GPU ms", &target_frame_ms, 1.0f, 50.0f, "%.1f"))
+        {
+            resolution_scaler.SetTargetFrameMs(target_frame_ms);
+        }
+    }
+
+    ImGui::Text("Drawn at %dx%d (%.3fx), GPU %.2f ms, %llu scale changes",
+                resolution_scaler.GetRenderWidth(),
+                resolution_scaler.GetRenderHeight(),
+                resolution_scaler.GetCurrentScale(),
+                resolution_scaler.GetGpuMs(),
+                (unsigned long long)resolution_scaler.GetScaleChangeCount());
+}
+
+void UIManager::DrawProgressive() noexcept
+{
+    ImGui::Separator();
+    ImGui::Text("Progressive Rendering");
+
+    bool is_tiled = progressive_renderer.IsTiled();
+    if (ImGui::Checkbox("Tiled", &is_tiled)) { progressive_renderer.SetTiled(is_tiled); }
+
+    if (is_tiled)
+    {
+        int tile_size = progressive_renderer.GetTileSize();
+        if (ImGui::SliderInt("Tile Size",
+                             &tile_size,
+                             ProgressiveRenderer::MIN_TILE_SIZE,
+                             ProgressiveRenderer::MAX_TILE_SIZE))
+        {
+            progressive_renderer.SetTileSize(tile_size);
+        }
+
+        int tiles_per_frame = progressive_renderer.GetTilesPerFrame();
+        if (ImGui::SliderInt("Tiles per Frame", &tiles_per_frame, 1, 64))
+        {
+            progressive_renderer.SetTilesPerFrame(tiles_per_frame);
+        }
+
+        ImGui::Text("Tile %d of %d, %llu images completed",
+                    progressive_renderer.GetCompletedTileCount(),
+                    progressive_renderer.GetTileCount(),
+                    (unsigned long long)progressive_renderer.GetImageCount());
+    }
+
+    bool is_accumulation_enabled = progressive_renderer.IsAccumulationEnabled();
+    if (ImGui::Checkbox("Accumulate While Paused", &is_accumulation_enabled))
+    {
+        progressive_renderer.SetAccumulationEnabled(is_accumulation_enabled);
+    }
+
+    if (is_accumulation_enabled)
+    {
+        ImGui::Text("Samples: %u", progressive_renderer.GetSampleCount());
+    }
+}
+
+void UIManager::DrawExport() noexcept
+{
+    const bool is_exporting = frame_exporter.IsExporting();
+
+    ImGui::BeginDisabled(is_exporting);
+
+    ImGui::InputInt("Width", &export_settings.width);
+    ImGui::InputInt("Height", &export_settings.height);
+    ImGui::InputInt("Frames", &export_settings.frame_count);
+    ImGui::InputFloat("Start Time", &export_settings.start_time, 0.0f, 0.0f, "%.3f s");
+
+    float frame_rate = export_settings.time_step > 0.0f ? 1.0f / export_settings.time_step : 0.0f;
+    if (ImGui::InputFloat("Frame Rate", &frame_rate, 0.0f, 0.0f, "%.3f"))
+    {
+        export_settings.time_step = frame_rate > 0.0f ? 1.0f / frame_rate : 0.0f;
+    }
+
+    // NONE is left out, an export which writes nothing is the headless timing mode
+    constexpr const char* FORMAT_NAMES[] = { "PNG sequence", "Raw RGBA8 sequence", "Y4M video" };
+    int format = static_cast<int>(export_settings.output_format) - 1;
+    if (ImGui::Combo("Format", &format, FORMAT_NAMES, IM_ARRAYSIZE(FORMAT_NAMES)))
+    {
+        export_settings.output_format = static_cast<FrameOutputFormat>(format + 1);
+    }
+
+    ImGui::InputText("Directory", &export_settings.output_directory);
+
+    ImGui::EndDisabled();
+
+    if (!is_exporting && ImGui::Button("Export"))
+    {
+        render_graph.Reset();  // Feedback starts from black, like in the headless mode
+        frame_exporter.Begin(export_settings);
+    }
+    else if (is_exporting && ImGui::Button("Stop")) { frame_exporter.Finish(); }
+
+    const auto stats = frame_exporter.GetStats();
+    ImGui::ProgressBar(static_cast<float>(stats.written_frames)
+                       / static_cast<float>(std::max(frame_exporter.GetSettings().frame_count, 1)));
+    ImGui::Text("%d of %d frames written, %.2f frames per second, %d stalls (%.1f ms)",
+                stats.written_frames,
+                frame_exporter.GetSettings().frame_count,
+                stats.GetFramesPerSecond(),
+                stats.stalls,
+                stats.stall_ms);
+
+    if (stats.failed_writes > 0) { ImGui::Text("Failed writes: %d", stats.failed_writes); }
+}
+
+void UIManager::DrawHistory() noexcept
+{
+    auto&       history   = shader_manager.GetHistory();
+    const auto& revisions = history.GetRevisions();
+
+    if (revisions.empty())
+    {
+        ImGui::Text("No compiled revisions yet");
+        return;
+    }
+
+    const int last_revision = static_cast<int>(revisions.size()) - 1;
+    if (history_revision < 0 || history_revision > last_revision)
+    {
+        history_revision = last_revision;
+    }
+
+    // Every step of the slider builds the revision, cached programs are loaded without compiling
+    if (ImGui::SliderInt("Revision", &history_revision, 0, last_revision))
+    {
+        shader_manager.LoadFragmentShaderFromHistory(static_cast<size_t>(history_revision));
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Latest"))
+    {
+        history_revision = last_revision;
+        shader_manager.LoadFragmentShaderFromHistory(static_cast<size_t>(history_revision));
+    }
+
+    const auto& revision = revisions[static_cast<size_t>(history_revision)];
+    const auto  now_ms   = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    ImGui::Text("Compiled %.0f s ago, %u bytes, stored as %s in %u bytes",
+                static_cast<double>(now_ms - revision.time_ms) / 1000.0,
+                revision.text_size,
+                revision.is_keyframe ? "full text" : "delta",
+                revision.stored_size);
+
+    const auto stats = history.GetStats();
+    ImGui::Text("%llu revisions (%llu full), %.1f KiB on disk for %.1f KiB of code",
+                (unsigned long long)stats.revisions,
+                (unsigned long long)stats.keyframes,
+                static_cast<double>(stats.pack_bytes) / 1024.0,
+                static_cast<double>(stats.text_bytes) / 1024.0);
+}
+
+void UIManager::DrawBuffers() noexcept
+{
+    if (ImGui::BeginTabBar("Buffers"))
+    {
+        for (size_t i = 0; i < BUFFER_PASS_COUNT; ++i)
+        {
+            const std::string name = fmt::format("Buffer {}", static_cast<char>('A' + i));
+            if (!ImGui::BeginTabItem(name.c_str())) { continue; }
+
+            bool is_enabled = shader_manager.IsBufferEnabled(i);
+            if (ImGui::Checkbox("Enabled", &is_enabled))
+            {
+                shader_manager.SetBufferEnabled(i, is_enabled);
+            }
+
+            ImGui::SameLine();
+            ImGui::Text("%s, %s",
+                        shader_manager.GetBufferPath(i).data(),
+                        render_graph.IsBufferActive(static_cast<RenderPassId>(i))
+                            ? "read by the image"
+                            : "not read by the image");
+
+            if (is_enabled)
+            {
+                ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.1f, 0.1f, 0.3f, 0.0f));
+
+                ImVec2 parent_window_size = ImGui::GetWindowSize();
+
+                ImGui::InputTextMultiline("##buffer",
+                                          &shader_manager.GetBufferShader(i).GetCode(),
+                                          ImVec2(-FLT_MIN, parent_window_size.y * 0.80f),
+                                          ImGuiInputTextFlags_AllowTabInput);
+
+                ImGui::PopStyleColor();
+            }
+
+            ImGui::EndTabItem();
+        }
+
+        ImGui::EndTabBar();
+    }
+
+    const auto& stats = render_graph.GetStats();
+    ImGui::Text("Passes drawn: %u, reused: %u, culled: %u",
+                stats.executed_passes,
+                stats.skipped_passes,
+                stats.culled_passes);
+    ImGui::Text("Buffer textures: %u (%.1f MiB), plans: %llu",
+                stats.texture_count,
+                static_cast<double>(stats.texture_bytes) / (1024.0 * 1024.0),
+                (unsigned long long)stats.plans);
+
+    if (ImGui::Button("Reset Buffers")) { render_graph.Reset(); }
+}
+
+void UIManager::DrawFrameTimingOverlay() noexcept
+{
+    constexpr std::array<ImU32, FrameProfiler::STAGE_COUNT> STAGE_COLORS = {
+        IM_COL32(230, 160, 60, 255),   // Shader update
+        IM_COL32(90, 170, 240, 255),   // Shader draw
+        IM_COL32(140, 220, 110, 255),  // UI
+        IM_COL32(200, 110, 200, 255)   // Swap
+    };
+    constexpr float  GRAPH_HEIGHT   = 70.0f;
+    constexpr size_t AVERAGE_FRAMES = 60;
+
+    const ImVec2 work_size = ImGui::GetMainViewport()->WorkSize;
+    ImGui::SetNextWindowPos(ImVec2(work_size.x - 10.0f, 40.0f),  // Top right, below the menu
+                            ImGuiCond_Always,
+                            ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.6f);
+
+    ImGui::Begin("Frame Timing",
+                 nullptr,
+                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize
+                     | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+
+    const auto average = frame_profiler.GetAverage(AVERAGE_FRAMES);
+
+    if (ImGui::BeginTable("Stages", 3, ImGuiTableFlags_SizingFixedFit))
+    {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < FrameProfiler::STAGE_COUNT; ++i)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(STAGE_COLORS[i]),
+                               "%s",
+                               magic_enum::enum_name(static_cast<ProfileStage>(i)).data());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", average.cpu_ms[i]);
+            ImGui::TableNextColumn();
+            if (average.has_gpu) { ImGui::Text("%.3f", average.gpu_ms[i]); }
+            else { ImGui::TextDisabled("-"); }
+        }
+
+        ImGui::EndTable();
+    }
+
+    // Stacked bars of the stages, newest frame on the right
+    const auto draw_graph = [&](const char* label, bool is_gpu)
+    {
+        const size_t count = frame_profiler.GetHistoryCount();
+
+        float max_total = 1.0f;  // At least 1 ms, so idle frames do not fill the graph
+        for (size_t age = 0; age < count; ++age)
+        {
+            const auto& timings = frame_profiler.GetHistory(age);
+            const auto& stages  = is_gpu ? timings.gpu_ms : timings.cpu_ms;
+            max_total = std::max(max_total, std::accumulate(stages.begin(), stages.end(), 0.0f));
+        }
+
+        ImGui::Text("%s (max %.2f ms)", label, max_total);
+
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float  width  = static_cast<float>(FrameProfiler::HISTORY_SIZE);
+        auto*        draw   = ImGui::GetWindowDrawList();
+
+        draw->AddRectFilled(origin,
+                            ImVec2(origin.x + width, origin.y + GRAPH_HEIGHT),
+                            IM_COL32(0, 0, 0, 120));
+
+        for (size_t age = 0; age < count; ++age)
+        {
+            const auto& timings = frame_profiler.GetHistory(age);
+            if (is_gpu && !timings.has_gpu) { continue; }
+
+            const auto& stages = is_gpu ? timings.gpu_ms : timings.cpu_ms;
+            const float x      = origin.x + width - 1.0f - static_cast<float>(age);
+            float       y      = origin.y + GRAPH_HEIGHT;
+
+            for (size_t i = 0; i < FrameProfiler::STAGE_COUNT; ++i)
+            {
+                const float height = stages[i] / max_total * GRAPH_HEIGHT;
+                draw->AddRectFilled(ImVec2(x, y - height), ImVec2(x + 1.0f, y), STAGE_COLORS[i]);
+                y -= height;
+            }
+        }
+
+        ImGui::Dummy(ImVec2(width, GRAPH_HEIGHT));
+    };
+
+    draw_graph("CPU", false);
+    draw_graph("GPU", true);
+
+    ImGui::TextDisabled("GPU results dropped: %llu",
+                        (unsigned long long)frame_profiler.GetDroppedCount());
+
+    ImGui::End();
+}
+
 void UIManager::DrawSavePopup() noexcept
 {
     auto fragment_shader_source = shader_manager.GetFragmentShader().GetCode();
@@ -2,13 +2,31 @@
 
 #include "PCH.h"
 
+#include "FrameStats.h"
+#include "FrameProfiler.h"
+#include "ShaderLibrary.h"
 #include "ShaderManager.h"
+#include "RenderGraph.h"
+#include "ResolutionScaler.h"
+#include "ProgressiveRenderer.h"
+#include "FrameExporter.h"
+#include "FramePacer.h"
+#include "LatencyTracker.h"
 
 /**
  * @brief UIManager class responsible for setting up and managing ImGui.
  */
 struct UIManager {
-    explicit UIManager(GLFWwindow* window_, ShaderManager& shader_manager_) noexcept;
+    explicit UIManager(GLFWwindow*          window_,
+                       ShaderManager&       shader_manager_,
+                       RenderGraph&         render_graph_,
+                       ResolutionScaler&    resolution_scaler_,
+                       ProgressiveRenderer& progressive_renderer_,
+                       FrameExporter&       frame_exporter_,
+                       FramePacer&          frame_pacer_,
+                       LatencyTracker&      latency_tracker_,
+                       const FrameStats&    frame_stats_,
+                       FrameProfiler&       frame_profiler_) noexcept;
     ~UIManager() noexcept;
 
     /**
@@ -35,13 +53,69 @@ private:
 
     void DrawSavePopup() noexcept;
 
+    /**
+     * @brief Draws the frame time statistics of the interval and of the sliding window
+     */
+    void DrawFrameStats() noexcept;
+
+    /**
+     * @brief Draws the resolution scale settings and the scale the shader is drawn at
+     */
+    void DrawResolutionScale() noexcept;
+
+    /**
+     * @brief Draws the tiled rendering and accumulation settings and their progress
+     */
+    void DrawProgressive() noexcept;
+
+    /**
+     * @brief Draws the frame pacing mode and the frame times and input latencies of every mode
+     */
+    void DrawFramePacing() noexcept;
+
+    /**
+     * @brief Draws the switch of the input latency instrumentation and the latency percentiles
+     */
+    void DrawInputLatency() noexcept;
+
+    /**
+     * @brief Draws the settings of the frame export, starts it and shows its progress
+     */
+    void DrawExport() noexcept;
+
+    /**
+     * @brief Draws the overlay with the per-stage CPU and GPU times and their rolling graphs
+     */
+    void DrawFrameTimingOverlay() noexcept;
+
+    /**
+     * @brief Draws the slider which scrubs through the compiled revisions of the fragment shader
+     */
+    void DrawHistory() noexcept;
+
+    /**
+     * @brief Draws the editors of the Buffer A to D passes and the work of the render graph
+     */
+    void DrawBuffers() noexcept;
+
 private:
-    GLFWwindow*    window;
-    ShaderManager& shader_manager;
+    GLFWwindow*          window;
+    ShaderManager&       shader_manager;
+    RenderGraph&         render_graph;
+    ResolutionScaler&    resolution_scaler;
+    ProgressiveRenderer& progressive_renderer;
+    FrameExporter&       frame_exporter;
+    FramePacer&          frame_pacer;
+    LatencyTracker&      latency_tracker;
+    const FrameStats&    frame_stats;
+    FrameProfiler&       frame_profiler;
+    ShaderLibrary        saved_shaders;   /**< Index of shaders/saved, for the Saved Shaders tab */
+    FrameExportSettings  export_settings; /**< Edited in the Export tab */
 
     static bool is_ui_visible;
 
     // Helpers
-    ImVec4 text_color      = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
-    bool   show_save_popup = false;
+    ImVec4 text_color       = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+    bool   show_save_popup  = false;
+    int    history_revision = -1; /**< Revision shown by the history slider, -1 for the newest */
 };
@@ -1,153 +1,317 @@
 #include "Utils.h"
 
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 std::string_view FileUtils::application_path = {};
 
-std::string ReadTextFromFile(std::string_view file_path_) noexcept
-{
-    std::string text;
+namespace {
 
-    auto full_path = GetApplicationPath() + "/" + std::string(file_path_);
+constexpr size_t READ_BLOCK_SIZE = 64 * 1024; /**< Read size of the files of unknown size */
 
-    if (full_path.empty())
+/**
+ * @brief Writes the text into a new file and flushes it to the disk
+ *
+ * @param file_path_ File which is created or truncated
+ * @param original_path_ File whose permissions the new one gets if it exists
+ * @param text_ Text to write
+ */
+bool WriteFileDurably(const std::string& file_path_,
+                      const std::string& original_path_,
+                      std::string_view   text_) noexcept
+{
+#if defined(_WIN32)
+    (void)original_path_;
+
+    const HANDLE file = CreateFileW(std::filesystem::path(file_path_).c_str(),
+                                    GENERIC_WRITE,
+                                    0,
+                                    nullptr,
+                                    CREATE_ALWAYS,
+                                    FILE_ATTRIBUTE_NORMAL,
+                                    nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+
+    bool is_good = true;
+    for (size_t offset = 0; is_good && offset < text_.size();)
     {
-        LOG_ERROR("File path is empty");
-        return text;
+        const auto chunk   = static_cast<DWORD>(std::min<size_t>(text_.size() - offset, 1 << 30));
+        DWORD      written = 0;
+        is_good = WriteFile(file, text_.data() + offset, chunk, &written, nullptr) && written > 0;
+        offset += written;
     }
 
-    // Creating an input file stream
-    std::ifstream in_file(full_path.data(), std::ios::in | std::ios::binary);
+    is_good = is_good && FlushFileBuffers(file);
+    return CloseHandle(file) && is_good;
+#elif defined(__unix__) || defined(__APPLE__)
+    struct stat original_stat {};
+    const mode_t mode =
+        stat(original_path_.c_str(), &original_stat) == 0 ? original_stat.st_mode & 07777 : 0644;
+
+    const int file = open(file_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    if (file < 0) { return false; }
 
-    // Check if the file is opened or exists
-    if (!in_file)
+    bool is_good = fchmod(file, mode) == 0;  // The umask does not apply to the original mode
+    for (size_t offset = 0; is_good && offset < text_.size();)
     {
-        LOG_ERROR("Failed to open file: {}", full_path);
-        return text;
+        const ssize_t written = write(file, text_.data() + offset, text_.size() - offset);
+        if (written < 0 && errno == EINTR) { continue; }
+
+        is_good = written > 0;
+        offset += is_good ? static_cast<size_t>(written) : 0;
     }
 
+    is_good = is_good && fsync(file) == 0;
+    return close(file) == 0 && is_good;
+#else
+    (void)original_path_;
 
-    // Read file content directly into the text string
-    text.assign((std::istreambuf_iterator<char>(in_file)), std::istreambuf_iterator<char>());
+    std::ofstream out_file(file_path_, std::ios::out | std::ios::binary | std::ios::trunc);
+    out_file.write(text_.data(), static_cast<std::streamsize>(text_.size()));
+    out_file.flush();
+    return out_file.good();
+#endif
+}
 
-    // Check if the reading was successful
-    if (!in_file.good() && !in_file.eof())
+/**
+ * @brief Atomically replaces the file with the other one, readers see either the old or the new
+ * content
+ */
+bool RenameOverFile(const std::string& source_path_, const std::string& target_path_) noexcept
+{
+#if defined(_WIN32)
+    return MoveFileExW(std::filesystem::path(source_path_).c_str(),
+                       std::filesystem::path(target_path_).c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#elif defined(__unix__) || defined(__APPLE__)
+    if (rename(source_path_.c_str(), target_path_.c_str()) != 0) { return false; }
+
+    // The rename itself is durable only once the directory entry is on the disk
+    const auto directory = std::filesystem::path(target_path_).parent_path().string();
+    const int  file      = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (file >= 0)
     {
-        LOG_ERROR("Error reading the file: {}", full_path);
-        return "";  // Return empty string in case of an error
+        fsync(file);
+        close(file);
     }
+    return true;
+#else
+    std::error_code error;
+    std::filesystem::rename(source_path_, target_path_, error);
+    return !error;
+#endif
+}
+
+}  // namespace
 
-    return text;
+FileView::FileView(std::string_view file_path_, FileViewMode mode_) noexcept
+{
+    const auto full_path = GetApplicationPath() + "/" + std::string(file_path_);
+
+    is_open = Map(full_path, mode_) || Read(full_path);
 }
 
-std::string CreateTemporaryCopyOfFile(std::string_view file_path_) noexcept
+FileView::~FileView() { Unmap(); }
+
+FileView::FileView(FileView&& other_) noexcept :
+    mapped_data(std::exchange(other_.mapped_data, nullptr)),
+    mapped_size(std::exchange(other_.mapped_size, 0)),
+    buffer(std::move(other_.buffer)),
+    is_open(std::exchange(other_.is_open, false))
 {
+}
 
-    if (file_path_.empty())
+FileView& FileView::operator= (FileView&& other_) noexcept
+{
+    if (this != &other_)
     {
-        LOG_ERROR("File path is empty");
-        return "";
+        Unmap();
+        mapped_data = std::exchange(other_.mapped_data, nullptr);
+        mapped_size = std::exchange(other_.mapped_size, 0);
+        buffer      = std::move(other_.buffer);
+        is_open     = std::exchange(other_.is_open, false);
     }
+    return *this;
+}
 
-    if (!std::filesystem::exists(file_path_)) { return ""; }
+bool FileView::Map(const std::string& full_path_, FileViewMode mode_) noexcept
+{
+    if (mode_ == FileViewMode::READ) { return false; }
 
-    std::string temp_file_path = std::string(file_path_) + ".tmp";
+    // Only regular files have a size which can be trusted, empty files can not be mapped
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(full_path_, error)) { return false; }
 
-    try  // Trying to create a temporary copy of the file
+    const auto size = std::filesystem::file_size(full_path_, error);
+    if (error || size == 0 || (mode_ == FileViewMode::AUTO && size < MAP_THRESHOLD))
     {
-        std::filesystem::copy(file_path_,
-                              temp_file_path,
-                              std::filesystem::copy_options::overwrite_existing);
+        return false;
     }
-    catch (const std::exception& e)
+
+#if defined(_WIN32)
+    const HANDLE file = CreateFileW(std::filesystem::path(full_path_).c_str(),
+                                    GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr,
+                                    OPEN_EXISTING,
+                                    FILE_FLAG_SEQUENTIAL_SCAN,
+                                    nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER file_size {};
+    const HANDLE  mapping = GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0
+                              ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+                              : nullptr;
+    CloseHandle(file);
+    if (!mapping) { return false; }
+
+    // The view keeps the mapping alive, the handle is not needed anymore
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) { return false; }
+
+    mapped_data = static_cast<const char*>(data);
+    mapped_size = static_cast<size_t>(file_size.QuadPart);
+    return true;
+#elif defined(__unix__) || defined(__APPLE__)
+    const int file = open(full_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) { return false; }
+
+    // The size is checked again on the open file, it may have changed since the check above
+    struct stat file_stat {};
+    void*       data = MAP_FAILED;
+    if (fstat(file, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0)
     {
-        LOG_ERROR("Failed to create a temporary copy of the file: {}", e.what());
-        return "";
+        const auto length = static_cast<size_t>(file_stat.st_size);
+        data              = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
     }
+    close(file);
+    if (data == MAP_FAILED) { return false; }
 
-    return temp_file_path;
+    madvise(data, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+
+    mapped_data = static_cast<const char*>(data);
+    mapped_size = static_cast<size_t>(file_stat.st_size);
+    return true;
+#else
+    return false;
+#endif
 }
 
-bool WriteTextToFile(std::string_view file_path_, std::string_view text_) noexcept
+bool FileView::Read(const std::string& full_path_) noexcept
 {
+    std::FILE* file = std::fopen(full_path_.c_str(), "rb");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open file: {}", full_path_);
+        return false;
+    }
 
-    auto full_path = GetApplicationPath() + "/" + std::string(file_path_);
+    std::setvbuf(file, nullptr, _IONBF, 0);  // Reads go straight into the buffer
 
-    if (full_path.empty())
+    // Regular files are read with one call, pipes and special files block by block until the end
+    std::error_code error;
+    const auto      size = std::filesystem::file_size(full_path_, error);
+
+    size_t length = 0;
+    buffer.resize(error ? READ_BLOCK_SIZE : static_cast<size_t>(size) + 1);
+
+    while (true)
     {
-        LOG_ERROR("File path is empty");
-        return false;
+        length += std::fread(buffer.data() + length, 1, buffer.size() - length, file);
+        if (length < buffer.size()) { break; }
+
+        buffer.resize(buffer.size() + READ_BLOCK_SIZE);
     }
 
-    if (text_.empty())
+    const bool is_good = !std::ferror(file);
+    std::fclose(file);
+
+    if (!is_good)
     {
-        LOG_ERROR("Text is empty");
+        LOG_ERROR("Error reading the file: {}", full_path_);
+        buffer.clear();
         return false;
     }
 
-    // Creating a temporary copy of the file
-    auto temporary_copy = CreateTemporaryCopyOfFile(full_path);
+    buffer.resize(length);
+    return true;
+}
 
-    std::filesystem::path dir = std::filesystem::path(full_path).parent_path();
+void FileView::Unmap() noexcept
+{
+    if (!mapped_data) { return; }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mapped_data);
+#elif defined(__unix__) || defined(__APPLE__)
+    munmap(const_cast<char*>(mapped_data), mapped_size);
+#endif
 
-    if (!std::filesystem::exists(dir))
+    mapped_data = nullptr;
+    mapped_size = 0;
+}
+
+std::string ReadTextFromFile(std::string_view file_path_) noexcept
+{
+    if (file_path_.empty())
     {
-        try
-        {
-            std::filesystem::create_directories(dir);  // Create the directory
-        }
-        catch (const std::filesystem::filesystem_error& e)
-        {
-            LOG_ERROR("Failed to create directory: {}", e.what());
-            return "";
-        }
+        LOG_ERROR("File path is empty");
+        return "";
     }
 
-    // Creating an output file stream
-    std::ofstream out_file(full_path.data(), std::ios::out | std::ios::binary | std::ios::trunc);
+    const FileView file(file_path_);
+    return std::string(file.GetText());
+}
+
+bool WriteTextToFile(std::string_view file_path_, std::string_view text_) noexcept
+{
+    auto full_path = GetApplicationPath() + "/" + std::string(file_path_);
 
-    // Check if the file is opened
-    if (!out_file)
+    if (file_path_.empty())
     {
-        LOG_ERROR("Failed to open file: {}", full_path);
+        LOG_ERROR("File path is empty");
         return false;
     }
 
-    // Write the text to the file
-    out_file << text_;
+    if (text_.empty())
+    {
+        LOG_ERROR("Text is empty");
+        return false;
+    }
 
-    // Check if the writing was successful
-    if (!out_file.good())
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(full_path).parent_path(), error);
+    if (error)
     {
-        LOG_ERROR("Error writing to the file: {}", full_path);
-        // Returning temporary copy of the file if we have one
-        if (!temporary_copy.empty())
-        {
-            try  // Trying to restore the temporary copy of the file
-            {
-                std::filesystem::copy(temporary_copy,
-                                      full_path,
-                                      std::filesystem::copy_options::overwrite_existing);
-                std::filesystem::remove(temporary_copy);
-            }
-            catch (const std::exception& e)
-            {
-                LOG_ERROR("Failed to restore the temporary copy of the file: {}", e.what());
-            }
-        }
+        LOG_ERROR("Failed to create directory for {}: {}", full_path, error.message());
         return false;
     }
 
-    // If we have a temporary copy, we remove it
-    if (!temporary_copy.empty())
+    // The old file stays untouched until the new one is complete on the disk, a crash leaves
+    // either of them but never a truncated file
+    const auto temporary_path = full_path + ".tmp";
+
+    if (!WriteFileDurably(temporary_path, full_path, text_))
     {
-        try  // Trying to remove the temporary copy of the file
-        {
-            std::filesystem::remove(temporary_copy);
-        }
-        catch (const std::exception& e)
-        {
-            LOG_ERROR("Failed to remove the temporary copy of the file: {}", e.what());
-            return false;
-        }
+        LOG_ERROR("Error writing to the file: {}", temporary_path);
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+
+    if (!RenameOverFile(temporary_path, full_path))
+    {
+        LOG_ERROR("Failed to replace {} with {}", full_path, temporary_path);
+        std::filesystem::remove(temporary_path, error);
+        return false;
     }
 
     return true;
@@ -179,48 +343,33 @@ std::vector<std::string> GetFilesInDirectory(std::string_view root_directory_pat
 
 std::string GetApplicationPath()
 {
-    std::filesystem::path exe_path =
-        std::filesystem::canonical(FileUtils::application_path).parent_path();
-    std::string path = exe_path.string();
-    std::replace(path.begin(), path.end(), '\\', '/');
+    // Resolving the path touches the file system, it is done once and not on every file access
+    static const std::string path = []
+    {
+        std::filesystem::path exe_path =
+            std::filesystem::canonical(FileUtils::application_path).parent_path();
+        std::string result = exe_path.string();
+        std::replace(result.begin(), result.end(), '\\', '/');
+        return result;
+    }();
+
     return path;
 }
 
-std::string LoadTextFromFile(std::string_view file_path_) noexcept
+uint64_t HashText(std::string_view text_, uint64_t seed_) noexcept
 {
-    auto full_path = GetApplicationPath() + "/" + std::string(file_path_);
-
-    if (full_path.empty())
-    {
-        LOG_ERROR("File path is empty");
-        return "";
-    }
+    uint64_t hash = seed_;
 
-    if (!std::filesystem::exists(full_path))
+    for (const char c : text_)
     {
-        LOG_ERROR("File does not exist: {}", full_path);
-        return "";
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;  // FNV-1a 64-bit prime
     }
 
-    // Creating an input file stream
-    std::ifstream in_file(full_path.data(), std::ios::in | std::ios::binary);
-
-    // Check if the file is opened
-    if (!in_file)
-    {
-        LOG_ERROR("Failed to open file: {}", full_path);
-        return "";
-    }
-
-    // Read file content directly into a string
-    std::string text((std::istreambuf_iterator<char>(in_file)), std::istreambuf_iterator<char>());
-
-    // Check if the reading was successful
-    if (!in_file.good() && !in_file.eof())
-    {
-        LOG_ERROR("Error reading the file: {}", full_path);
-        return "";
-    }
+    return hash;
+}
 
-    return text;
-}
\ No newline at end of file
+uint64_t HashCombine(uint64_t hash_, uint64_t other_) noexcept
+{
+    return hash_ ^ (other_ + 0x9e3779b97f4a7c15ull + (hash_ << 6) + (hash_ >> 2));
+}
@@ -8,45 +8,93 @@ struct FileUtils {
 };
 
 /**
- * @brief Function which read text from a file
- *
- * @param file_path_ Path to the file
- *
- * @return Source code of the shader or empty string in case of an error
+ * @brief How FileView gets the content of the file
  */
-std::string ReadTextFromFile(std::string_view file_path_) noexcept;
+enum class FileViewMode {
+    AUTO, /**< Maps regular files from FileView::MAP_THRESHOLD bytes, reads the others */
+    MAP,  /**< Maps regular files of any size, reads pipes and special files */
+    READ  /**< Always reads the file into a buffer */
+};
 
 /**
- * @brief Function which creates temporary copy of the file
- *
- * @param file_path_ Path to the file
+ * @brief Read-only view of the whole content of a file, without copying it into a string
  *
- * @return file_path_ + ".tmp" extension or empty string in case of an error
+ * @remark Large regular files are memory-mapped, small ones and pipes, devices or files of
+ * unknown size are read into an owned buffer with a few large reads. The view should be short
+ * lived, a mapped file truncated by another program while it is viewed can fault on access.
  */
+struct FileView {
+    static constexpr size_t MAP_THRESHOLD = 64 * 1024; /**< Smaller files are cheaper to read */
+
+    /**
+     * @param file_path_ Path to the file, relative to the application directory
+     * @param mode_ How the content is accessed, see FileViewMode
+     */
+    explicit FileView(std::string_view file_path_,
+                      FileViewMode     mode_ = FileViewMode::AUTO) noexcept;
+    ~FileView();
+
+    FileView(FileView&& other_) noexcept;
+    FileView& operator= (FileView&& other_) noexcept;
+
+    FileView(const FileView&)             = delete;
+    FileView& operator= (const FileView&) = delete;
 
-std::string CreateTemporaryCopyOfFile(std::string_view file_path_) noexcept;
+    /**
+     * @brief Returns true if the file was opened and read, an empty file is open too
+     */
+    bool IsOpen() const noexcept { return is_open; }
+
+    /**
+     * @brief Returns true if the content is memory-mapped instead of read into a buffer
+     */
+    bool IsMapped() const noexcept { return mapped_data != nullptr; }
+
+    /**
+     * @brief Returns the content of the file, valid as long as the view exists
+     */
+    std::string_view GetText() const noexcept
+    {
+        return mapped_data ? std::string_view(mapped_data, mapped_size) : std::string_view(buffer);
+    }
+
+private:
+
+    bool Map(const std::string& full_path_, FileViewMode mode_) noexcept;
+    bool Read(const std::string& full_path_) noexcept;
+    void Unmap() noexcept;
+
+private:
+    const char* mapped_data = nullptr; /**< Start of the mapping, null if the file was read */
+    size_t      mapped_size = 0;
+    std::string buffer;                /**< Content of the file if it is not mapped */
+    bool        is_open     = false;
+};
 
 /**
- * @brief Function which write text to a file
+ * @brief Function which read text from a file
  *
- * @param file_name_ Name of the file
- * @param file_path_ Path to the file
- * @param text_ Text to write to the file
+ * @param file_path_ Path to the file, relative to the application directory
  *
- * @remark If the file already exists, it will be overwritten
+ * @return Source code of the shader or empty string in case of an error
  *
- * @return true if the file was written successfully, false otherwise
+ * @remark Use FileView directly if the text does not need to outlive the call
  */
-bool WriteTextToFile(std::string_view file_path_, std::string_view text_) noexcept;
+std::string ReadTextFromFile(std::string_view file_path_) noexcept;
 
 /**
- * @brief Function which loads text from a file
+ * @brief Function which write text to a file
+ *
+ * @param file_path_ Path to the file, relative to the application directory
+ * @param text_ Text to write to the file
  *
- * @param file_path_ Path to the file
+ * @remark If the file already exists, it will be overwritten. The text is written to a temporary
+ * file which is flushed to the disk and renamed over the file, so a crash never leaves a partly
+ * written file. Blocks until the disk confirms the write, use AsyncFileWriter on the render thread
  *
- * @return Text content of the file or an empty string in case of an error
+ * @return true if the file was written successfully, false otherwise
  */
-std::string LoadTextFromFile(std::string_view file_path_) noexcept;
+bool WriteTextToFile(std::string_view file_path_, std::string_view text_) noexcept;
 
 /**
  * @brief Function which returns the files in the directory with the specified extension
@@ -62,6 +110,29 @@ std::vector<std::string> GetFilesInDirectory(std::string_view root_directory_pat
 /**
  * @brief Function which returns the path to the application
  *
+ * @remark The path is resolved on the first call, FileUtils::application_path must be set before
+ *
  * @return Path to the application
  */
 [[nodiscard]] std::string GetApplicationPath();
+
+/**
+ * @brief Function which calculates a fast non-cryptographic hash (64-bit FNV-1a) of the text
+ *
+ * @param text_ Text to hash
+ * @param seed_ Previous hash value, allows to chain several texts into one hash
+ *
+ * @return Hash of the text
+ */
+[[nodiscard]] uint64_t HashText(std::string_view text_,
+                                uint64_t         seed_ = 0xcbf29ce484222325ull) noexcept;
+
+/**
+ * @brief Function which combines two hashes into one
+ *
+ * @param hash_ First hash
+ * @param other_ Second hash
+ *
+ * @return Combined hash, depends on the order of the arguments
+ */
+[[nodiscard]] uint64_t HashCombine(uint64_t hash_, uint64_t other_) noexcept;